@@ -7,6 +7,8 @@ SET(GFXLIB_HDRS
    ${GFXLIB_DIR}/gfx.h
    ${GFXLIB_DIR}/math2d.h
    ${GFXLIB_DIR}/scrollarea.h
+   ${GFXLIB_DIR}/framedelta.h
+   ${GFXLIB_DIR}/ansiterm.h
    ${GFXLIB_DIR}/gridfont.h
    ${GFXLIB_DIR}/gridarea.h
    ${GFXLIB_DIR}/gridmenu.h
@@ -15,11 +17,14 @@ SET(GFXLIB_HDRS
    ${GFXLIB_DIR}/joystick.h
    ${GFXLIB_DIR}/mouse.h
    ${GFXLIB_DIR}/util.h
+   ${GFXLIB_DIR}/profiler.h
    )
 SET(GFXLIB_SRCS
    ${GFXLIB_DIR}/gfx.cpp
    ${GFXLIB_DIR}/math2d.cpp
    ${GFXLIB_DIR}/scrollarea.cpp
+   ${GFXLIB_DIR}/framedelta.cpp
+   ${GFXLIB_DIR}/ansiterm.cpp
    ${GFXLIB_DIR}/gridfont.cpp
    ${GFXLIB_DIR}/gridarea.cpp
    ${GFXLIB_DIR}/gridmenu.cpp
@@ -28,6 +33,23 @@ SET(GFXLIB_SRCS
    ${GFXLIB_DIR}/joystick.cpp
    ${GFXLIB_DIR}/mouse.cpp
    ${GFXLIB_DIR}/util.cpp
+   ${GFXLIB_DIR}/profiler.cpp
    )
 INCLUDE_DIRECTORIES(${GFXLIB_DIR})
 ADD_LIBRARY(${GFXLIB_NAME} ${GFXLIB_SRCS} ${GFXLIB_HDRS})
+
+# ASCII GFX micro benchmarks against a headless screen
+ADD_EXECUTABLE(gfx_bench ${GFXLIB_DIR}/gfx_bench.cpp)
+TARGET_LINK_LIBRARIES(gfx_bench
+   ${GFXLIB_NAME} # link with ascii gfx lib
+   ${CURSES_LIBRARIES} # link with NCurses
+   )
+
+# ASCII GFX test of the ANSI encoder against NCurses
+ADD_EXECUTABLE(ansiterm_test ${GFXLIB_DIR}/ansiterm_test.cpp)
+TARGET_LINK_LIBRARIES(ansiterm_test
+   ${GFXLIB_NAME} # link with ascii gfx lib
+   ${CURSES_LIBRARIES} # link with NCurses
+   )
+ENABLE_TESTING()
+ADD_TEST(NAME ansiterm COMMAND ansiterm_test)
@@ -0,0 +1,887 @@
+// Sink Ships computer opponent
+
+#include "ai.h"
+#include "sampler.h"
+#include "solver.h"
+
+// cell flags of large boards
+enum
+{
+    GRID_SHOT = 1,   // the cell was shot
+    GRID_HIT = 2,    // the cell is a damaged cell of a ship that is not sunk yet
+    GRID_BLOCKED = 4 // the cell cannot be covered by a remaining ship
+};
+
+static void grid_init(Ai *a);
+
+// initialize the opponent
+void ai_init(Ai *a, const FleetGen *gen, int mode, uint64_t seed, uint64_t stream)
+{
+    a->mode = mode;
+    a->gen = gen;
+    a->pool = NULL;
+    a->budget = 5;
+    a->solver = NULL;
+    rnd_seed(&a->random, seed, stream);
+
+    for (int k = 0; k < gen->lists; k++)
+    {
+        a->remaining[k] = 0;
+        for (int i = 0; i < gen->fleet.count; i++)
+            if (gen->list[i] == k)
+                a->remaining[k]++;
+    }
+
+    a->cell = NULL;
+    a->tree_max = NULL;
+    a->tree_ties = NULL;
+    a->unshot = NULL;
+    a->unshot_pos = NULL;
+    a->hits = NULL;
+    a->score = NULL;
+    a->touched = NULL;
+
+    if (!gen->placements)
+    {
+        grid_init(a);
+        return;
+    }
+
+    a->shot_bits = bits128();
+    a->hit_bits = bits128();
+    a->sunk_bits = bits128();
+    a->blocked_bits = bits128();
+
+    for (int c = 0; c < bitboard_size * bitboard_size; c++)
+        a->heat[c] = 0;
+
+    for (int k = 0; k < gen->lists; k++)
+    {
+        const PlacementList *l = &gen->placements[k];
+
+        a->valid[k] = l->all;
+
+        for (int c = 0; c < bitboard_size * bitboard_size; c++)
+        {
+            a->count[k][c] = pset_count(&l->cover[c]);
+            a->heat[c] += a->remaining[k] * a->count[k][c];
+        }
+    }
+}
+
+// release the cell state of the opponent
+void ai_free(Ai *a)
+{
+    delete[] a->cell;
+    delete[] a->tree_max;
+    delete[] a->tree_ties;
+    delete[] a->unshot;
+    delete[] a->unshot_pos;
+    delete[] a->hits;
+    delete[] a->score;
+    delete[] a->touched;
+
+    a->cell = NULL;
+    a->tree_max = NULL;
+    a->tree_ties = NULL;
+    a->unshot = NULL;
+    a->unshot_pos = NULL;
+    a->hits = NULL;
+    a->score = NULL;
+    a->touched = NULL;
+}
+
+// configure the Monte Carlo mode
+void ai_set_sampler(Ai *a, ThreadPool *pool, float budget)
+{
+    a->pool = pool;
+    a->budget = budget;
+}
+
+// configure the endgame solver
+void ai_set_solver(Ai *a, Solver *solver)
+{
+    a->solver = solver;
+}
+
+// helper for blocking a cell that cannot be covered by a remaining ship
+// * all valid placements covering the cell are invalidated
+static void block_cell(Ai *a, int y, int x)
+{
+    int size = a->gen->size;
+    if (y < 0 || x < 0 || y >= size || x >= size)
+        return;
+
+    int c = bits_index(y, x);
+    if (bits_test(a->blocked_bits, c))
+        return;
+
+    a->blocked_bits = bits_or(a->blocked_bits, bits_bit(c));
+
+    for (int k = 0; k < a->gen->lists; k++)
+    {
+        const PlacementList *l = &a->gen->placements[k];
+
+        for (int w = 0; w < placement_words; w++)
+        {
+            uint64_t bits = a->valid[k].w[w] & l->cover[c].w[w];
+            a->valid[k].w[w] &= ~bits;
+
+            while (bits)
+            {
+                int p = (w << 6) + __builtin_ctzll(bits);
+                bits &= bits - 1;
+
+                // remove the invalidated placement from the heat map
+                Bits128 cells = l->ref[p].mask->ship;
+                while (!bits_empty(cells))
+                {
+                    int d = bits_pop(&cells);
+
+                    a->count[k][d]--;
+                    a->heat[d] -= a->remaining[k];
+                }
+            }
+        }
+    }
+}
+
+// helper for removing a sunk ship of a specific length from the remaining fleet
+static void remove_ship(Ai *a, int length)
+{
+    for (int k = 0; k < a->gen->lists; k++)
+        if (a->gen->length[k] == length && a->remaining[k] > 0)
+        {
+            a->remaining[k]--;
+
+            for (int c = 0; c < bitboard_size * bitboard_size; c++)
+                a->heat[c] -= a->count[k][c];
+
+            return;
+        }
+}
+
+// helper for checking a damaged cell of a ship that is not sunk yet
+static bool is_hit(const Ai *a, int y, int x)
+{
+    int size = a->gen->size;
+    if (y < 0 || x < 0 || y >= size || x >= size)
+        return false;
+
+    return bits_test(a->hit_bits, bits_index(y, x));
+}
+
+// helper for getting the largest ship size of the opponent fleet
+static int grid_reach(const Ai *a)
+{
+    // the fleet of the generator is sorted by descending ship size
+    return a->gen->fleet.count > 0 ? a->gen->fleet.size[0] - 1 : 0;
+}
+
+// helper for updating the max tree node i from its children
+static void tree_pull(Ai *a, int i)
+{
+    int l = 2 * i, r = 2 * i + 1;
+
+    if (a->tree_max[l] > a->tree_max[r])
+    {
+        a->tree_max[i] = a->tree_max[l];
+        a->tree_ties[i] = a->tree_ties[l];
+    }
+    else if (a->tree_max[l] < a->tree_max[r])
+    {
+        a->tree_max[i] = a->tree_max[r];
+        a->tree_ties[i] = a->tree_ties[r];
+    }
+    else
+    {
+        a->tree_max[i] = a->tree_max[l];
+        a->tree_ties[i] = a->tree_ties[l] + a->tree_ties[r];
+    }
+}
+
+// helper for setting the heat of cell c in the max tree
+static void tree_set(Ai *a, int c, int heat)
+{
+    int i = a->leaves + c;
+    a->tree_max[i] = heat;
+
+    for (i >>= 1; i > 0; i >>= 1)
+        tree_pull(a, i);
+}
+
+// helper for counting the starts in [s1, s2] of placements of length n covering position d of a line
+static int covering(int s1, int s2, int n, int d)
+{
+    if (d - n + 1 > s1)
+        s1 = d - n + 1;
+    if (d < s2)
+        s2 = d;
+
+    return s2 >= s1 ? s2 - s1 + 1 : 0;
+}
+
+// helper for adding the heat of the placements within a free run [lo, hi] of a line
+// * a line is given by the index of its first cell and the stride between its cells
+// * ships of length 1 are only counted along rows
+static void add_run(Ai *a, int first, int stride, int lo, int hi, bool column)
+{
+    const FleetGen *g = a->gen;
+
+    for (int k = 0; k < g->lists; k++)
+    {
+        int n = g->length[k];
+        if (a->weight[k] == 0 || (column && n == 1) || hi - lo + 1 < n)
+            continue;
+
+        for (int d = lo; d <= hi; d++)
+        {
+            int c = first + d * stride;
+            if (!(a->cell[c] & GRID_SHOT))
+                a->tree_max[a->leaves + c] += a->weight[k] * covering(lo, hi - n + 1, n, d);
+        }
+    }
+}
+
+// helper for adding the heat of all free runs of a line
+static void add_line(Ai *a, int first, int stride, bool column)
+{
+    int size = a->gen->size;
+
+    for (int lo = 0; lo < size; lo++)
+    {
+        if (a->cell[first + lo * stride] & GRID_BLOCKED)
+            continue;
+
+        int hi = lo;
+        while (hi + 1 < size && !(a->cell[first + (hi + 1) * stride] & GRID_BLOCKED))
+            hi++;
+
+        add_run(a, first, stride, lo, hi, column);
+        lo = hi;
+    }
+}
+
+// helper for recomputing the whole heat map
+// * only needed when all ships of a size are sunk, so at most once per ship size
+static void grid_rebuild(Ai *a)
+{
+    int size = a->gen->size;
+
+    for (int c = 0; c < a->leaves; c++)
+    {
+        a->tree_max[a->leaves + c] = c < size * size && !(a->cell[c] & GRID_SHOT) ? 0 : -1;
+        a->tree_ties[a->leaves + c] = 1;
+    }
+
+    for (int i = 0; i < size; i++)
+    {
+        add_line(a, i * size, 1, false);
+        add_line(a, i, size, true);
+    }
+
+    for (int i = a->leaves - 1; i > 0; i--)
+        tree_pull(a, i);
+}
+
+// helper for initializing the cell state of a large board
+static void grid_init(Ai *a)
+{
+    const FleetGen *g = a->gen;
+    int cells = g->size * g->size;
+
+    a->leaves = 1;
+    while (a->leaves < cells)
+        a->leaves *= 2;
+
+    a->cell = new unsigned char[cells];
+    a->tree_max = new int[2 * a->leaves];
+    a->tree_ties = new int[2 * a->leaves];
+    a->unshot = new int[cells];
+    a->unshot_pos = new int[cells];
+    a->hits = new int[fleet_cells(&g->fleet) + 1];
+    a->score = new int[cells];
+    a->touched = new int[cells];
+
+    for (int c = 0; c < cells; c++)
+    {
+        a->cell[c] = 0;
+        a->unshot[c] = c;
+        a->unshot_pos[c] = c;
+        a->score[c] = 0;
+    }
+
+    a->unshots = cells;
+    a->hit_count = 0;
+
+    for (int k = 0; k < g->lists; k++)
+        a->weight[k] = a->remaining[k];
+
+    grid_rebuild(a);
+}
+
+// helper for removing the heat of the placements covering position p of a line
+// * only the cells within one ship length of p are affected
+static void block_line(Ai *a, int first, int stride, int p, bool column)
+{
+    const FleetGen *g = a->gen;
+    int size = g->size;
+    int reach = grid_reach(a);
+
+    // the free run around p, as far as it matters
+    int lo = p, hi = p;
+    while (lo > 0 && p - lo < reach && !(a->cell[first + (lo - 1) * stride] & GRID_BLOCKED))
+        lo--;
+    while (hi < size - 1 && hi - p < reach && !(a->cell[first + (hi + 1) * stride] & GRID_BLOCKED))
+        hi++;
+
+    for (int d = lo; d <= hi; d++)
+    {
+        int c = first + d * stride;
+        if (a->cell[c] & GRID_SHOT)
+            continue;
+
+        int delta = 0;
+        for (int k = 0; k < g->lists; k++)
+        {
+            int n = g->length[k];
+            if (a->weight[k] == 0 || (column && n == 1))
+                continue;
+
+            // the placements of the run that cover p
+            int s1 = p - n + 1 > lo ? p - n + 1 : lo;
+            int s2 = p < hi - n + 1 ? p : hi - n + 1;
+
+            delta += a->weight[k] * covering(s1, s2, n, d);
+        }
+
+        if (delta)
+            tree_set(a, c, a->tree_max[a->leaves + c] - delta);
+    }
+}
+
+// helper for blocking a cell of a large board
+static void grid_block(Ai *a, int y, int x, bool update)
+{
+    int size = a->gen->size;
+    if (y < 0 || x < 0 || y >= size || x >= size)
+        return;
+
+    int c = y * size + x;
+    if (a->cell[c] & GRID_BLOCKED)
+        return;
+
+    if (update)
+    {
+        block_line(a, y * size, 1, x, false);
+        block_line(a, x, size, y, true);
+    }
+
+    a->cell[c] |= GRID_BLOCKED;
+}
+
+// helper for checking a damaged cell of a ship that is not sunk yet on a large board
+static bool grid_is_hit(const Ai *a, int y, int x)
+{
+    int size = a->gen->size;
+    if (y < 0 || x < 0 || y >= size || x >= size)
+        return false;
+
+    return a->cell[y * size + x] & GRID_HIT;
+}
+
+// helper for updating a large board with the result of a shot at position (y, x)
+static void grid_update(Ai *a, int y, int x, int result)
+{
+    int size = a->gen->size;
+    int c = y * size + x;
+
+    if (a->cell[c] & GRID_SHOT)
+        return;
+
+    a->cell[c] |= GRID_SHOT;
+    tree_set(a, c, -1);
+
+    // remove the cell from the unshot list
+    int last = a->unshot[--a->unshots];
+    a->unshot[a->unshot_pos[c]] = last;
+    a->unshot_pos[last] = a->unshot_pos[c];
+
+    switch (result)
+    {
+    case SHOT_MISS: // there is no ship
+        grid_block(a, y, x, true);
+        break;
+    case SHOT_HIT: // ships do not touch diagonally
+        a->cell[c] |= GRID_HIT;
+        a->hits[a->hit_count++] = c;
+        grid_block(a, y - 1, x - 1, true);
+        grid_block(a, y - 1, x + 1, true);
+        grid_block(a, y + 1, x - 1, true);
+        grid_block(a, y + 1, x + 1, true);
+        break;
+    case SHOT_SUNK: // the ship consists of the adjacent damaged cells in a line
+    {
+        a->cell[c] |= GRID_HIT;
+
+        int y1 = y, y2 = y, x1 = x, x2 = x;
+        while (grid_is_hit(a, y1 - 1, x))
+            y1--;
+        while (grid_is_hit(a, y2 + 1, x))
+            y2++;
+        if (y1 == y2)
+        {
+            while (grid_is_hit(a, y, x1 - 1))
+                x1--;
+            while (grid_is_hit(a, y, x2 + 1))
+                x2++;
+        }
+
+        // the heat map is rebuilt once all ships of this size are sunk
+        bool rebuild = false;
+        int length = (y2 - y1) + (x2 - x1) + 1;
+        for (int k = 0; k < a->gen->lists; k++)
+            if (a->gen->length[k] == length && a->remaining[k] > 0)
+            {
+                if (--a->remaining[k] == 0)
+                {
+                    a->weight[k] = 0;
+                    rebuild = true;
+                }
+                break;
+            }
+
+        // the ship and its surrounding cells cannot be covered by another ship
+        for (int i = y1 - 1; i <= y2 + 1; i++)
+            for (int j = x1 - 1; j <= x2 + 1; j++)
+            {
+                if (i >= y1 && i <= y2 && j >= x1 && j <= x2)
+                    a->cell[i * size + j] &= ~GRID_HIT;
+
+                grid_block(a, i, j, !rebuild);
+            }
+
+        // remove the damaged cells of the ship
+        int n = 0;
+        for (int i = 0; i < a->hit_count; i++)
+            if (a->cell[a->hits[i]] & GRID_HIT)
+                a->hits[n++] = a->hits[i];
+        a->hit_count = n;
+
+        if (rebuild)
+            grid_rebuild(a);
+
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+// helper for counting the damaged cells in [u, v] of a window [w1, w2] with prefix sums
+static int count_hits(const int *prefix, int w1, int w2, int u, int v)
+{
+    if (u < w1)
+        u = w1;
+    if (v > w2)
+        v = w2;
+
+    return v >= u ? prefix[v - w1 + 1] - prefix[u - w1] : 0;
+}
+
+// helper for scoring the placements through a damaged cell at position p of a line
+// * "across" is the index offset to the neighbouring lines, "line" the number of the line
+// * the placement counts of choose_target are evaluated with prefix sums of the damaged
+//   cells of the line and its neighbouring lines, so a line costs O(L) per placement list
+static void target_line(Ai *a, int first, int stride, int across, int line, int p, bool column)
+{
+    const FleetGen *g = a->gen;
+    int size = g->size;
+    int reach = grid_reach(a);
+
+    // the window of positions that may be covered by a placement or its halo
+    int w1 = p - reach - 1 > 0 ? p - reach - 1 : 0;
+    int w2 = p + reach + 1 < size - 1 ? p + reach + 1 : size - 1;
+
+    // prefix sums of the damaged cells of the previous line, the line and the next line
+    static const int window = 2 * board_max_size + 2;
+    int prefix[3][window];
+    int diff[window];
+
+    for (int j = 0; j < 3; j++)
+    {
+        int l = line + j - 1;
+
+        prefix[j][0] = 0;
+        for (int d = w1; d <= w2; d++)
+        {
+            bool hit = l >= 0 && l < size && (a->cell[first + (j - 1) * across + d * stride] & GRID_HIT);
+            prefix[j][d - w1 + 1] = prefix[j][d - w1] + hit;
+        }
+    }
+
+    for (int d = 0; d <= w2 - w1 + 1; d++)
+        diff[d] = 0;
+
+    // the free run around p
+    int lo = p, hi = p;
+    while (lo > 0 && p - lo < reach && !(a->cell[first + (lo - 1) * stride] & GRID_BLOCKED))
+        lo--;
+    while (hi < size - 1 && hi - p < reach && !(a->cell[first + (hi + 1) * stride] & GRID_BLOCKED))
+        hi++;
+
+    for (int k = 0; k < g->lists; k++)
+    {
+        int n = g->length[k];
+        if (a->remaining[k] == 0 || (column && n == 1))
+            continue;
+
+        int s1 = p - n + 1 > lo ? p - n + 1 : lo;
+        int s2 = p < hi - n + 1 ? p : hi - n + 1;
+
+        for (int s = s1; s <= s2; s++)
+        {
+            // count each placement once via its first damaged cell
+            if (count_hits(prefix[1], w1, w2, s, p - 1) > 0)
+                continue;
+
+            // a ship cannot touch damaged cells of another ship
+            int covered = count_hits(prefix[1], w1, w2, s, s + n - 1);
+            int halo = count_hits(prefix[0], w1, w2, s - 1, s + n) +
+                       count_hits(prefix[1], w1, w2, s - 1, s + n) +
+                       count_hits(prefix[2], w1, w2, s - 1, s + n);
+            if (halo > covered)
+                continue;
+
+            int weight = a->remaining[k] * covered * covered;
+            diff[s - w1] += weight;
+            diff[s + n - w1] -= weight;
+        }
+    }
+
+    int score = 0;
+    for (int d = w1; d <= w2; d++)
+    {
+        score += diff[d - w1];
+
+        int c = first + d * stride;
+        if (score > 0 && !(a->cell[c] & GRID_SHOT))
+        {
+            if (a->score[c] == 0)
+                a->touched[a->touches++] = c;
+            a->score[c] += score;
+        }
+    }
+}
+
+// update the opponent with the result of a shot at position (y, x)
+void ai_update(Ai *a, int y, int x, int result)
+{
+    if (result == SHOT_NONE)
+        return;
+
+    if (!a->gen->placements)
+    {
+        grid_update(a, y, x, result);
+        return;
+    }
+
+    a->shot_bits = bits_or(a->shot_bits, bits_bit(bits_index(y, x)));
+
+    switch (result)
+    {
+    case SHOT_MISS: // there is no ship
+        block_cell(a, y, x);
+        break;
+    case SHOT_HIT: // ships do not touch diagonally
+        a->hit_bits = bits_or(a->hit_bits, bits_bit(bits_index(y, x)));
+        block_cell(a, y - 1, x - 1);
+        block_cell(a, y - 1, x + 1);
+        block_cell(a, y + 1, x - 1);
+        block_cell(a, y + 1, x + 1);
+        break;
+    case SHOT_SUNK: // the ship consists of the adjacent damaged cells in a line
+    {
+        a->hit_bits = bits_or(a->hit_bits, bits_bit(bits_index(y, x)));
+
+        int y1 = y, y2 = y, x1 = x, x2 = x;
+        while (is_hit(a, y1 - 1, x))
+            y1--;
+        while (is_hit(a, y2 + 1, x))
+            y2++;
+        if (y1 == y2)
+        {
+            while (is_hit(a, y, x1 - 1))
+                x1--;
+            while (is_hit(a, y, x2 + 1))
+                x2++;
+        }
+
+        remove_ship(a, (y2 - y1) + (x2 - x1) + 1);
+
+        // the ship and its surrounding cells cannot be covered by another ship
+        for (int i = y1 - 1; i <= y2 + 1; i++)
+            for (int j = x1 - 1; j <= x2 + 1; j++)
+            {
+                if (i >= y1 && i <= y2 && j >= x1 && j <= x2)
+                {
+                    a->hit_bits = bits_andnot(a->hit_bits, bits_bit(bits_index(i, j)));
+                    a->sunk_bits = bits_or(a->sunk_bits, bits_bit(bits_index(i, j)));
+                }
+
+                block_cell(a, i, j);
+            }
+
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+// helper for choosing the best unshot cell of a score map
+// * ties are broken randomly
+static bool choose_best(Ai *a, const int *score, int *y, int *x)
+{
+    int size = a->gen->size;
+    int best = 0, ties = 0;
+
+    for (int i = 0; i < size; i++)
+        for (int j = 0; j < size; j++)
+        {
+            int c = bits_index(i, j);
+            if (bits_test(a->shot_bits, c))
+                continue;
+
+            if (score[c] > best)
+            {
+                best = score[c];
+                ties = 0;
+            }
+
+            if (score[c] == best && best > 0)
+                if (rnd_int(&a->random, ++ties) == 0)
+                {
+                    *y = i;
+                    *x = j;
+                }
+        }
+
+    return best > 0;
+}
+
+// helper for choosing a random unshot cell
+static bool choose_random(Ai *a, int *y, int *x)
+{
+    int size = a->gen->size;
+    int count = 0;
+
+    for (int i = 0; i < size; i++)
+        for (int j = 0; j < size; j++)
+            if (!bits_test(a->shot_bits, bits_index(i, j)))
+                if (rnd_int(&a->random, ++count) == 0)
+                {
+                    *y = i;
+                    *x = j;
+                }
+
+    return count > 0;
+}
+
+// helper for choosing a cell next to the damaged cells of ships that are not sunk yet
+// * the valid placements that explain the damaged cells are counted per cell
+// * placements explaining more damaged cells get a quadratically higher weight
+static bool choose_target(Ai *a, int *y, int *x)
+{
+    int score[bitboard_size * bitboard_size] = {0};
+
+    for (int k = 0; k < a->gen->lists; k++)
+    {
+        if (a->remaining[k] == 0)
+            continue;
+
+        const PlacementList *l = &a->gen->placements[k];
+
+        Bits128 hits = a->hit_bits;
+        while (!bits_empty(hits))
+        {
+            int c = bits_pop(&hits);
+
+            for (int w = 0; w < placement_words; w++)
+            {
+                uint64_t bits = a->valid[k].w[w] & l->cover[c].w[w];
+
+                while (bits)
+                {
+                    int p = (w << 6) + __builtin_ctzll(bits);
+                    bits &= bits - 1;
+
+                    const Placement *m = l->ref[p].mask;
+                    Bits128 covered = bits_and(m->ship, a->hit_bits);
+
+                    // count each placement once via its first damaged cell
+                    if (bits_first(covered) != c)
+                        continue;
+
+                    // a ship cannot touch damaged cells of another ship
+                    if (!bits_empty(bits_andnot(bits_and(m->halo, a->hit_bits), m->ship)))
+                        continue;
+
+                    int n = bits_count(covered);
+                    int weight = a->remaining[k] * n * n;
+
+                    Bits128 cells = bits_andnot(m->ship, a->shot_bits);
+                    while (!bits_empty(cells))
+                        score[bits_pop(&cells)] += weight;
+                }
+            }
+        }
+    }
+
+    return choose_best(a, score, y, x);
+}
+
+// helper for choosing a cell next to the damaged cells of a large board
+static bool grid_choose_target(Ai *a, int *y, int *x)
+{
+    int size = a->gen->size;
+
+    a->touches = 0;
+    for (int i = 0; i < a->hit_count; i++)
+    {
+        int hy = a->hits[i] / size, hx = a->hits[i] % size;
+
+        target_line(a, hy * size, 1, size, hy, hx, false);
+        target_line(a, hx, size, 1, hx, hy, true);
+    }
+
+    // choose the best scored cell, ties are broken randomly
+    int best = 0, ties = 0;
+    for (int i = 0; i < a->touches; i++)
+    {
+        int c = a->touched[i];
+
+        if (a->score[c] > best)
+        {
+            best = a->score[c];
+            ties = 0;
+        }
+
+        if (a->score[c] == best)
+            if (rnd_int(&a->random, ++ties) == 0)
+            {
+                *y = c / size;
+                *x = c % size;
+            }
+    }
+
+    for (int i = 0; i < a->touches; i++)
+        a->score[a->touched[i]] = 0;
+
+    return best > 0;
+}
+
+// helper for choosing the hottest unshot cell of a large board
+// * ties are broken randomly by descending to a random one of the tied leaves
+static bool grid_choose_best(Ai *a, int *y, int *x)
+{
+    if (a->tree_max[1] <= 0)
+        return false;
+
+    int r = rnd_int(&a->random, a->tree_ties[1]);
+    int i = 1;
+    while (i < a->leaves)
+    {
+        int l = 2 * i;
+
+        if (a->tree_max[l] == a->tree_max[i])
+        {
+            if (r < a->tree_ties[l])
+            {
+                i = l;
+                continue;
+            }
+            r -= a->tree_ties[l];
+        }
+
+        i = l + 1;
+    }
+
+    int c = i - a->leaves;
+    *y = c / a->gen->size;
+    *x = c % a->gen->size;
+
+    return true;
+}
+
+// helper for choosing a random unshot cell of a large board
+static bool grid_choose_random(Ai *a, int *y, int *x)
+{
+    if (a->unshots == 0)
+        return false;
+
+    int c = a->unshot[rnd_int(&a->random, a->unshots)];
+    *y = c / a->gen->size;
+    *x = c % a->gen->size;
+
+    return true;
+}
+
+// choose the next shot
+bool ai_choose(Ai *a, int *y, int *x)
+{
+    // large boards are not sampled, the Monte Carlo mode hunts by density instead
+    if (!a->gen->placements)
+    {
+        if (a->mode == AI_DENSITY || a->mode == AI_MONTECARLO)
+        {
+            if (a->hit_count > 0)
+                if (grid_choose_target(a, y, x))
+                    return true;
+
+            if (grid_choose_best(a, y, x))
+                return true;
+        }
+
+        return grid_choose_random(a, y, x);
+    }
+
+    // the endgame is played optimally
+    if (a->solver && a->mode != AI_RANDOM)
+        if (solver_choose(a->solver, a, y, x))
+            return true;
+
+    if (a->mode == AI_MONTECARLO)
+        if (sample_choose(a, a->pool, a->budget, y, x))
+            return true;
+
+    if (a->mode == AI_DENSITY || a->mode == AI_MONTECARLO)
+    {
+        // target mode, try to sink damaged ships
+        if (!bits_empty(a->hit_bits))
+            if (choose_target(a, y, x))
+                return true;
+
+        // hunt mode, shoot at the cell covered by most placements
+        if (choose_best(a, a->heat, y, x))
+            return true;
+    }
+
+    return choose_random(a, y, x);
+}
+
+// get the heat of the cell at position (y, x)
+int ai_get_heat(const Ai *a, int y, int x)
+{
+    int size = a->gen->size;
+    if (y < 0 || x < 0 || y >= size || x >= size)
+        return 0;
+
+    if (!a->gen->placements)
+    {
+        int heat = a->tree_max[a->leaves + y * size + x];
+        return heat > 0 ? heat : 0;
+    }
+
+    return a->heat[bits_index(y, x)];
+}
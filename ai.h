@@ -0,0 +1,100 @@
+// Sink Ships computer opponent
+// * the opponent only sees the results of its own shots
+// * the density mode keeps a heat map that counts for each cell
+//   the legal placements of the remaining fleet that cover the cell
+// * the heat map is updated incrementally after each shot,
+//   only the placements that are invalidated by the shot are visited
+// * the Monte Carlo mode samples fleets that are consistent with the shots,
+//   see sampler.h
+// * boards beyond the bitboard size keep the heat map per cell instead,
+//   a shot only updates the cells within one ship length in its row and column
+//   and the hottest cell is looked up in a max tree, so a shot costs O(L log n)
+
+#pragma once
+
+#include <stddef.h>
+
+#include "board.h"
+#include "fleetgen.h"
+
+struct ThreadPool;
+struct Solver;
+
+//! opponent modes
+enum AiMode
+{
+    AI_RANDOM = 0,    // shoot at random cells that have not been shot yet
+    AI_DENSITY = 1,   // hunt and target by placement density
+    AI_MONTECARLO = 2 // shoot at the cell most frequently covered by sampled fleets
+};
+
+//! opponent state
+struct Ai
+{
+    int mode;                       // the opponent mode
+    const FleetGen *gen;            // the placement index of the opponent fleet
+    ThreadPool *pool;               // the thread pool of the Monte Carlo mode
+    float budget;                   // the wall-clock budget per move of the Monte Carlo mode
+    Solver *solver;                 // the endgame solver, NULL if the endgame is not solved
+    Random random;                  // the random number generator
+    int remaining[fleet_max_ships]; // the number of remaining ships per placement list
+
+    // bitboard state, used if the placements of the opponent fleet are indexed
+    Bits128 shot_bits;                 // the cells that were shot
+    Bits128 hit_bits;                  // the damaged cells of ships that are not sunk yet
+    Bits128 sunk_bits;                 // the cells of sunk ships
+    Bits128 blocked_bits;              // the cells that cannot be covered by a remaining ship
+    PlacementSet valid[bitboard_size]; // the placements that do not cover a blocked cell
+
+    // the number of valid placements covering a cell per placement list
+    int count[bitboard_size][bitboard_size * bitboard_size];
+
+    // the heat map, weighted sum of the valid placements covering a cell
+    int heat[bitboard_size * bitboard_size];
+
+    // cell state, used for boards that are not indexed
+    unsigned char *cell;         // the shot, hit and blocked flags of each cell
+    int weight[fleet_max_ships]; // the heat weight per placement list, 0 once all its ships are sunk
+    int leaves;                  // the number of leaves of the max tree, a power of two
+    int *tree_max;               // the max tree of the heat map, -1 for shot cells
+    int *tree_ties;              // the number of cells with the maximum heat per tree node
+    int *unshot;                 // the cells that have not been shot yet
+    int *unshot_pos;             // the position of each cell in the unshot list
+    int unshots;                 // the number of cells that have not been shot yet
+    int *hits;                   // the damaged cells of ships that are not sunk yet
+    int hit_count;               // the number of damaged cells of ships that are not sunk yet
+    int *score;                  // the scratch score map of the target mode
+    int *touched;                // the cells with a nonzero score in the scratch score map
+    int touches;                 // the number of cells with a nonzero score
+};
+
+//! initialize the opponent
+//! * "gen" is the fleet generator of the opponent fleet, it must outlive the opponent
+//! * allocates the cell state of large boards, which is released by ai_free
+void ai_init(Ai *a, const FleetGen *gen, int mode = AI_DENSITY, uint64_t seed = 0, uint64_t stream = 0);
+
+//! release the cell state of the opponent
+void ai_free(Ai *a);
+
+//! configure the Monte Carlo mode
+//! * "pool" is the thread pool to sample on, sampling runs on the calling thread for NULL
+//! * "budget" is the wall-clock budget per move in milli seconds
+void ai_set_sampler(Ai *a, ThreadPool *pool = NULL, float budget = 5);
+
+//! configure the endgame solver
+//! * "solver" plays the end of the game optimally once few ships remain, see solver.h
+//! * the solver is not owned by the opponent, NULL disables it
+void ai_set_solver(Ai *a, Solver *solver);
+
+//! choose the next shot
+//! * returns the position (y, x) of a cell that has not been shot yet
+//! * returns false if all cells have been shot
+bool ai_choose(Ai *a, int *y, int *x);
+
+//! update the opponent with the result of a shot at position (y, x)
+void ai_update(Ai *a, int y, int x, int result);
+
+//! get the heat of the cell at position (y, x)
+//! * returns the weighted number of remaining ship placements covering the cell
+//! * shot cells of large boards report no heat
+int ai_get_heat(const Ai *a, int y, int x);
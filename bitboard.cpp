@@ -0,0 +1,54 @@
+// Sink Ships bitboards
+
+#include "bitboard.h"
+
+// the number of placements per ship length and orientation
+static const int positions = bitboard_size * bitboard_size;
+
+// the precomputed placement masks
+// * indexed by ship length-1, orientation and top-left cell
+static Placement placements[bitboard_size][2][positions];
+
+// precompute the placement masks of all ships that lie inside the board
+static bool init_placements()
+{
+    for (int l = 1; l <= bitboard_size; l++)
+        for (int o = 0; o < 2; o++)
+        {
+            int height = o ? 1 : l;
+            int width = o ? l : 1;
+
+            for (int y = 0; y + height <= bitboard_size; y++)
+                for (int x = 0; x + width <= bitboard_size; x++)
+                {
+                    Placement p = {bits128(), bits128()};
+
+                    for (int i = y - 1; i <= y + height; i++)
+                        for (int j = x - 1; j <= x + width; j++)
+                        {
+                            if (i < 0 || j < 0 || i >= bitboard_size || j >= bitboard_size)
+                                continue;
+
+                            Bits128 bit = bits_bit(bits_index(i, j));
+
+                            if (i >= y && i < y + height && j >= x && j < x + width)
+                                p.ship = bits_or(p.ship, bit);
+
+                            p.halo = bits_or(p.halo, bit);
+                        }
+
+                    placements[l - 1][o][bits_index(y, x)] = p;
+                }
+        }
+
+    return true;
+}
+
+// the placement masks are computed at load time, so that they are ready before any thread starts
+static const bool initialized = init_placements();
+
+// get the precomputed placement masks of a ship
+const Placement *get_placement(int length, bool horizontal, int y, int x)
+{
+    return &placements[length - 1][horizontal ? 1 : 0][bits_index(y, x)];
+}
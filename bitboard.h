@@ -0,0 +1,122 @@
+// Sink Ships bitboards
+// * a board with up to 128 cells is represented by a single 128-bit mask
+// * bit y*bitboard_size+x represents the cell at position (y, x)
+// * larger arenas are not represented by bitboards, see board.h
+
+#pragma once
+
+#include <stdint.h>
+
+//! maximum arena size that is represented by bitboards
+//! * all cells of the arena need to fit into a 128-bit mask
+const int bitboard_size = 10;
+
+//! 128-bit mask type
+struct Bits128
+{
+    uint64_t lo; // bits 0-63
+    uint64_t hi; // bits 64-127
+};
+
+//! ship placement masks
+struct Placement
+{
+    Bits128 ship; // the cells covered by the ship
+    Bits128 halo; // the cells covered by the ship plus its surrounding cells
+};
+
+//! empty mask construction
+inline Bits128 bits128()
+{
+    Bits128 b = {0, 0};
+    return b;
+}
+
+//! get the bit index of the cell at position (y, x)
+inline int bits_index(int y, int x)
+{
+    return y * bitboard_size + x;
+}
+
+//! single bit mask construction
+inline Bits128 bits_bit(int i)
+{
+    Bits128 b = {0, 0};
+    if (i < 64)
+        b.lo = (uint64_t)1 << i;
+    else
+        b.hi = (uint64_t)1 << (i - 64);
+    return b;
+}
+
+//! bitwise or of two masks
+inline Bits128 bits_or(Bits128 a, Bits128 b)
+{
+    Bits128 r = {a.lo | b.lo, a.hi | b.hi};
+    return r;
+}
+
+//! bitwise and of two masks
+inline Bits128 bits_and(Bits128 a, Bits128 b)
+{
+    Bits128 r = {a.lo & b.lo, a.hi & b.hi};
+    return r;
+}
+
+//! bitwise and of a mask with the complement of another mask
+inline Bits128 bits_andnot(Bits128 a, Bits128 b)
+{
+    Bits128 r = {a.lo & ~b.lo, a.hi & ~b.hi};
+    return r;
+}
+
+//! check whether a mask is empty
+inline bool bits_empty(Bits128 a)
+{
+    return (a.lo | a.hi) == 0;
+}
+
+//! check whether two masks intersect
+inline bool bits_intersect(Bits128 a, Bits128 b)
+{
+    return ((a.lo & b.lo) | (a.hi & b.hi)) != 0;
+}
+
+//! test the bit with index i
+inline bool bits_test(Bits128 a, int i)
+{
+    if (i < 64)
+        return (a.lo >> i) & 1;
+    else
+        return (a.hi >> (i - 64)) & 1;
+}
+
+//! count the set bits of a mask
+inline int bits_count(Bits128 a)
+{
+    return __builtin_popcountll(a.lo) + __builtin_popcountll(a.hi);
+}
+
+//! get the index of the lowest set bit of a non-empty mask
+inline int bits_first(Bits128 a)
+{
+    return a.lo ? __builtin_ctzll(a.lo) : 64 + __builtin_ctzll(a.hi);
+}
+
+//! remove the lowest set bit of a non-empty mask
+//! * returns the index of the removed bit
+inline int bits_pop(Bits128 *a)
+{
+    int i = bits_first(*a);
+    if (a->lo)
+        a->lo &= a->lo - 1;
+    else
+        a->hi &= a->hi - 1;
+    return i;
+}
+
+//! get the precomputed placement masks of a ship
+//! * "length" is the ship size, "horizontal" its orientation
+//! * (y, x) is the top-left position of the ship
+//! * the ship must lie inside a board with bitboard_size x bitboard_size cells
+const Placement *get_placement(int length, bool horizontal, int y, int x);
@@ -0,0 +1,336 @@
+// Sink Ships board
+
+#include "board.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+// initialize the default fleet
+void fleet_default(Fleet *f)
+{
+    static const int sizes[] = {4, 3, 3, 2, 2, 2, 1, 1, 1, 1};
+
+    f->count = sizeof(sizes) / sizeof(sizes[0]);
+    for (int i = 0; i < f->count; i++)
+        f->size[i] = sizes[i];
+}
+
+// parse a fleet composition from a comma separated list of ship sizes
+bool fleet_parse(Fleet *f, const char *text)
+{
+    Fleet fleet;
+    fleet.count = 0;
+
+    while (true)
+    {
+        char *end;
+        long size = strtol(text, &end, 10);
+
+        if (end == text || size < 1 || size > board_max_size)
+            return false;
+        if (fleet.count == fleet_max_ships)
+            return false;
+
+        fleet.size[fleet.count++] = size;
+
+        if (*end == '\0')
+            break;
+        if (*end != ',')
+            return false;
+
+        text = end + 1;
+    }
+
+    *f = fleet;
+
+    return true;
+}
+
+// check a fleet composition
+bool fleet_valid(const Fleet *f, int size)
+{
+    if (f->count < 1 || f->count > fleet_max_ships)
+        return false;
+
+    for (int i = 0; i < f->count; i++)
+        if (f->size[i] < 1 || f->size[i] > size)
+            return false;
+
+    return true;
+}
+
+// get the total number of ship cells of a fleet
+int fleet_cells(const Fleet *f)
+{
+    int cells = 0;
+    for (int i = 0; i < f->count; i++)
+        cells += f->size[i];
+    return cells;
+}
+
+// get the largest ship size of a fleet
+int fleet_max_length(const Fleet *f)
+{
+    int length = 0;
+    for (int i = 0; i < f->count; i++)
+        if (f->size[i] > length)
+            length = f->size[i];
+    return length;
+}
+
+// initialize an empty board with size x size cells
+void board_init(Board *b, int size)
+{
+    if (size < 1)
+        size = 1;
+    if (size > board_max_size)
+        size = board_max_size;
+
+    b->size = size;
+
+    // ships do not touch, so no two ships share a cell of the same 2x2 block
+    int blocks = (size + 1) / 2;
+    b->capacity = blocks * blocks < fleet_max_ships ? blocks * blocks : fleet_max_ships;
+
+    // the cell arrays are only needed beyond the bitboard size
+    b->cell = NULL;
+    b->ship_id = NULL;
+    if (size > bitboard_size)
+    {
+        b->cell = new unsigned char[size * size];
+        b->ship_id = new unsigned short[size * size];
+    }
+
+    b->ship = new Ship[b->capacity];
+
+    board_clear(b);
+}
+
+// remove all ships and shots from a board
+void board_clear(Board *b)
+{
+    b->ship_bits = bits128();
+    b->shot_bits = bits128();
+    b->hit_bits = bits128();
+
+    if (b->cell)
+    {
+        memset(b->cell, CELL_EMPTY, b->size * b->size * sizeof(b->cell[0]));
+        memset(b->ship_id, 0, b->size * b->size * sizeof(b->ship_id[0]));
+    }
+
+    b->ships = 0;
+    b->alive = 0;
+}
+
+// release the cell arrays and the ships of a board
+void board_free(Board *b)
+{
+    delete[] b->cell;
+    delete[] b->ship_id;
+    delete[] b->ship;
+
+    b->cell = NULL;
+    b->ship_id = NULL;
+    b->ship = NULL;
+}
+
+// get the cell state at position (y, x)
+int board_get_cell(const Board *b, int y, int x)
+{
+    if (y < 0 || x < 0 || y >= b->size || x >= b->size)
+        return CELL_EMPTY;
+
+    if (b->cell)
+        return b->cell[y * b->size + x];
+
+    int i = bits_index(y, x);
+
+    // the encoding is CELL_SHOT for shot cells plus CELL_SHIP for ship cells
+    return bits_test(b->shot_bits, i) | (bits_test(b->ship_bits, i) << 1);
+}
+
+// set the cell state at position (y, x) without placing a ship
+void board_set_cell(Board *b, int y, int x, int state)
+{
+    if (y < 0 || x < 0 || y >= b->size || x >= b->size)
+        return;
+
+    if (b->cell)
+    {
+        b->cell[y * b->size + x] = state;
+        return;
+    }
+
+    Bits128 bit = bits_bit(bits_index(y, x));
+
+    b->shot_bits = state & CELL_SHOT ? bits_or(b->shot_bits, bit) : bits_andnot(b->shot_bits, bit);
+    b->ship_bits = state & CELL_SHIP ? bits_or(b->ship_bits, bit) : bits_andnot(b->ship_bits, bit);
+    b->hit_bits = state == CELL_DAMAGED ? bits_or(b->hit_bits, bit) : bits_andnot(b->hit_bits, bit);
+}
+
+// helper for getting the placement masks of a ship inside the board
+// * returns NULL if the ship is no straight line inside the board or the board is not a bitboard
+static const Placement *placement(const Board *b, int y, int x, int height, int width)
+{
+    if (b->cell)
+        return NULL;
+
+    if (height == 1)
+        return get_placement(width, true, y, x);
+    else
+        return get_placement(height, false, y, x);
+}
+
+// helper for checking if a ship lies inside the board
+static bool inside(const Board *b, int y, int x, int height, int width)
+{
+    // ships are straight lines
+    if (height < 1 || width < 1)
+        return false;
+    if (height > 1 && width > 1)
+        return false;
+
+    // the ship must lie inside the arena
+    return y >= 0 && x >= 0 && y + height <= b->size && x + width <= b->size;
+}
+
+// check whether a ship with extent (height, width) can be placed at position (y, x)
+bool board_can_place(const Board *b, int y, int x, int height, int width)
+{
+    if (!inside(b, y, x, height, width))
+        return false;
+
+    // a bitboard only checks the precomputed halo
+    if (!b->cell)
+        return !bits_intersect(placement(b, y, x, height, width)->halo, b->ship_bits);
+
+    // check if there is already a ship in the surrounding cells
+    int y1 = y > 0 ? y - 1 : 0;
+    int x1 = x > 0 ? x - 1 : 0;
+    int y2 = y + height < b->size ? y + height : b->size - 1;
+    int x2 = x + width < b->size ? x + width : b->size - 1;
+
+    for (int i = y1; i <= y2; i++)
+        for (int j = x1; j <= x2; j++)
+            if (b->ship_id[i * b->size + j])
+                return false;
+
+    return true;
+}
+
+// place a ship with extent (height, width) at position (y, x)
+bool board_place_ship(Board *b, int y, int x, int height, int width)
+{
+    if (b->ships >= b->capacity)
+        return false;
+
+    if (!board_can_place(b, y, x, height, width))
+        return false;
+
+    Ship s = {y, x, height, width, 0, bits128()};
+    b->alive += height * width;
+
+    // a bitboard saves the ship as a mask
+    if (!b->cell)
+    {
+        s.mask = placement(b, y, x, height, width)->ship;
+        b->ship[b->ships++] = s;
+        b->ship_bits = bits_or(b->ship_bits, s.mask);
+        return true;
+    }
+
+    b->ship[b->ships++] = s;
+
+    // save the ship into the arena
+    for (int i = y; i < y + height; i++)
+        for (int j = x; j < x + width; j++)
+        {
+            b->cell[i * b->size + j] = CELL_SHIP;
+            b->ship_id[i * b->size + j] = b->ships;
+        }
+
+    return true;
+}
+
+// helper for finding the ship that covers a cell of a bitboard
+static Ship *find_ship(const Board *b, Bits128 bit)
+{
+    for (int i = 0; i < b->ships; i++)
+        if (bits_intersect(b->ship[i].mask, bit))
+            return &b->ship[i];
+
+    return NULL;
+}
+
+// shoot at position (y, x)
+int board_shoot(Board *b, int y, int x)
+{
+    if (y < 0 || x < 0 || y >= b->size || x >= b->size)
+        return SHOT_NONE;
+
+    if (!b->cell)
+    {
+        Bits128 bit = bits_bit(bits_index(y, x));
+
+        // the cell was shot already
+        if (bits_intersect(b->shot_bits, bit))
+            return SHOT_NONE;
+
+        b->shot_bits = bits_or(b->shot_bits, bit);
+
+        // there is nothing
+        Ship *s = bits_intersect(b->ship_bits, bit) ? find_ship(b, bit) : NULL;
+        if (!s)
+            return SHOT_MISS;
+
+        // there is a ship
+        b->hit_bits = bits_or(b->hit_bits, bit);
+        s->damage++;
+        b->alive -= 1;
+
+        // the ship is sunk if all of its cells are damaged
+        return bits_empty(bits_andnot(s->mask, b->hit_bits)) ? SHOT_SUNK : SHOT_HIT;
+    }
+
+    int c = y * b->size + x;
+
+    // the cell was shot already
+    if (b->cell[c] & CELL_SHOT)
+        return SHOT_NONE;
+
+    b->cell[c] |= CELL_SHOT;
+
+    // there is nothing
+    if (!b->ship_id[c])
+        return SHOT_MISS;
+
+    // there is a ship
+    Ship *s = &b->ship[b->ship_id[c] - 1];
+    s->damage++;
+    b->alive -= 1;
+
+    // the ship is sunk if all of its cells are damaged
+    return s->damage == s->height * s->width ? SHOT_SUNK : SHOT_HIT;
+}
+
+// get the ship at position (y, x)
+const Ship *board_get_ship(const Board *b, int y, int x)
+{
+    if (y < 0 || x < 0 || y >= b->size || x >= b->size)
+        return NULL;
+
+    if (!b->cell)
+        return find_ship(b, bits_bit(bits_index(y, x)));
+
+    int id = b->ship_id[y * b->size + x];
+
+    return id ? &b->ship[id - 1] : NULL;
+}
+
+// get the number of intact ship cells
+int board_ships_left(const Board *b)
+{
+    return b->alive;
+}
@@ -0,0 +1,132 @@
+// Sink Ships board
+// * headless game state of a single arena without any NCurses calls
+// * arenas within the bitboard size are represented by bitboards, see bitboard.h,
+//   so that placement checks are a single intersection test with a precomputed halo
+// * larger arenas are stored as one state byte and one ship index per cell,
+//   so that all operations only touch the cells of a single ship
+
+#pragma once
+
+#include "bitboard.h"
+
+//! default arena size
+const int board_default_size = 10;
+
+//! maximum supported arena size
+const int board_max_size = 1000;
+
+//! maximum number of ships per fleet
+const int fleet_max_ships = 1024;
+
+//! cell states
+//! * the values match the encoding of the former cells array
+enum CellState
+{
+    CELL_EMPTY = 0,  // there is nothing
+    CELL_SHOT = 1,   // the cell was shot and there is no ship
+    CELL_SHIP = 2,   // there is a ship
+    CELL_DAMAGED = 3 // there is a damaged ship
+};
+
+//! shot results
+enum ShotResult
+{
+    SHOT_NONE = 0, // no shot was made (cell was shot already)
+    SHOT_MISS = 1, // the shot missed
+    SHOT_HIT = 2,  // the shot hit a ship
+    SHOT_SUNK = 3  // the shot hit and sunk a ship
+};
+
+//! fleet composition
+//! * ship sizes are listed in placement order
+struct Fleet
+{
+    int count;
+    int size[fleet_max_ships];
+};
+
+//! placed ship
+struct Ship
+{
+    int y, x;          // top-left position
+    int height, width; // extent in cells
+    int damage;        // the number of damaged cells
+    Bits128 mask;      // the cells covered by the ship, empty beyond the bitboard size
+};
+
+//! arena state of one player
+//! * a board owns its cell arrays and ships, it must not be copied
+struct Board
+{
+    int size;                // arena size (size x size cells)
+    Bits128 ship_bits;       // the cells covered by ships, within the bitboard size
+    Bits128 shot_bits;       // the cells that were shot, within the bitboard size
+    Bits128 hit_bits;        // the cells with damaged ships, within the bitboard size
+    unsigned char *cell;     // the state of each cell in row-major order, NULL within the bitboard size
+    unsigned short *ship_id; // the ship index plus one of each cell, 0 if there is no ship, NULL within the bitboard size
+    Ship *ship;              // placed ships
+    int capacity;            // the number of ships that fit into the arena
+    int ships;               // number of placed ships
+    int alive;               // number of intact ship cells
+};
+
+//! initialize the default fleet
+//! * 1 ship with size 4, 2 with size 3, 3 with size 2 and 4 with size 1
+void fleet_default(Fleet *f);
+
+//! parse a fleet composition from a comma separated list of ship sizes
+//! * for example "4,3,3,2,2,2,1,1,1,1" is the default fleet
+//! * returns false if the list is empty, malformed or contains too many ships
+bool fleet_parse(Fleet *f, const char *text);
+
+//! check a fleet composition
+//! * returns false if the fleet is empty, contains too many ships
+//!   or a ship size is not between 1 and the arena size
+bool fleet_valid(const Fleet *f, int size = board_max_size);
+
+//! get the total number of ship cells of a fleet
+int fleet_cells(const Fleet *f);
+
+//! get the largest ship size of a fleet
+int fleet_max_length(const Fleet *f);
+
+//! initialize an empty board with size x size cells
+//! * allocates the ships and beyond the bitboard size the cell arrays, which are released by board_free
+//! * only as many ships are allocated as fit into the arena without touching,
+//!   so that small boards stay small when many games are kept in memory
+void board_init(Board *b, int size = board_default_size);
+
+//! remove all ships and shots from a board
+void board_clear(Board *b);
+
+//! release the cell arrays and the ships of a board
+void board_free(Board *b);
+
+//! get the cell state at position (y, x)
+//! * positions outside of the board are reported as empty
+int board_get_cell(const Board *b, int y, int x);
+
+//! set the cell state at position (y, x) without placing a ship
+//! * mirrors the state of an arena that is known from elsewhere, e.g. from a server
+void board_set_cell(Board *b, int y, int x, int state);
+
+//! check whether a ship with extent (height, width) can be placed at position (y, x)
+//! * the ship must lie inside the board
+//! * the ship must not touch another ship, not even diagonally
+//! * within the bitboard size the check is a single intersection test with the precomputed ship halo
+bool board_can_place(const Board *b, int y, int x, int height, int width);
+
+//! place a ship with extent (height, width) at position (y, x)
+//! * returns false if the ship cannot be placed
+bool board_place_ship(Board *b, int y, int x, int height, int width);
+
+//! shoot at position (y, x)
+//! * returns the shot result
+int board_shoot(Board *b, int y, int x);
+
+//! get the ship at position (y, x)
+//! * returns NULL if there is no ship
+const Ship *board_get_ship(const Board *b, int y, int x);
+
+//! get the number of intact ship cells
+int board_ships_left(const Board *b);
@@ -0,0 +1,736 @@
+// Sink Ships fleet counter
+
+#include "fleetcount.h"
+
+// number of bits of the state of a column
+static const int column_bits = 5;
+
+// column states, a vertical ship of length l is encoded as column_vertical + 2 * (l - 1) + h,
+// where h decides if all of its cells are damaged
+enum
+{
+    column_empty = 0,    // the cell above is empty
+    column_finished = 1, // the cell above is covered by a finished ship
+    column_vertical = 2  // the cell above is covered by a vertical ship that may continue below
+};
+
+// number of bits of the number of ships of a placement list in a packed number of ships,
+// the highest bit is the guard bit
+static const int ships_bits = 6;
+
+// maximum number of ships per placement list, more ships do not fit into an indexed arena anyway
+static const int max_ships = (1 << (ships_bits - 1)) - 1;
+
+// maximum number of transitions of a profile, one per occupied cell mask of a row
+static const int max_transitions = 1 << bitboard_size;
+
+// initial size of the hash table of a layer
+static const int initial_entries = 1024;
+
+// transition of the dynamic program
+struct FleetCountTransition
+{
+    uint64_t profile;    // the packed profile below the row
+    int offset;          // the composition index of the ships that are finished in the row
+    unsigned short mask; // the ship cells of the row
+};
+
+// enumeration state of the transitions of a row
+struct FleetCountRow
+{
+    const FleetCount *f;       // the fleet counter
+    int row;                   // the row
+    int above[bitboard_size];  // the column states above the row
+    int below[bitboard_size];  // the column states below the row
+    uint64_t ships;            // the packed number of ships that are finished in the row
+    int offset;                // the composition index of the ships that are finished in the row
+    int longest;               // the length of the longest ship
+    FleetCountTransition *out; // the transitions
+    int count;                 // the number of transitions
+};
+
+// helper for hashing a packed profile
+static int hash_profile(uint64_t key, int size)
+{
+    key ^= key >> 29;
+    key *= 0xBF58476D1CE4E5B9ULL;
+    key ^= key >> 32;
+    return (int)(key & (size - 1));
+}
+
+// helper for finding the entry of a profile in a layer
+// * returns an empty entry if the profile is not in the layer
+static FleetCountProfile *find_profile(const FleetCountLayer *l, uint64_t profile)
+{
+    int i = hash_profile(profile, l->size);
+    while (l->entries[i].key != 0 && l->entries[i].key != profile + 1)
+        i = (i + 1) & (l->size - 1);
+
+    return &l->entries[i];
+}
+
+// helper for adding a profile to a layer
+// * the table grows once it is half full
+// * returns the index of the profile
+static int add_profile(FleetCountLayer *l, uint64_t profile)
+{
+    FleetCountProfile *found = find_profile(l, profile);
+    if (found->key != 0)
+        return found->index;
+
+    if (2 * (l->used + 1) > l->size)
+    {
+        FleetCountProfile *entries = l->entries;
+        uint64_t *profiles = l->profiles;
+        int size = l->size;
+
+        l->size *= 2;
+        l->entries = new FleetCountProfile[l->size];
+        l->profiles = new uint64_t[l->size / 2];
+        for (int i = 0; i < l->size; i++)
+            l->entries[i].key = 0;
+
+        for (int i = 0; i < size; i++)
+            if (entries[i].key != 0)
+                *find_profile(l, entries[i].key - 1) = entries[i];
+        for (int i = 0; i < l->used; i++)
+            l->profiles[i] = profiles[i];
+
+        delete[] entries;
+        delete[] profiles;
+    }
+
+    FleetCountProfile *e = find_profile(l, profile);
+    e->key = profile + 1;
+    e->index = l->used;
+    l->profiles[l->used++] = profile;
+
+    return e->index;
+}
+
+// helper for adding a transition to a layer
+// * the transitions grow by doubling
+static void add_edge(FleetCountLayer *l, int n, int below, const FleetCountTransition *t)
+{
+    if (n == l->capacity)
+    {
+        FleetCountEdge *edges = l->edges;
+
+        l->capacity = l->capacity > 0 ? 2 * l->capacity : initial_entries;
+        l->edges = new FleetCountEdge[l->capacity];
+        for (int i = 0; i < n; i++)
+            l->edges[i] = edges[i];
+
+        delete[] edges;
+    }
+
+    FleetCountEdge *e = &l->edges[n];
+    e->below = below;
+    e->offset = t->offset;
+    e->mask = t->mask;
+}
+
+// helper for resetting a layer
+// * the layers of large counts are shrunk again, clearing them would dominate small counts
+static void reset_layer(FleetCountLayer *l)
+{
+    if (l->size > initial_entries)
+    {
+        delete[] l->entries;
+        delete[] l->profiles;
+        l->size = initial_entries;
+        l->entries = new FleetCountProfile[l->size];
+        l->profiles = new uint64_t[l->size / 2];
+    }
+
+    for (int i = 0; i < l->size; i++)
+        l->entries[i].key = 0;
+    l->used = 0;
+
+    delete[] l->count;
+    delete[] l->first;
+    l->count = NULL;
+    l->first = NULL;
+}
+
+// helper for checking if ships may be placed in addition to the ships of a composition
+// * the guard bits of the packed numbers of ships stay set unless a placement list runs out of ships
+static bool fits(const FleetCount *f, int composition, uint64_t ships)
+{
+    return (((f->headroom[composition] | f->guard) - ships) & f->guard) == f->guard;
+}
+
+// helper for getting the packed number of ships per placement list of a composition
+static uint64_t ships_of(const FleetCount *f, int composition)
+{
+    return f->headroom[0] - f->headroom[composition];
+}
+
+// helper for checking if a cell of a row is damaged
+static bool is_hit(const FleetCount *f, int row, int column)
+{
+    return bits_test(f->hit, bits_index(row, column));
+}
+
+// helper for packing a profile
+static uint64_t pack(const FleetCount *f, const int *columns)
+{
+    uint64_t profile = 0;
+    for (int c = 0; c < f->gen->size; c++)
+        profile |= (uint64_t)columns[c] << (column_bits * c);
+
+    return profile;
+}
+
+// helper for finishing a ship of a length
+// * returns the placement list of the ship, -1 if there is no ship of that length
+static int place_ship(FleetCountRow *r, int length)
+{
+    int k = length <= bitboard_size ? r->f->list_of[length] : -1;
+    if (k < 0 || (int)((r->ships >> (ships_bits * k)) & max_ships) == r->f->remaining[k])
+        return -1;
+
+    r->ships += (uint64_t)1 << (ships_bits * k);
+    r->offset += r->f->radix[k];
+    return k;
+}
+
+// helper for removing a finished ship of a placement list again
+static void remove_ship(FleetCountRow *r, int k)
+{
+    if (k < 0)
+        return;
+
+    r->ships -= (uint64_t)1 << (ships_bits * k);
+    r->offset -= r->f->radix[k];
+}
+
+// helper for closing a run of ship cells from column s to e
+// * a single cell continues or starts a vertical ship, a longer run is a horizontal ship
+// * the vertical ships end in the last row
+// * returns the placement list of a finished ship, -1 for a vertical ship and -2 if the run is illegal
+static int close_run(FleetCountRow *r, int s, int e)
+{
+    if (s == e)
+    {
+        int above = r->above[s];
+        bool hit = is_hit(r->f, r->row, s);
+        int length = 1;
+        bool damaged = hit;
+
+        if (above >= column_vertical)
+        {
+            length = (above - column_vertical) / 2 + 2;
+            damaged = damaged && (above - column_vertical) % 2 == 1;
+
+            if (length > r->longest)
+                return -2;
+        }
+
+        if (r->row < r->f->gen->size - 1)
+        {
+            r->below[s] = column_vertical + 2 * (length - 1) + damaged;
+            return -1;
+        }
+
+        // a damaged ship would have been reported sunk
+        int k = damaged ? -1 : place_ship(r, length);
+        if (k < 0)
+            return -2;
+
+        r->below[s] = column_finished;
+        return k;
+    }
+
+    // a horizontal ship does not touch a ship above
+    bool damaged = true;
+    for (int c = s; c <= e; c++)
+    {
+        if (r->above[c] != column_empty)
+            return -2;
+
+        damaged = damaged && is_hit(r->f, r->row, c);
+        r->below[c] = column_finished;
+    }
+
+    // a damaged ship would have been reported sunk
+    if (damaged)
+        return -2;
+
+    int k = place_ship(r, e - s + 1);
+    return k >= 0 ? k : -2;
+}
+
+// helper for enumerating the transitions of a row column by column
+// * "start" is the first column of the open run of ship cells, -1 if there is none
+static void extend(FleetCountRow *r, int c, int start, int mask)
+{
+    const FleetCount *f = r->f;
+    int size = f->gen->size;
+
+    if (c == size)
+    {
+        int k = start >= 0 ? close_run(r, start, size - 1) : -1;
+        if (k == -2)
+            return;
+
+        FleetCountTransition *t = &r->out[r->count++];
+        t->profile = pack(f, r->below);
+        t->offset = r->offset;
+        t->mask = mask;
+
+        remove_ship(r, k);
+        return;
+    }
+
+    int cell = bits_index(r->row, c);
+
+    // the cell is empty, which ends the run to its left and the vertical ship above
+    if (!bits_test(f->hit, cell))
+    {
+        int k = start >= 0 ? close_run(r, start, c - 1) : -1;
+
+        if (k != -2)
+        {
+            int above = r->above[c];
+            int j = -1;
+            bool legal = true;
+
+            if (above >= column_vertical)
+            {
+                // a damaged ship would have been reported sunk
+                legal = (above - column_vertical) % 2 == 0;
+                if (legal)
+                    j = place_ship(r, (above - column_vertical) / 2 + 1);
+                legal = legal && j >= 0;
+            }
+
+            if (legal)
+            {
+                r->below[c] = column_empty;
+                extend(r, c + 1, -1, mask);
+            }
+
+            remove_ship(r, j);
+            remove_ship(r, k);
+        }
+    }
+
+    // the cell is a ship cell, which does not touch a ship above diagonally
+    if (!bits_test(f->blocked, cell) && r->above[c] != column_finished &&
+        (c == 0 || r->above[c - 1] == column_empty) &&
+        (c == size - 1 || r->above[c + 1] == column_empty))
+    {
+        int s = start >= 0 ? start : c;
+        if (c - s + 1 <= r->longest)
+            extend(r, c + 1, s, mask | (1 << c));
+    }
+}
+
+// helper for enumerating the transitions of a profile before a row
+// * the transitions are enumerated in the same order every time, which orders the layouts
+static int transitions(const FleetCount *f, int row, uint64_t profile, FleetCountTransition *out)
+{
+    FleetCountRow r;
+    r.f = f;
+    r.row = row;
+    r.ships = 0;
+    r.offset = 0;
+    r.out = out;
+    r.count = 0;
+
+    for (int c = 0; c < f->gen->size; c++)
+        r.above[c] = (profile >> (column_bits * c)) & ((1 << column_bits) - 1);
+
+    r.longest = 0;
+    for (int k = 0; k < f->gen->lists; k++)
+        if (f->remaining[k] > 0 && f->gen->length[k] > r.longest)
+            r.longest = f->gen->length[k];
+
+    extend(&r, 0, -1, 0);
+
+    return r.count;
+}
+
+// helper for counting the layouts of the profiles before a row
+// * a transition that finishes no ship fits every composition, which saves the check
+static void count_row(FleetCount *f, int row)
+{
+    FleetCountLayer *l = &f->layer[row];
+    const FleetCountLayer *next = &f->layer[row + 1];
+    int compositions = f->compositions;
+    bool overflow = false;
+
+    for (int i = 0; i < l->used; i++)
+    {
+        uint64_t *count = &l->count[(uint64_t)i * compositions];
+        for (int c = 0; c < compositions; c++)
+            count[c] = 0;
+
+        for (int j = l->first[i]; j < l->first[i + 1]; j++)
+        {
+            const FleetCountEdge *e = &l->edges[j];
+            const uint64_t *below = &next->count[(uint64_t)e->below * compositions + e->offset];
+            uint64_t ships = ships_of(f, e->offset);
+
+            if (ships == 0)
+                for (int c = 0; c < compositions; c++)
+                {
+                    count[c] += below[c];
+                    overflow |= count[c] < below[c];
+                }
+            else
+                for (int c = 0; c < compositions - e->offset; c++)
+                    if (fits(f, c, ships))
+                    {
+                        count[c] += below[c];
+                        overflow |= count[c] < below[c];
+                    }
+        }
+    }
+
+    f->overflow = f->overflow || overflow;
+}
+
+// initialize a fleet counter
+void fleetcount_init(FleetCount *f, const FleetGen *gen, long limit)
+{
+    f->gen = gen;
+    f->blocked = bits128();
+    f->hit = bits128();
+    f->compositions = 0;
+    f->composition = 0;
+    f->headroom = NULL;
+    f->guard = 0;
+    f->total = 0;
+    f->overflow = false;
+    f->limit = limit;
+
+    for (int r = 0; r <= bitboard_size; r++)
+    {
+        FleetCountLayer *l = &f->layer[r];
+        l->size = initial_entries;
+        l->used = 0;
+        l->entries = new FleetCountProfile[l->size];
+        l->profiles = new uint64_t[l->size / 2];
+        l->count = NULL;
+        l->first = NULL;
+        l->edges = NULL;
+        l->capacity = 0;
+        for (int i = 0; i < l->size; i++)
+            l->entries[i].key = 0;
+    }
+}
+
+// release the profiles and counts of a fleet counter
+void fleetcount_free(FleetCount *f)
+{
+    for (int r = 0; r <= bitboard_size; r++)
+    {
+        FleetCountLayer *l = &f->layer[r];
+        delete[] l->entries;
+        delete[] l->profiles;
+        delete[] l->count;
+        delete[] l->first;
+        delete[] l->edges;
+        l->entries = NULL;
+        l->profiles = NULL;
+        l->count = NULL;
+        l->first = NULL;
+        l->edges = NULL;
+        l->capacity = 0;
+    }
+
+    delete[] f->headroom;
+    f->headroom = NULL;
+}
+
+// count the layouts that are consistent with observations
+uint64_t fleetcount_count(FleetCount *f, Bits128 blocked, Bits128 hit, const int *remaining)
+{
+    const FleetGen *g = f->gen;
+    int size = g->size;
+
+    f->blocked = blocked;
+    f->hit = hit;
+    f->total = 0;
+    f->overflow = false;
+
+    for (int r = 0; r <= bitboard_size; r++)
+        reset_layer(&f->layer[r]);
+
+    delete[] f->headroom;
+    f->headroom = NULL;
+
+    if (!g->placements)
+        return 0;
+
+    // the compositions are the numbers of placed ships per placement list in mixed radix
+    for (int length = 0; length <= bitboard_size; length++)
+        f->list_of[length] = -1;
+
+    f->compositions = 1;
+    f->composition = 0;
+    f->guard = 0;
+    for (int k = 0; k < g->lists; k++)
+    {
+        if (remaining[k] > max_ships)
+            return 0;
+
+        f->remaining[k] = remaining[k];
+        f->radix[k] = f->compositions;
+        f->list_of[g->length[k]] = k;
+        f->composition += remaining[k] * f->compositions;
+        f->guard |= (uint64_t)1 << (ships_bits * k + ships_bits - 1);
+
+        f->compositions *= remaining[k] + 1;
+        if (f->compositions > fleetcount_max_compositions)
+            return 0;
+    }
+
+    f->headroom = new uint64_t[f->compositions];
+    for (int c = 0; c < f->compositions; c++)
+    {
+        f->headroom[c] = 0;
+        for (int k = 0; k < g->lists; k++)
+        {
+            int used = c / f->radix[k] % (f->remaining[k] + 1);
+            f->headroom[c] |= (uint64_t)(f->remaining[k] - used) << (ships_bits * k);
+        }
+    }
+
+    // the profiles are collected from the top, the layouts are counted from the bottom
+    FleetCountTransition *out = new FleetCountTransition[max_transitions];
+
+    add_profile(&f->layer[0], 0);
+    long counts = 0;
+    long edges = 0;
+    for (int r = 0; r <= size; r++)
+    {
+        FleetCountLayer *l = &f->layer[r];
+
+        counts += (long)l->used * f->compositions;
+        if (counts > fleetcount_max_counts)
+        {
+            delete[] out;
+            return 0;
+        }
+
+        if (r == size)
+            break;
+
+        l->first = new int[l->used + 1];
+        l->first[0] = 0;
+
+        for (int i = 0; i < l->used; i++)
+        {
+            int n = transitions(f, r, l->profiles[i], out);
+
+            edges += n;
+            if (edges > fleetcount_max_transitions || (f->limit > 0 && edges * f->compositions > f->limit))
+            {
+                delete[] out;
+                return 0;
+            }
+
+            for (int j = 0; j < n; j++)
+                add_edge(l, l->first[i] + j, add_profile(&f->layer[r + 1], out[j].profile), &out[j]);
+
+            l->first[i + 1] = l->first[i] + n;
+        }
+    }
+
+    delete[] out;
+
+    for (int r = 0; r <= size; r++)
+        f->layer[r].count = new uint64_t[(uint64_t)f->layer[r].used * f->compositions];
+
+    // the vertical ships end in the last row, so the complete fleet is placed below it
+    FleetCountLayer *bottom = &f->layer[size];
+    for (uint64_t i = 0; i < (uint64_t)bottom->used * f->compositions; i++)
+        bottom->count[i] = (int)(i % f->compositions) == f->composition;
+
+    for (int r = size - 1; r >= 0; r--)
+        count_row(f, r);
+
+    f->total = f->overflow ? 0 : f->layer[0].count[0];
+    return f->total;
+}
+
+// count the remaining fleets that are consistent with the observations of an opponent
+uint64_t fleetcount_observe(FleetCount *f, const Ai *a)
+{
+    return fleetcount_count(f, a->blocked_bits, a->hit_bits, a->remaining);
+}
+
+// count all fleets of an empty arena
+uint64_t fleetcount_all(FleetCount *f)
+{
+    int remaining[bitboard_size];
+    for (int k = 0; k < f->gen->lists; k++)
+        remaining[k] = 0;
+    for (int i = 0; i < f->gen->fleet.count; i++)
+        remaining[f->gen->list[i]]++;
+
+    return fleetcount_count(f, bits128(), bits128(), remaining);
+}
+
+// get the exact probability of each cell to be a ship cell
+bool fleetcount_odds(FleetCount *f, double odds[bitboard_size * bitboard_size])
+{
+    int size = f->gen->size;
+    int compositions = f->compositions;
+
+    for (int c = 0; c < bitboard_size * bitboard_size; c++)
+        odds[c] = 0;
+
+    if (f->total == 0)
+        return false;
+
+    // the partial layouts that lead to each profile and composition, for the rows above and below a row
+    int most = 0;
+    for (int r = 0; r <= size; r++)
+        most = f->layer[r].used > most ? f->layer[r].used : most;
+
+    double *above = new double[(uint64_t)most * compositions];
+    double *below = new double[(uint64_t)most * compositions];
+
+    above[0] = 1;
+    for (int c = 1; c < compositions; c++)
+        above[c] = 0;
+
+    // the layouts through a transition are the partial layouts above times the completions below
+    for (int r = 0; r < size; r++)
+    {
+        const FleetCountLayer *l = &f->layer[r];
+        const FleetCountLayer *next = &f->layer[r + 1];
+
+        for (uint64_t i = 0; i < (uint64_t)next->used * compositions; i++)
+            below[i] = 0;
+
+        for (int i = 0; i < l->used; i++)
+        {
+            const double *prefix = &above[(uint64_t)i * compositions];
+
+            for (int j = l->first[i]; j < l->first[i + 1]; j++)
+            {
+                const FleetCountEdge *e = &l->edges[j];
+                const uint64_t *count = &next->count[(uint64_t)e->below * compositions + e->offset];
+                double *to = &below[(uint64_t)e->below * compositions + e->offset];
+                uint64_t ships = ships_of(f, e->offset);
+
+                double layouts = 0;
+                for (int c = 0; c < compositions - e->offset; c++)
+                    if (prefix[c] != 0 && count[c] != 0 && (ships == 0 || fits(f, c, ships)))
+                    {
+                        layouts += prefix[c] * count[c];
+                        to[c] += prefix[c];
+                    }
+
+                for (int mask = e->mask; mask; mask &= mask - 1)
+                    odds[bits_index(r, __builtin_ctz(mask))] += layouts;
+            }
+        }
+
+        double *swap = above;
+        above = below;
+        below = swap;
+    }
+
+    delete[] above;
+    delete[] below;
+
+    for (int c = 0; c < bitboard_size * bitboard_size; c++)
+        odds[c] /= f->total;
+
+    return true;
+}
+
+// place the layout with a specific index on a board
+bool fleetcount_layout(FleetCount *f, uint64_t index, Board *b)
+{
+    int size = f->gen->size;
+
+    if (index >= f->total)
+        return false;
+
+    // the transitions of each row are ordered, so the index selects one of them per row
+    int masks[bitboard_size];
+    int profile = 0;
+    int composition = 0;
+
+    for (int r = 0; r < size; r++)
+    {
+        const FleetCountLayer *l = &f->layer[r];
+        const FleetCountEdge *e = NULL;
+
+        for (int j = l->first[profile]; j < l->first[profile + 1]; j++)
+        {
+            if (composition + l->edges[j].offset >= f->compositions ||
+                !fits(f, composition, ships_of(f, l->edges[j].offset)))
+                continue;
+
+            uint64_t below = f->layer[r + 1].count[(uint64_t)l->edges[j].below * f->compositions +
+                                                   composition + l->edges[j].offset];
+            if (index < below)
+            {
+                e = &l->edges[j];
+                break;
+            }
+            index -= below;
+        }
+
+        if (!e)
+            return false;
+
+        masks[r] = e->mask;
+        profile = e->below;
+        composition += e->offset;
+    }
+
+    // a run of cells is a horizontal ship, a single cell starts or continues a vertical ship
+    for (int r = 0; r < size; r++)
+        for (int c = 0; c < size; c++)
+        {
+            if (!(masks[r] >> c & 1))
+                continue;
+
+            int e = c;
+            while (e + 1 < size && (masks[r] >> (e + 1) & 1))
+                e++;
+
+            if (e > c)
+            {
+                if (!board_place_ship(b, r, c, 1, e - c + 1))
+                    return false;
+                c = e;
+            }
+            else if (r == 0 || !(masks[r - 1] >> c & 1))
+            {
+                int length = 1;
+                while (r + length < size && (masks[r + length] >> c & 1))
+                    length++;
+
+                if (!board_place_ship(b, r, c, length, 1))
+                    return false;
+            }
+        }
+
+    return true;
+}
+
+// place a uniformly drawn layout on a board
+bool fleetcount_sample(FleetCount *f, Random *random, Board *b)
+{
+    if (f->total == 0)
+        return false;
+
+    // the draws below the threshold would favor the small indices
+    uint64_t threshold = (0 - f->total) % f->total;
+    uint64_t draw;
+    do
+        draw = ((uint64_t)rnd_next(random) << 32) | rnd_next(random);
+    while (draw < threshold);
+
+    return fleetcount_layout(f, draw % f->total, b);
+}
@@ -0,0 +1,115 @@
+// Sink Ships fleet counter
+// * counts the legal layouts of a fleet that are consistent with the observations of an opponent,
+//   ships do not touch each other, not even diagonally
+// * the layouts are counted by a dynamic program over the rows of the arena, the column profile
+//   between two rows holds per column whether the cell above is empty, covered by a finished ship or
+//   covered by a vertical ship that may continue below
+// * the number of layouts that complete a profile is kept per fleet composition, that is the number
+//   of placed ships per size, so the transitions of a profile are enumerated once for all compositions
+// * the transitions are kept with the index of the profile below, so the counting, the odds and the
+//   sampling pass do not enumerate or look up profiles again
+// * the counts of all rows are kept, so the layouts can be accessed by their index, which samples
+//   perfectly uniform fleets without rejection
+// * a forward pass over the profiles gives the exact probability of each cell to be a ship cell
+// * only arenas within the bitboard size are counted
+
+#pragma once
+
+#include "ai.h"
+
+//! maximum number of fleet compositions that are distinguished per profile
+//! * the product of the number of ships plus one over all ship sizes
+const int fleetcount_max_compositions = 1 << 14;
+
+//! maximum number of counts of a fleet counter
+//! * the sum of the profiles times the compositions over all rows, 8 bytes each
+const int fleetcount_max_counts = 1 << 25;
+
+//! maximum number of transitions of a fleet counter, 12 bytes each
+const int fleetcount_max_transitions = 1 << 23;
+
+//! column profile between two rows
+struct FleetCountProfile
+{
+    uint64_t key; // the packed column states plus one, 0 for an empty entry
+    int index;    // the index of the profile in its layer
+};
+
+//! transition of a profile through a row to a profile of the next layer
+struct FleetCountEdge
+{
+    int below;           // the index of the profile below the row
+    int offset;          // the composition index of the ships that are finished in the row
+    unsigned short mask; // the ship cells of the row
+};
+
+//! column profiles between two rows
+struct FleetCountLayer
+{
+    FleetCountProfile *entries; // the open addressing hash table of the profiles
+    int size;                   // the number of entries, a power of two
+    int used;                   // the number of profiles
+    uint64_t *profiles;         // the packed column states of each profile by index
+    uint64_t *count;            // the number of layouts that complete each profile per composition
+    int *first;                 // the first transition of each profile by index, plus the end of the last one
+    FleetCountEdge *edges;      // the transitions of the profiles through the row below the layer
+    int capacity;               // the number of allocated transitions
+};
+
+//! fleet counter
+struct FleetCount
+{
+    const FleetGen *gen;                      // the fleet generator of the arena
+    Bits128 blocked;                          // the cells that are no ship cells
+    Bits128 hit;                              // the cells that are ship cells of unsunk ships
+    int remaining[bitboard_size];             // the number of ships to place per placement list
+    int radix[bitboard_size];                 // the place value of each placement list in the composition
+    int list_of[bitboard_size + 1];           // the placement list of each ship length, -1 if none
+    int compositions;                         // the number of compositions
+    int composition;                          // the composition index of the complete fleet
+    uint64_t *headroom;                       // the packed number of ships per placement list that may still be placed, per composition
+    uint64_t guard;                           // the guard bits of the packed numbers of ships
+    FleetCountLayer layer[bitboard_size + 1]; // the profiles before each row and below the last row
+    uint64_t total;                           // the number of consistent layouts
+    bool overflow;                            // decides if the number of layouts exceeds 64 bits
+    long limit;                               // the maximum number of transitions times compositions, 0 for no limit
+};
+
+//! initialize a fleet counter for the arena of a fleet generator
+//! * the arena must be indexed, that is within the bitboard size
+//! * "limit" bounds the time of a count by the number of transitions times compositions,
+//!   which is about the number of additions, 0 for no limit
+void fleetcount_init(FleetCount *f, const FleetGen *gen, long limit = 0);
+
+//! release the profiles and counts of a fleet counter
+void fleetcount_free(FleetCount *f);
+
+//! count the layouts that are consistent with observations
+//! * "blocked" are the cells that are no ship cells, "hit" the damaged cells of unsunk ships
+//! * "remaining" is the number of ships to place per placement list of the generator
+//! * a damaged ship is not complete, it would have been reported sunk otherwise
+//! * returns the number of layouts, 0 if there are too many compositions, profiles or transitions
+//!   or if the count exceeds 64 bits
+uint64_t fleetcount_count(FleetCount *f, Bits128 blocked, Bits128 hit, const int *remaining);
+
+//! count the remaining fleets that are consistent with the observations of an opponent
+uint64_t fleetcount_observe(FleetCount *f, const Ai *a);
+
+//! count all fleets of an empty arena
+uint64_t fleetcount_all(FleetCount *f);
+
+//! get the exact probability of each cell to be a ship cell
+//! * "odds" receives the probabilities by bit index
+//! * returns false if no layout was counted
+bool fleetcount_odds(FleetCount *f, double odds[bitboard_size * bitboard_size]);
+
+//! place the layout with a specific index on a board
+//! * the layouts are ordered by the rows of the dynamic program, "index" is below the count
+//! * the board is not cleared, the ships are placed in addition to the existing ones
+//! * returns false if the index is out of range
+bool fleetcount_layout(FleetCount *f, uint64_t index, Board *b);
+
+//! place a uniformly drawn layout on a board
+//! * drawing layouts only reads the counts, so threads may draw from the same counter
+//! * returns false if no layout was counted
+bool fleetcount_sample(FleetCount *f, Random *random, Board *b);
@@ -0,0 +1,191 @@
+// Sink Ships fleet generator
+
+#include "fleetgen.h"
+#include "fleetcount.h"
+
+// the maximum number of attempts to complete a fleet if the layouts were not counted
+// * an attempt only fails if a ship has no legal placement left
+// * with the default fleet on a 10x10 board this practically never happens
+static const int max_attempts = 100;
+
+// the maximum number of random positions tried per ship on large boards
+static const int max_tries = 1000;
+
+// initialize a fleet generator for a board with size x size cells
+void fleetgen_init(FleetGen *g, const Fleet *fleet, int size)
+{
+    if (size < 1)
+        size = 1;
+    if (size > board_max_size)
+        size = board_max_size;
+
+    g->size = size;
+
+    if (fleet)
+        g->fleet = *fleet;
+    else
+        fleet_default(&g->fleet);
+
+    // sort the fleet by descending ship size, large ships are harder to place
+    for (int i = 1; i < g->fleet.count; i++)
+        for (int j = i; j > 0 && g->fleet.size[j] > g->fleet.size[j - 1]; j--)
+        {
+            int tmp = g->fleet.size[j];
+            g->fleet.size[j] = g->fleet.size[j - 1];
+            g->fleet.size[j - 1] = tmp;
+        }
+
+    // create one placement list per distinct ship size
+    g->lists = 0;
+    for (int i = 0; i < g->fleet.count; i++)
+    {
+        if (i == 0 || g->fleet.size[i] != g->fleet.size[i - 1])
+            g->length[g->lists++] = g->fleet.size[i];
+
+        g->list[i] = g->lists - 1;
+    }
+
+    // index the placements only if the board fits into a bitboard
+    // * more distinct ship sizes than that cannot fit on such a board anyway
+    g->placements = NULL;
+    if (size <= bitboard_size && g->lists <= bitboard_size)
+    {
+        g->placements = new PlacementList[g->lists];
+        for (int k = 0; k < g->lists; k++)
+            placement_list_init(&g->placements[k], size, g->length[k]);
+    }
+
+    // count the layouts once, drawing them only reads the counts
+    g->counter = NULL;
+    if (g->placements)
+    {
+        g->counter = new FleetCount;
+        fleetcount_init(g->counter, g);
+
+        if (fleetcount_all(g->counter) == 0)
+        {
+            fleetcount_free(g->counter);
+            delete g->counter;
+            g->counter = NULL;
+        }
+    }
+}
+
+// release the placement index of a fleet generator
+void fleetgen_free(FleetGen *g)
+{
+    if (g->counter)
+        fleetcount_free(g->counter);
+    delete g->counter;
+    g->counter = NULL;
+
+    delete[] g->placements;
+    g->placements = NULL;
+}
+
+// helper for placing a random fleet ship by ship, if the layouts were not counted
+static bool place_fleet(const FleetGen *g, Board *b, Random *random)
+{
+    PlacementSet available[bitboard_size];
+    for (int k = 0; k < g->lists; k++)
+        available[k] = g->placements[k].all;
+
+    Bits128 blocked = bits128();
+
+    for (int i = 0; i < g->fleet.count; i++)
+    {
+        const PlacementList *l = &g->placements[g->list[i]];
+        PlacementSet *a = &available[g->list[i]];
+
+        // draw uniformly from the remaining legal placements
+        int count = pset_count(a);
+        if (count == 0)
+            return false;
+
+        const PlacementRef *r = &l->ref[pset_select(a, rnd_int(random, count))];
+        board_place_ship(b, r->y, r->x, r->height, r->width);
+
+        // mask out all placements that cover a newly blocked cell
+        Bits128 cells = bits_andnot(r->mask->halo, blocked);
+        blocked = bits_or(blocked, r->mask->halo);
+
+        while (!bits_empty(cells))
+        {
+            int c = bits_pop(&cells);
+
+            for (int k = 0; k < g->lists; k++)
+                pset_remove(&available[k], &g->placements[k].cover[c]);
+        }
+    }
+
+    return true;
+}
+
+// helper for placing a random fleet on a board without placement index
+// * each ship is drawn uniformly from all placements inside the board and
+//   rejected if it touches another ship, so only the cells around it are checked
+static bool place_fleet_sparse(const FleetGen *g, Board *b, Random *random)
+{
+    for (int i = 0; i < g->fleet.count; i++)
+    {
+        int length = g->fleet.size[i];
+        if (length > g->size)
+            return false;
+
+        bool placed = false;
+        for (int t = 0; t < max_tries && !placed; t++)
+        {
+            // both orientations have the same number of placements
+            bool horizontal = length == 1 || rnd_int(random, 2);
+            int y = rnd_int(random, horizontal ? g->size : g->size - length + 1);
+            int x = rnd_int(random, horizontal ? g->size - length + 1 : g->size);
+
+            if (horizontal)
+                placed = board_place_ship(b, y, x, 1, length);
+            else
+                placed = board_place_ship(b, y, x, length, 1);
+        }
+
+        if (!placed)
+            return false;
+    }
+
+    return true;
+}
+
+// generate a random fleet on an initialized board
+bool fleetgen_generate(const FleetGen *g, Board *b, Random *random)
+{
+    if (g->counter)
+    {
+        board_clear(b);
+        return fleetcount_sample(g->counter, random, b);
+    }
+
+    for (int i = 0; i < max_attempts; i++)
+    {
+        board_clear(b);
+
+        if (g->placements ? place_fleet(g, b, random) : place_fleet_sparse(g, b, random))
+            return true;
+    }
+
+    board_clear(b);
+
+    return false;
+}
+
+// generate a batch of random fleets
+int fleetgen_batch(const FleetGen *g, Board *boards, int n, Random *random)
+{
+    for (int i = 0; i < n; i++)
+        if (!fleetgen_generate(g, &boards[i], random))
+        {
+            for (int j = i + 1; j < n; j++)
+                board_clear(&boards[j]);
+
+            return i;
+        }
+
+    return n;
+}
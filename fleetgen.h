@@ -0,0 +1,57 @@
+// Sink Ships fleet generator
+// * generates uniformly random fleets, that is each legal layout of the fleet is equally likely
+// * the layouts of an arena within the bitboard size are counted once at initialization,
+//   a fleet is then drawn by its index among all layouts without rejection, see fleetcount.h
+// * if the layouts cannot be counted, as there are too many profiles or compositions, the ships
+//   are drawn one after another from a precomputed index of all legal placements instead,
+//   placements that conflict with already placed ships are masked out incrementally and a fleet
+//   is only redrawn if a ship has no legal placement left, up to a limited number of attempts,
+//   these fleets are not uniform, a layout whose first ships leave few placements to the later
+//   ones is more likely
+// * boards beyond the bitboard size are not indexed, there each ship is drawn from
+//   random positions with rejection, which is not uniform either
+// * a generator is read-only after initialization and can be shared between threads
+
+#pragma once
+
+#include <stddef.h>
+
+#include "board.h"
+#include "placement.h"
+#include "util.h"
+
+struct FleetCount;
+
+//! fleet generator
+struct FleetGen
+{
+    int size;                    // the board size
+    Fleet fleet;                 // the fleet sorted by descending ship size
+    int lists;                   // the number of distinct ship sizes
+    int list[fleet_max_ships];   // the placement list of each ship
+    int length[fleet_max_ships]; // the ship size of each placement list
+    PlacementList *placements;   // the placement lists of the distinct ship sizes, NULL for large boards
+    FleetCount *counter;         // the counted layouts of the fleet, NULL if they could not be counted
+};
+
+//! initialize a fleet generator for a board with size x size cells
+//! * "fleet" is the fleet composition, the default fleet is used for NULL
+//! * the placement index is only built and the layouts are only counted for boards within the bitboard size
+//! * counting the default fleet on a 10x10 board takes about a second and 250 MB
+void fleetgen_init(FleetGen *g, const Fleet *fleet = NULL, int size = board_default_size);
+
+//! release the placement index and the counted layouts of a fleet generator
+void fleetgen_free(FleetGen *g);
+
+//! generate a random fleet on an initialized board
+//! * the board is cleared first, it must have the size of the generator
+//! * "random" is the random number generator
+//! * returns false if the fleet has no legal layout, or if the layouts were not counted,
+//!   if no legal fleet could be found within the attempts
+bool fleetgen_generate(const FleetGen *g, Board *b, Random *random);
+
+//! generate a batch of random fleets
+//! * fills the initialized boards of a caller provided buffer with n fleets
+//! * stops at the first fleet that cannot be generated, that board and the following ones are empty
+//! * returns the number of generated fleets, less than n only if fleetgen_generate failed
+int fleetgen_batch(const FleetGen *g, Board *boards, int n, Random *random);
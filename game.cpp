@@ -0,0 +1,167 @@
+// Sink Ships game engine
+
+#include "game.h"
+#include "replay.h"
+
+// notify the observer about a changed cell
+static void notify(Game *g, int player, int y, int x)
+{
+    if (g->observer)
+        g->observer(player, y, x, board_get_cell(&g->board[player], y, x), g->observer_data);
+}
+
+// initialize a game with empty arenas
+void game_init(Game *g, const Fleet *fleet, uint64_t seed, uint64_t stream, int size)
+{
+    board_init(&g->board[0], size);
+    board_init(&g->board[1], size);
+
+    if (fleet)
+        g->fleet = *fleet;
+    else
+        fleet_default(&g->fleet);
+
+    g->generator = NULL;
+    rnd_seed(&g->random, seed, stream);
+    g->observer = NULL;
+    g->observer_data = NULL;
+    g->replay = NULL;
+}
+
+// release the arenas of a game
+void game_free(Game *g)
+{
+    board_free(&g->board[0]);
+    board_free(&g->board[1]);
+}
+
+// set the cell observer
+void game_set_observer(Game *g, CellObserver observer, void *data)
+{
+    g->observer = observer;
+    g->observer_data = data;
+}
+
+// set the fleet generator used by game_random_ships
+void game_set_generator(Game *g, const FleetGen *generator)
+{
+    g->generator = generator;
+}
+
+// set the replay log all placements and shots are recorded to
+void game_set_replay(Game *g, Replay *replay)
+{
+    g->replay = replay;
+}
+
+// generate an unbiased random integer number in the range [0,n[
+int game_random(Game *g, int n)
+{
+    return rnd_int(&g->random, n);
+}
+
+// place a ship with extent (height, width) at position (y, x) on a specific arena
+bool game_place_ship(Game *g, int player, int y, int x, int height, int width)
+{
+    if (!board_place_ship(&g->board[player], y, x, height, width))
+        return false;
+
+    if (g->replay)
+        replay_place(g->replay, player, y, x, height, width);
+
+    for (int i = y; i < y + height; i++)
+        for (int j = x; j < x + width; j++)
+            notify(g, player, i, j);
+
+    return true;
+}
+
+// automatically generate the fleet on a specific arena
+bool game_random_ships(Game *g, int player)
+{
+    Board *b = &g->board[player];
+    bool placed;
+
+    if (g->generator)
+        placed = fleetgen_generate(g->generator, b, &g->random);
+    else
+    {
+        FleetGen *generator = new FleetGen;
+        fleetgen_init(generator, &g->fleet, b->size);
+        placed = fleetgen_generate(generator, b, &g->random);
+        fleetgen_free(generator);
+        delete generator;
+    }
+
+    for (int k = 0; k < b->ships; k++)
+    {
+        const Ship *s = &b->ship[k];
+
+        if (g->replay)
+            replay_place(g->replay, player, s->y, s->x, s->height, s->width);
+
+        for (int i = s->y; i < s->y + s->height; i++)
+            for (int j = s->x; j < s->x + s->width; j++)
+                notify(g, player, i, j);
+    }
+
+    return placed;
+}
+
+// shoot at position (y, x) on a specific arena
+int game_shoot(Game *g, int player, int y, int x)
+{
+    int result = board_shoot(&g->board[player], y, x);
+
+    if (result != SHOT_NONE)
+    {
+        if (g->replay)
+            replay_shot(g->replay, player, y, x);
+
+        notify(g, player, y, x);
+    }
+
+    return result;
+}
+
+// mirror the cell state at position (y, x) on a specific arena
+void game_set_cell(Game *g, int player, int y, int x, int state)
+{
+    Board *b = &g->board[player];
+
+    if (y < 0 || x < 0 || y >= b->size || x >= b->size)
+        return;
+
+    board_set_cell(b, y, x, state);
+
+    notify(g, player, y, x);
+}
+
+// get the cell state at position (y, x) on a specific arena
+int game_get_cell(const Game *g, int player, int y, int x)
+{
+    return board_get_cell(&g->board[player], y, x);
+}
+
+// get the number of intact ship cells on a specific arena
+int game_ships_left(const Game *g, int player)
+{
+    return board_ships_left(&g->board[player]);
+}
+
+// check if the game is over
+bool game_over(const Game *g)
+{
+    return game_winner(g) >= 0;
+}
+
+// get the winner of the game
+int game_winner(const Game *g)
+{
+    if (g->board[1].ships > 0 && board_ships_left(&g->board[1]) == 0)
+        return 0;
+    if (g->board[0].ships > 0 && board_ships_left(&g->board[0]) == 0)
+        return 1;
+
+    return -1;
+}
@@ -0,0 +1,90 @@
+// Sink Ships game engine
+// * pure and reentrant game logic without any NCurses calls
+// * all state is kept in a Game struct, so that many games can run in parallel
+// * a renderer may observe the state changes via a callback
+
+#pragma once
+
+#include <stddef.h>
+
+#include "board.h"
+#include "fleetgen.h"
+#include "util.h"
+
+struct Replay;
+
+//! cell observer callback
+//! * called whenever the state of a cell changes
+//! * "player" is the owner of the arena, "state" is the new cell state
+typedef void (*CellObserver)(int player, int y, int x, int state, void *data);
+
+//! game state
+struct Game
+{
+    Board board[2];            // the arenas of both players
+    Fleet fleet;               // the fleet composition
+    const FleetGen *generator; // the shared fleet generator
+    Random random;             // the random number generator
+    CellObserver observer;     // the cell observer
+    void *observer_data;       // the user data passed to the observer
+    Replay *replay;            // the replay log all moves are recorded to
+};
+
+//! initialize a game with empty arenas
+//! * "fleet" is the fleet composition, the default fleet is used for NULL
+//! * "seed" and "stream" initialize the random number generator of the game,
+//!   games running in parallel should use the same seed with different streams
+//! * allocates the arenas, which are released by game_free
+void game_init(Game *g, const Fleet *fleet = NULL, uint64_t seed = 0, uint64_t stream = 0,
+               int size = board_default_size);
+
+//! release the arenas of a game
+void game_free(Game *g);
+
+//! set the cell observer
+//! * a NULL observer disables observation
+void game_set_observer(Game *g, CellObserver observer, void *data = NULL);
+
+//! set the fleet generator used by game_random_ships
+//! * the generator must have been initialized for the fleet and size of the game
+//! * a generator can be shared by many games, it is not owned by the game
+//! * without a generator a temporary one is created for each fleet, which counts the layouts each time
+void game_set_generator(Game *g, const FleetGen *generator);
+
+//! set the replay log all placements and shots are recorded to
+//! * a NULL log disables recording
+//! * the log is not owned by the game
+void game_set_replay(Game *g, Replay *replay);
+
+//! generate an unbiased random integer number in the range [0,n[
+int game_random(Game *g, int n);
+
+//! place a ship with extent (height, width) at position (y, x) on a specific arena
+//! * returns false if the ship cannot be placed
+bool game_place_ship(Game *g, int player, int y, int x, int height, int width);
+
+//! automatically generate the fleet on a specific arena
+//! * returns false if the fleet does not fit into the arena
+bool game_random_ships(Game *g, int player);
+
+//! shoot at position (y, x) on a specific arena
+//! * returns the shot result
+int game_shoot(Game *g, int player, int y, int x);
+
+//! mirror the cell state at position (y, x) on a specific arena
+//! * used by network clients, which only learn the shot results of a remote arena
+//! * the state is only stored for rendering, it does not place ships or count hits
+void game_set_cell(Game *g, int player, int y, int x, int state);
+
+//! get the cell state at position (y, x) on a specific arena
+int game_get_cell(const Game *g, int player, int y, int x);
+
+//! get the number of intact ship cells on a specific arena
+int game_ships_left(const Game *g, int player);
+
+//! check if the game is over
+bool game_over(const Game *g);
+
+//! get the winner of the game
+//! * returns -1 if the game is not over yet
+int game_winner(const Game *g);
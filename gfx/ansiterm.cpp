@@ -0,0 +1,441 @@
+// ANSI terminal output
+
+#include "ansiterm.h"
+
+#include <errno.h>
+
+// the attributes that are encoded as SGR parameters besides the colors
+static const int attr_flags = A_BOLD | A_DIM | A_UNDERLINE | A_BLINK | A_REVERSE;
+
+// the attributes of a cell that are kept by the terminal
+static const int attr_mask = attr_flags | A_COLOR;
+
+// the SGR parameter of each attribute flag
+static const struct {int flag; const char *param;} sgr_flags[] =
+{
+   {A_BOLD, "1"},
+   {A_DIM, "2"},
+   {A_UNDERLINE, "4"},
+   {A_BLINK, "5"},
+   {A_REVERSE, "7"}
+};
+
+// helper for reserving space in the buffer
+static void reserve(AnsiTerm *t, int bytes)
+{
+   if (t->bytes + bytes <= t->capacity) return;
+
+   int capacity = 2 * (t->bytes + bytes);
+   if (capacity < 4096) capacity = 4096;
+
+   unsigned char *data = new unsigned char[capacity];
+   if (t->data) memcpy(data, t->data, t->bytes);
+
+   delete[] t->data;
+   t->data = data;
+   t->capacity = capacity;
+}
+
+// helper for appending a string
+static void put_string(AnsiTerm *t, const char *s)
+{
+   int n = strlen(s);
+   reserve(t, n);
+   memcpy(t->data + t->bytes, s, n);
+   t->bytes += n;
+}
+
+// helper for appending a character
+static void put_char(AnsiTerm *t, char c)
+{
+   reserve(t, 1);
+   t->data[t->bytes++] = c;
+}
+
+// helper for appending a decimal number
+// * avoids snprintf, as a frame may contain thousands of numbers
+static void put_number(AnsiTerm *t, int v)
+{
+   char s[16];
+   int n = 0;
+
+   do
+   {
+      s[n++] = '0' + v % 10;
+      v /= 10;
+   }
+   while (v > 0);
+
+   reserve(t, n);
+   while (n > 0) t->data[t->bytes++] = s[--n];
+}
+
+// helper for appending a control sequence with a count parameter
+// * the count is omitted if it is 1, which is the default of the sequence
+static void put_sequence(AnsiTerm *t, int count, char final)
+{
+   put_string(t, "\033[");
+   if (count != 1) put_number(t, count);
+   put_char(t, final);
+}
+
+// helper for getting the number of decimal digits
+static int digits(int v)
+{
+   int n = 1;
+   while (v >= 10)
+   {
+      v /= 10;
+      n++;
+   }
+
+   return(n);
+}
+
+// helper for getting the length of a control sequence with a count parameter
+static int sequence_bytes(int count)
+{
+   return(count == 1 ? 3 : 3 + digits(count));
+}
+
+// helper for getting the length of an absolute cursor move (ESC [ row ; col H)
+// * the top-left corner and the first column omit their default parameters
+static int absolute_bytes(int y, int x)
+{
+   if (y == 0 && x == 0) return(3);
+   if (x == 0) return(3 + digits(y+1));
+   return(4 + digits(y+1) + digits(x+1));
+}
+
+// helper for moving the cursor within its row
+// * "dry" only returns the number of bytes
+static int move_horizontal(AnsiTerm *t, int x, bool dry)
+{
+   int dx = x - t->x;
+   if (dx == 0) return(0);
+
+   // a carriage return followed by a forward move
+   int cr = 1 + (x > 0 ? sequence_bytes(x) : 0);
+
+   int step;
+   if (dx > 0) step = sequence_bytes(dx);
+   else step = -dx < sequence_bytes(-dx) ? -dx : sequence_bytes(-dx);
+
+   if (dry) return(cr < step ? cr : step);
+
+   if (cr < step)
+   {
+      put_char(t, '\r');
+      if (x > 0) put_sequence(t, x, 'C');
+   }
+   else if (dx > 0)
+      put_sequence(t, dx, 'C');
+   else if (-dx < sequence_bytes(-dx))
+      for (int i=0; i<-dx; i++) put_char(t, '\b');
+   else
+      put_sequence(t, -dx, 'D');
+
+   return(cr < step ? cr : step);
+}
+
+// helper for moving the cursor with the shortest sequence
+// * relative moves do not scroll, as they stop at the margins of the screen
+static void move_cursor(AnsiTerm *t, int y, int x)
+{
+   if (t->y == y && t->x == x) return;
+
+   int absolute = absolute_bytes(y, x);
+
+   if (t->y >= 0 && t->x >= 0)
+   {
+      int dy = y - t->y;
+      int vertical = dy == 0 ? 0 : sequence_bytes(dy > 0 ? dy : -dy);
+      int relative = vertical + move_horizontal(t, x, true);
+
+      if (relative < absolute)
+      {
+         if (dy > 0) put_sequence(t, dy, 'B');
+         else if (dy < 0) put_sequence(t, -dy, 'A');
+
+         move_horizontal(t, x, false);
+
+         t->y = y;
+         t->x = x;
+         return;
+      }
+   }
+
+   put_string(t, "\033[");
+   if (y > 0 || x > 0) put_number(t, y+1);
+   if (x > 0)
+   {
+      put_char(t, ';');
+      put_number(t, x+1);
+   }
+   put_char(t, 'H');
+
+   t->y = y;
+   t->x = x;
+}
+
+// helper for getting the colors of a pair
+static void get_colors(const AnsiTerm *t, int attrs, int *fg, int *bg)
+{
+   int pair = PAIR_NUMBER(attrs);
+
+   *fg = *bg = -1;
+   if (pair < ansi_pairs)
+   {
+      *fg = t->fg[pair];
+      *bg = t->bg[pair];
+   }
+}
+
+// helper for changing the attributes with a single SGR sequence
+// * attributes that are switched off reset all attributes first,
+//   otherwise only the attributes and colors that change are set
+static void set_attrs(AnsiTerm *t, int attrs)
+{
+   bool reset = t->attrs < 0 || (t->attrs & attr_flags & ~attrs) != 0;
+   int old = reset ? 0 : t->attrs;
+
+   // a reset selects the default colors
+   int fg, bg, old_fg = -1, old_bg = -1;
+   get_colors(t, attrs, &fg, &bg);
+   if (!reset) get_colors(t, old, &old_fg, &old_bg);
+
+   int begin = t->bytes;
+   int params = 0;
+
+   put_string(t, "\033[");
+
+   if (reset)
+   {
+      put_char(t, '0');
+      params++;
+   }
+
+   for (size_t i=0; i<sizeof(sgr_flags)/sizeof(sgr_flags[0]); i++)
+      if ((attrs & sgr_flags[i].flag) && !(old & sgr_flags[i].flag))
+      {
+         if (params++) put_char(t, ';');
+         put_string(t, sgr_flags[i].param);
+      }
+
+   if (fg != old_fg)
+   {
+      if (params++) put_char(t, ';');
+      put_number(t, fg < 0 ? 39 : 30 + fg);
+   }
+
+   if (bg != old_bg)
+   {
+      if (params++) put_char(t, ';');
+      put_number(t, bg < 0 ? 49 : 40 + bg);
+   }
+
+   // nothing changes that the terminal shows
+   if (params == 0) t->bytes = begin;
+   else put_char(t, 'm');
+
+   t->attrs = attrs;
+}
+
+// initialize an ANSI terminal encoder
+void ansi_init(AnsiTerm *t, int fd, int lines, int cols)
+{
+   t->fd = fd;
+   t->lines = lines;
+   t->cols = cols;
+
+   t->data = NULL;
+   t->bytes = 0;
+   t->capacity = 0;
+
+   for (int i=0; i<ansi_pairs; i++)
+      t->fg[i] = t->bg[i] = -1;
+
+   // the color pairs of init_color, which also uses pair 1 as background
+   ansi_set_pair(t, 0, COLOR_WHITE, COLOR_BLACK);
+   ansi_set_pair(t, 1, COLOR_WHITE, COLOR_BLACK);
+   ansi_set_pair(t, 2, COLOR_RED, COLOR_BLACK);
+   ansi_set_pair(t, 3, COLOR_GREEN, COLOR_BLACK);
+   ansi_set_pair(t, 4, COLOR_BLUE, COLOR_BLACK);
+   ansi_set_pair(t, 5, COLOR_YELLOW, COLOR_BLACK);
+   ansi_set_pair(t, 6, COLOR_CYAN, COLOR_BLACK);
+   ansi_set_pair(t, 7, COLOR_MAGENTA, COLOR_BLACK);
+   ansi_set_pair(t, 8, COLOR_BLACK, COLOR_WHITE);
+   ansi_set_pair(t, 9, COLOR_BLACK, COLOR_BLACK);
+
+   t->frames = 0;
+   t->written = 0;
+
+   ansi_forget(t);
+}
+
+// release the buffer of an ANSI terminal encoder
+void ansi_free(AnsiTerm *t)
+{
+   delete[] t->data;
+   t->data = NULL;
+   t->bytes = 0;
+   t->capacity = 0;
+}
+
+// define the colors of a pair
+void ansi_set_pair(AnsiTerm *t, int pair, int fg, int bg)
+{
+   if (pair < 0 || pair >= ansi_pairs) return;
+
+   t->fg[pair] = fg < 0 ? -1 : fg & 7;
+   t->bg[pair] = bg < 0 ? -1 : bg & 7;
+
+   // the terminal may show the old colors of the pair
+   t->attrs = -1;
+}
+
+// forget the cursor position and the attributes
+void ansi_forget(AnsiTerm *t)
+{
+   t->y = t->x = -1;
+   t->attrs = -1;
+   t->charset = -1;
+}
+
+// clear the screen
+void ansi_clear(AnsiTerm *t)
+{
+   // the screen is erased with the background color of pair 0
+   t->attrs = -1;
+   set_attrs(t, 0);
+   put_string(t, "\033[H\033[2J");
+
+   t->y = t->x = 0;
+}
+
+// restore the normal attributes and character set
+void ansi_restore(AnsiTerm *t)
+{
+   put_string(t, "\033[0m\033(B");
+
+   // the default colors may differ from the colors of pair 0
+   t->attrs = -1;
+   t->charset = 0;
+}
+
+// add a run of n cells at screen position (y, x) to the frame
+void ansi_add_run(AnsiTerm *t, int y, int x, const int *cells, int n)
+{
+   if (y < 0 || y >= t->lines) return;
+
+   // clip the run to the screen
+   if (x < 0)
+   {
+      cells -= x;
+      n += x;
+      x = 0;
+   }
+
+   if (x + n > t->cols) n = t->cols - x;
+   if (n <= 0) return;
+
+   move_cursor(t, y, x);
+
+   // the characters of the run are appended without checking the space
+   reserve(t, n);
+
+   for (int i=0; i<n; i++)
+   {
+      int cell = cells[i];
+
+      if ((cell & attr_mask) != t->attrs)
+      {
+         set_attrs(t, cell & attr_mask);
+         reserve(t, n - i);
+      }
+
+      int charset = (cell & A_ALTCHARSET) ? 1 : 0;
+      if (charset != t->charset)
+      {
+         put_string(t, charset ? "\033(0" : "\033(B");
+         t->charset = charset;
+         reserve(t, n - i);
+      }
+
+      // non-printable characters are replaced, as they would move the cursor
+      int ch = cell & A_CHARTEXT;
+      if (ch < 32 || ch > 126) ch = ch == 0 ? ' ' : '?';
+
+      t->data[t->bytes++] = ch;
+   }
+
+   // the cursor position is undefined after writing the last column
+   t->x = x + n;
+   if (t->x >= t->cols)
+      t->y = t->x = -1;
+}
+
+// scroll the lines "top" to "bottom" up by n lines
+void ansi_scroll(AnsiTerm *t, int top, int bottom, int n)
+{
+   if (top < 0) top = 0;
+   if (bottom >= t->lines) bottom = t->lines-1;
+   if (n == 0 || top > bottom) return;
+
+   // set the scroll region
+   put_string(t, "\033[");
+   put_number(t, top+1);
+   put_char(t, ';');
+   put_number(t, bottom+1);
+   put_char(t, 'r');
+
+   // scroll up (SU) or down (SD)
+   put_sequence(t, n > 0 ? n : -n, n > 0 ? 'S' : 'T');
+
+   // reset the scroll region, which moves the cursor to the top-left corner
+   put_string(t, "\033[r");
+
+   t->y = t->x = 0;
+}
+
+// shift the cells of line y from column x to the right edge left by n columns
+void ansi_shift(AnsiTerm *t, int y, int x, int n)
+{
+   if (y < 0 || y >= t->lines) return;
+   if (x < 0 || x >= t->cols) return;
+   if (n == 0) return;
+
+   move_cursor(t, y, x);
+
+   // delete (DCH) or insert (ICH) characters at the cursor, which does not move
+   put_sequence(t, n > 0 ? n : -n, n > 0 ? 'P' : '@');
+}
+
+// write the frame with a single write()
+int ansi_flush(AnsiTerm *t)
+{
+   int bytes = t->bytes;
+   int offset = 0;
+
+   while (offset < bytes)
+   {
+      ssize_t n = write(t->fd, t->data + offset, bytes - offset);
+
+      if (n < 0)
+      {
+         if (errno == EINTR) continue;
+
+         t->bytes = 0;
+         ansi_forget(t);
+         return(-1);
+      }
+
+      offset += n;
+   }
+
+   t->bytes = 0;
+   t->frames++;
+   t->written += bytes;
+
+   return(bytes);
+}
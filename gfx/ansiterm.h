@@ -0,0 +1,81 @@
+// ANSI terminal output
+// * encodes runs of changed cells into ANSI escape sequences without NCurses
+// * the sequences of a frame are collected in one buffer, which is written with a single write()
+// * the encoder keeps track of the cursor position and the attributes of the terminal,
+//   so that each run only costs the cheapest cursor move and the attributes that change,
+//   also across runs and frames
+// * graphical characters (A_ALTCHARSET) use the DEC special graphics character set
+// * scrolled content is moved by the terminal with scroll regions and character deletion,
+//   so that only the exposed cells need to be encoded
+// * the output may be a terminal, a pseudo terminal or a capture file that is replayed with cat
+
+#pragma once
+
+#include "gfx.h"
+
+//! number of color pairs known to the encoder
+const int ansi_pairs = 64;
+
+//! ANSI terminal encoder
+struct AnsiTerm
+{
+   int fd;                     // the output, e.g. a terminal or a capture file
+   int lines, cols;            // the size of the terminal
+   unsigned char *data;        // the sequences of the frame
+   int bytes;                  // the number of bytes of the frame
+   int capacity;               // the size of the buffer
+   int y, x;                   // the cursor position, -1 if unknown
+   int attrs;                  // the attributes of the terminal without the character, -1 if unknown
+   int charset;                // 1 if the graphics character set is selected, 0 if not, -1 if unknown
+   signed char fg[ansi_pairs]; // the foreground color of each pair, -1 for the default color
+   signed char bg[ansi_pairs]; // the background color of each pair, -1 for the default color
+   long frames;                // the number of written frames
+   long written;               // the number of written bytes
+};
+
+//! initialize an ANSI terminal encoder
+//! * "fd" is the output, "lines" and "cols" is the size of the terminal
+//! * the color pairs are initialized like init_color() does,
+//!   pair 0 gets the colors of the background pair 1
+//! * the cursor position and the attributes are unknown until the first run or ansi_clear
+void ansi_init(AnsiTerm *t, int fd, int lines, int cols);
+
+//! release the buffer of an ANSI terminal encoder
+void ansi_free(AnsiTerm *t);
+
+//! define the colors of a pair
+//! * "fg" and "bg" are ANSI colors like COLOR_RED, -1 selects the default color
+//! * pair 0 is used by the cells without a color pair
+void ansi_set_pair(AnsiTerm *t, int pair, int fg, int bg);
+
+//! forget the cursor position and the attributes
+//! * e.g. after something else has written to the terminal
+void ansi_forget(AnsiTerm *t);
+
+//! clear the screen
+//! * the screen is erased with the colors of pair 0
+//! * the attributes are reset and the cursor moves to the top-left corner
+void ansi_clear(AnsiTerm *t);
+
+//! restore the normal attributes and character set
+//! * called before handing the terminal back
+void ansi_restore(AnsiTerm *t);
+
+//! add a run of n cells at screen position (y, x) to the frame
+//! * the cells are NCurses characters including their attributes
+void ansi_add_run(AnsiTerm *t, int y, int x, const int *cells, int n);
+
+//! scroll the lines "top" to "bottom" up by n lines
+//! * n < 0 scrolls down, the exposed lines are blank
+//! * uses a temporary scroll region (DECSTBM) and moves the cursor to the top-left corner
+void ansi_scroll(AnsiTerm *t, int top, int bottom, int n);
+
+//! shift the cells of line y from column x to the right edge left by n columns
+//! * n < 0 shifts right, the exposed cells are blank
+//! * deletes resp. inserts characters (DCH resp. ICH) at column x
+void ansi_shift(AnsiTerm *t, int y, int x, int n);
+
+//! write the frame with a single write()
+//! * further writes only happen if the output accepts less than the whole frame
+//! * returns the number of written bytes or -1 on error
+int ansi_flush(AnsiTerm *t);
@@ -0,0 +1,574 @@
+// ASCII GFX ANSI encoder test
+// * replays random streams of runs, scrolls and shifts on a headless NCurses screen
+//   and encodes the same stream with the ANSI encoder into a capture file
+// * the capture file is read back frame by frame into a small terminal emulator,
+//   whose screen has to match the NCurses screen after each frame
+// * the emulator knows the sequences the encoder emits: cursor moves, SGR attributes,
+//   the DEC special graphics character set, erasing, scroll regions and character deletion
+// * fixed sequences check that the encoder picks the shortest cursor move
+//   and merges the attributes of cells within a run, across runs and across frames
+//
+// usage: ansiterm_test [-frames=n] [-seed=n]
+// * returns 0 if all checks pass
+
+#include "gfx.h"
+#include "ansiterm.h"
+
+#include <fcntl.h>
+
+// size of the screen
+static const int lines = 24;
+static const int cols = 80;
+
+// the attributes that are encoded as SGR parameters besides the colors
+static const int attr_flags = A_BOLD | A_DIM | A_UNDERLINE | A_BLINK | A_REVERSE;
+
+// cell attributes the random runs are drawn from, few so that runs share them
+static const int palette[] =
+{
+   0,
+   COLOR_PAIR(2),
+   COLOR_PAIR(3),
+   COLOR_PAIR(3) | A_BOLD,
+   COLOR_PAIR(5) | A_REVERSE,
+   COLOR_PAIR(8) | A_UNDERLINE,
+   COLOR_PAIR(6) | A_ALTCHARSET
+};
+
+// launch parameters
+static int frames = 500; // the number of random frames (option -frames=n)
+static uint64_t seed = 1; // the seed of the random frames (option -seed=n)
+
+static int failures = 0; // the number of failed checks
+
+// emulated cell
+struct EmuCell
+{
+   int ch;     // the character including A_ALTCHARSET
+   int flags;  // the SGR attribute flags
+   int fg, bg; // the colors, -1 for the default color
+};
+
+// emulated terminal
+struct Emu
+{
+   EmuCell cell[lines][cols];
+   int y, x;          // the cursor position
+   int top, bottom;   // the scroll region
+   EmuCell pen;       // the attributes of written and erased cells
+   bool graphics;     // the graphics character set is selected
+   int state;         // 0 for text, 1 after ESC, 2 in a control sequence, 3 after ESC (
+   int param[16];     // the parameters of the control sequence
+   int params;        // the number of parameters
+   bool error;        // an unknown sequence or a write beyond the right margin
+};
+
+// helper for reporting a failed check
+static void fail(const char *what, int frame)
+{
+   if (failures++ < 10)
+      fprintf(stderr, "frame %d: %s\n", frame, what);
+}
+
+// helper for erasing the cells of a row from column x1 to x2 with the colors of the pen
+static void emu_erase(Emu *e, int y, int x1, int x2)
+{
+   for (int x=x1; x<=x2; x++)
+   {
+      e->cell[y][x].ch = ' ';
+      e->cell[y][x].flags = 0;
+      e->cell[y][x].fg = e->pen.fg;
+      e->cell[y][x].bg = e->pen.bg;
+   }
+}
+
+// helper for scrolling the scroll region up by n lines, n < 0 scrolls down
+static void emu_scroll(Emu *e, int n)
+{
+   int height = e->bottom - e->top + 1;
+   if (n > height) n = height;
+   if (n < -height) n = -height;
+
+   if (n > 0)
+   {
+      for (int y=e->top; y<=e->bottom-n; y++)
+         memcpy(e->cell[y], e->cell[y+n], sizeof(e->cell[y]));
+      for (int y=e->bottom-n+1; y<=e->bottom; y++)
+         emu_erase(e, y, 0, cols-1);
+   }
+   else if (n < 0)
+   {
+      for (int y=e->bottom; y>=e->top-n; y--)
+         memcpy(e->cell[y], e->cell[y+n], sizeof(e->cell[y]));
+      for (int y=e->top; y<e->top-n; y++)
+         emu_erase(e, y, 0, cols-1);
+   }
+}
+
+// helper for selecting the graphic rendition
+static void emu_sgr(Emu *e)
+{
+   if (e->params == 0) e->param[e->params++] = 0;
+
+   for (int i=0; i<e->params; i++)
+   {
+      int p = e->param[i];
+
+      if (p == 0)
+      {
+         e->pen.flags = 0;
+         e->pen.fg = e->pen.bg = -1;
+      }
+      else if (p == 1) e->pen.flags |= A_BOLD;
+      else if (p == 2) e->pen.flags |= A_DIM;
+      else if (p == 4) e->pen.flags |= A_UNDERLINE;
+      else if (p == 5) e->pen.flags |= A_BLINK;
+      else if (p == 7) e->pen.flags |= A_REVERSE;
+      else if (p >= 30 && p <= 37) e->pen.fg = p - 30;
+      else if (p == 39) e->pen.fg = -1;
+      else if (p >= 40 && p <= 47) e->pen.bg = p - 40;
+      else if (p == 49) e->pen.bg = -1;
+      else e->error = true;
+   }
+}
+
+// helper for executing a control sequence
+static void emu_sequence(Emu *e, char final)
+{
+   int n = e->params > 0 && e->param[0] > 0 ? e->param[0] : 1;
+
+   // relative moves stop at the margins of the screen
+   switch (final)
+   {
+   case 'H':
+      e->y = n - 1;
+      e->x = (e->params > 1 && e->param[1] > 0 ? e->param[1] : 1) - 1;
+      if (e->y >= lines) e->y = lines-1;
+      if (e->x >= cols) e->x = cols-1;
+      break;
+   case 'A': e->y = e->y-n < 0 ? 0 : e->y-n; break;
+   case 'B': e->y = e->y+n >= lines ? lines-1 : e->y+n; break;
+   case 'C': e->x = e->x+n >= cols ? cols-1 : e->x+n; break;
+   case 'D': e->x = (e->x >= cols ? cols-1 : e->x) - n; if (e->x < 0) e->x = 0; break;
+   case 'm': emu_sgr(e); break;
+   case 'J':
+      if (e->params != 1 || e->param[0] != 2) e->error = true;
+      for (int y=0; y<lines; y++) emu_erase(e, y, 0, cols-1);
+      break;
+   case 'r':
+      e->top = e->params > 0 && e->param[0] > 0 ? e->param[0] - 1 : 0;
+      e->bottom = e->params > 1 && e->param[1] > 0 ? e->param[1] - 1 : lines-1;
+      if (e->bottom >= lines || e->top >= e->bottom)
+      {
+         e->error = true;
+         e->top = 0;
+         e->bottom = lines-1;
+      }
+      e->y = e->x = 0;
+      break;
+   case 'S': emu_scroll(e, n); break;
+   case 'T': emu_scroll(e, -n); break;
+   case 'P':
+      if (e->x >= cols) break;
+      if (n > cols - e->x) n = cols - e->x;
+      memmove(&e->cell[e->y][e->x], &e->cell[e->y][e->x+n], (cols - e->x - n)*sizeof(EmuCell));
+      emu_erase(e, e->y, cols-n, cols-1);
+      break;
+   case '@':
+      if (e->x >= cols) break;
+      if (n > cols - e->x) n = cols - e->x;
+      memmove(&e->cell[e->y][e->x+n], &e->cell[e->y][e->x], (cols - e->x - n)*sizeof(EmuCell));
+      emu_erase(e, e->y, e->x, e->x+n-1);
+      break;
+   default:
+      e->error = true;
+   }
+}
+
+// helper for feeding the emulator with a byte of the capture
+static void emu_put(Emu *e, unsigned char c)
+{
+   switch (e->state)
+   {
+   case 1:
+      if (c == '[')
+      {
+         e->state = 2;
+         e->params = 0;
+         e->param[0] = 0;
+      }
+      else if (c == '(') e->state = 3;
+      else
+      {
+         e->error = true;
+         e->state = 0;
+      }
+      return;
+
+   case 2:
+      if (c >= '0' && c <= '9')
+      {
+         if (e->params == 0) e->params = 1;
+         e->param[e->params-1] = e->param[e->params-1]*10 + c - '0';
+      }
+      else if (c == ';')
+      {
+         if (e->params == 0) e->params = 1;
+         if (e->params < 16) e->param[e->params++] = 0;
+      }
+      else
+      {
+         emu_sequence(e, c);
+         e->state = 0;
+      }
+      return;
+
+   case 3:
+      if (c == '0') e->graphics = true;
+      else if (c == 'B') e->graphics = false;
+      else e->error = true;
+      e->state = 0;
+      return;
+   }
+
+   if (c == 27) e->state = 1;
+   else if (c == '\r') e->x = 0;
+   else if (c == '\b')
+   {
+      if (e->x >= cols) e->x = cols-1;
+      if (e->x > 0) e->x--;
+   }
+   else if (c < 32 || c > 126) e->error = true;
+   else if (e->x >= cols) e->error = true;
+   else
+   {
+      // the cursor stays behind the last column, where the encoder forgets its position
+      EmuCell *cell = &e->cell[e->y][e->x++];
+      *cell = e->pen;
+      cell->ch = c | (e->graphics ? A_ALTCHARSET : 0);
+   }
+}
+
+// helper for resolving an NCurses cell into the colors of the encoder
+static EmuCell resolve(const AnsiTerm *t, chtype ch)
+{
+   EmuCell c;
+   c.ch = ch & (A_CHARTEXT | A_ALTCHARSET);
+   c.flags = ch & attr_flags;
+   c.fg = t->fg[PAIR_NUMBER(ch)];
+   c.bg = t->bg[PAIR_NUMBER(ch)];
+   return(c);
+}
+
+// helper for comparing the emulated screen with the NCurses screen
+// * the foreground color of a blank cell is only visible with underline or reverse video
+static bool same_screen(const AnsiTerm *t, const Emu *e)
+{
+   for (int y=0; y<lines; y++)
+      for (int x=0; x<cols; x++)
+      {
+         EmuCell a = resolve(t, mvinch(y, x));
+         const EmuCell *b = &e->cell[y][x];
+
+         bool blank = (a.ch & A_CHARTEXT) == ' ' && !(a.flags & (A_UNDERLINE | A_REVERSE));
+
+         if (a.ch != b->ch || a.flags != b->flags || a.bg != b->bg || (!blank && a.fg != b->fg))
+            return(false);
+      }
+
+   return(true);
+}
+
+// helper for drawing a run of cells on both screens
+// * the run may exceed the screen, both sides clip it
+static void draw_run(AnsiTerm *t, Random *r, int y, int x, int n)
+{
+   int cells[cols+16];
+
+   int attrs = palette[rnd_int(r, sizeof(palette)/sizeof(palette[0]))];
+
+   for (int i=0; i<n; i++)
+   {
+      // most cells keep the attributes of the previous one
+      if (rnd_int(r, 4) == 0) attrs = palette[rnd_int(r, sizeof(palette)/sizeof(palette[0]))];
+
+      int ch = rnd_int(r, 3) == 0 ? ' ' : (attrs & A_ALTCHARSET) ? 'j' + rnd_int(r, 14) : 33 + rnd_int(r, 94);
+      cells[i] = ch | attrs;
+
+      if (y >= 0 && y < lines && x+i >= 0 && x+i < cols)
+         mvaddch(y, x+i, cells[i]);
+   }
+
+   ansi_add_run(t, y, x, cells, n);
+}
+
+// helper for scrolling the lines "top" to "bottom" on both screens
+// * the exposed lines are redrawn, as the terminal erases them with its current background
+static void draw_scroll(AnsiTerm *t, Random *r, int top, int bottom, int n)
+{
+   int old_top = 0, old_bottom = lines-1;
+   wgetscrreg(stdscr, &old_top, &old_bottom);
+
+   scrollok(stdscr, TRUE);
+   wsetscrreg(stdscr, top, bottom);
+   wscrl(stdscr, n);
+   wsetscrreg(stdscr, old_top, old_bottom);
+   scrollok(stdscr, FALSE);
+
+   ansi_scroll(t, top, bottom, n);
+
+   int y1 = n > 0 ? bottom-n+1 : top;
+   int y2 = n > 0 ? bottom : top-n-1;
+   for (int y=y1; y<=y2; y++)
+      draw_run(t, r, y, 0, cols);
+}
+
+// helper for shifting the cells of line y from column x on both screens
+// * the exposed cells are redrawn, as the terminal erases them with its current background
+static void draw_shift(AnsiTerm *t, Random *r, int y, int x, int n)
+{
+   move(y, x);
+   for (int i=0; i<n; i++) delch();
+   for (int i=0; i<-n; i++) insch(' ');
+
+   ansi_shift(t, y, x, n);
+
+   if (n > 0)
+      draw_run(t, r, y, cols-n, n);
+   else
+      draw_run(t, r, y, x, x-n > cols ? cols-x : -n);
+}
+
+// helper for feeding the emulator with the frames that were written to the capture file
+static void replay_capture(int fd, long *offset, Emu *e)
+{
+   unsigned char data[4096];
+
+   while (true)
+   {
+      ssize_t n = pread(fd, data, sizeof(data), *offset);
+      if (n <= 0) break;
+
+      for (ssize_t i=0; i<n; i++)
+         emu_put(e, data[i]);
+
+      *offset += n;
+   }
+}
+
+// helper for checking the sequences of the frame that is buffered by an encoder
+// * the frame is discarded afterwards
+static void expect(AnsiTerm *t, const char *sequences, const char *what)
+{
+   int n = strlen(sequences);
+
+   if (t->bytes != n || memcmp(t->data, sequences, n) != 0)
+   {
+      if (failures++ < 10)
+         fprintf(stderr, "%s: got %d bytes instead of %d\n", what, t->bytes, n);
+   }
+
+   t->bytes = 0;
+}
+
+// helper for encoding a run of a string with the same attributes
+static void add_text(AnsiTerm *t, int y, int x, const char *text, int attrs)
+{
+   int cells[cols];
+   int n = strlen(text);
+
+   for (int i=0; i<n; i++)
+      cells[i] = text[i] | attrs;
+
+   ansi_add_run(t, y, x, cells, n);
+}
+
+// check the cursor moves and the attribute changes of fixed runs
+static void test_sequences()
+{
+   AnsiTerm t;
+   ansi_init(&t, open("/dev/null", O_WRONLY), lines, cols);
+
+   // the clear selects the colors of pair 0
+   ansi_clear(&t);
+   expect(&t, "\033[0;37;40m\033[H\033[2J", "clear");
+
+   // absolute moves are cheaper across rows and columns
+   add_text(&t, 4, 10, "ab", 0);
+   expect(&t, "\033[5;11H\033(Bab", "absolute move");
+
+   // a short gap is skipped forward
+   add_text(&t, 4, 14, "c", 0);
+   expect(&t, "\033[2Cc", "forward move");
+
+   // a single backspace is shorter than a backward sequence
+   add_text(&t, 4, 14, "d", 0);
+   expect(&t, "\bd", "backspace");
+
+   // the first column of the next row is addressed absolutely
+   add_text(&t, 5, 0, "e", 0);
+   expect(&t, "\033[6He", "row start");
+
+   // a move down within the column is relative
+   add_text(&t, 9, 1, "f", 0);
+   expect(&t, "\033[4Bf", "down move");
+
+   // the top-left corner needs no parameters
+   add_text(&t, 0, 0, "g", 0);
+   expect(&t, "\033[Hg", "home");
+
+   // a run with the same attributes sets them once
+   add_text(&t, 0, 1, "xyz", COLOR_PAIR(2));
+   expect(&t, "\033[31mxyz", "run attributes");
+
+   // a later run with the same attributes sets nothing
+   add_text(&t, 2, 1, "uv", COLOR_PAIR(2));
+   expect(&t, "\033[3;2Huv", "merged attributes");
+
+   // only the added flag and the changed color are set
+   int cells[] = {'a' | COLOR_PAIR(2) | A_BOLD, 'b' | COLOR_PAIR(3) | A_BOLD};
+   ansi_add_run(&t, 2, 3, cells, 2);
+   expect(&t, "\033[1ma\033[32mb", "changed attributes");
+
+   // a removed flag resets the attributes
+   add_text(&t, 2, 5, "c", COLOR_PAIR(3));
+   expect(&t, "\033[0;32;40mc", "removed flag");
+
+   // graphics characters switch the character set within the run
+   int graphics[] = {'q' | COLOR_PAIR(3) | A_ALTCHARSET, 'd' | COLOR_PAIR(3)};
+   ansi_add_run(&t, 2, 6, graphics, 2);
+   expect(&t, "\033(0q\033(Bd", "character set");
+
+   // the attributes are kept across frames
+   ansi_flush(&t);
+   add_text(&t, 2, 8, "e", COLOR_PAIR(3));
+   expect(&t, "e", "frame attributes");
+
+   // the cursor position is unknown after the last column
+   add_text(&t, 3, cols-1, "f", COLOR_PAIR(3));
+   expect(&t, "\033[4;80Hf", "last column");
+   add_text(&t, 3, cols-2, "g", COLOR_PAIR(3));
+   expect(&t, "\033[4;79Hg", "after the last column");
+
+   close(t.fd);
+   ansi_free(&t);
+}
+
+// check random frames against NCurses
+static void test_frames()
+{
+   FILE *capture = tmpfile();
+   if (!capture)
+   {
+      fail("cannot create the capture file", 0);
+      return;
+   }
+
+   AnsiTerm t;
+   ansi_init(&t, fileno(capture), lines, cols);
+
+   Emu e;
+   memset(&e, 0, sizeof(e));
+   e.bottom = lines-1;
+   e.pen.fg = e.pen.bg = -1;
+
+   long offset = 0;
+
+   Random r;
+   rnd_seed(&r, seed);
+
+   clear();
+   ansi_clear(&t);
+
+   for (int f=0; f<frames; f++)
+   {
+      int ops = 1 + rnd_int(&r, 8);
+
+      for (int o=0; o<ops; o++)
+      {
+         int op = rnd_int(&r, 10);
+
+         if (op == 0)
+         {
+            int top = rnd_int(&r, lines-1);
+            int bottom = top + 1 + rnd_int(&r, lines-top-1);
+            int n = 1 + rnd_int(&r, bottom-top);
+            draw_scroll(&t, &r, top, bottom, rnd_int(&r, 2) ? n : -n);
+         }
+         else if (op == 1)
+         {
+            int x = rnd_int(&r, cols-1);
+            int n = 1 + rnd_int(&r, cols-x-1);
+            draw_shift(&t, &r, rnd_int(&r, lines), x, rnd_int(&r, 2) ? n : -n);
+         }
+         else
+            draw_run(&t, &r, rnd_int(&r, lines+2)-1, rnd_int(&r, cols+8)-8, 1 + rnd_int(&r, cols/2));
+      }
+
+      if (ansi_flush(&t) < 0)
+      {
+         fail("cannot write the capture file", f);
+         break;
+      }
+
+      replay_capture(t.fd, &offset, &e);
+
+      if (e.error)
+      {
+         fail("unexpected sequence", f);
+         break;
+      }
+
+      if (!same_screen(&t, &e))
+      {
+         fail("screens differ", f);
+         break;
+      }
+   }
+
+   fclose(capture);
+   ansi_free(&t);
+}
+
+// main method
+int main(int argc, char *argv[])
+{
+   for (int i=1; get_opt(i, argc, argv) != NULL; i++)
+   {
+      double value;
+      const char *opt = get_opt(i, argc, argv, &value);
+
+      if (strpre("frames", opt) == 0)
+         frames = value;
+      else if (strpre("seed", opt) == 0)
+         seed = value;
+      else
+      {
+         fprintf(stderr, "unknown option: %s\n", opt);
+         return(1);
+      }
+   }
+
+   if (!init_gfx_headless(cols, lines))
+   {
+      fprintf(stderr, "no terminal description is available\n");
+      return(1);
+   }
+
+   init_color();
+
+   test_sequences();
+   test_frames();
+
+   exit_gfx();
+
+   if (failures > 0)
+   {
+      fprintf(stderr, "%d checks failed\n", failures);
+      return(1);
+   }
+
+   printf("all checks passed\n");
+
+   return(0);
+}
@@ -0,0 +1,306 @@
+// NCurses frame delta encoding
+
+#include "framedelta.h"
+
+#include <string.h>
+
+// minimum number of equal characters that are encoded as a repeated character
+static const int min_repeat = 4;
+
+// maximum number of cells passed to the decoder callback at once
+static const int max_span = 256;
+
+// the character bits of a cell
+static const int char_mask = 0xFF;
+
+// helper for reserving space in the buffer
+static void reserve(FrameDelta *d, int bytes)
+{
+   if (d->bytes + bytes <= d->capacity) return;
+
+   int capacity = 2 * (d->bytes + bytes);
+   if (capacity < 1024) capacity = 1024;
+
+   unsigned char *data = new unsigned char[capacity];
+   if (d->data) memcpy(data, d->data, d->bytes);
+
+   delete[] d->data;
+   d->data = data;
+   d->capacity = capacity;
+}
+
+// helper for appending an unsigned varint
+static void put_varint(FrameDelta *d, unsigned int v)
+{
+   while (v >= 0x80)
+   {
+      d->data[d->bytes++] = (v & 0x7F) | 0x80;
+      v >>= 7;
+   }
+
+   d->data[d->bytes++] = v;
+}
+
+// helper for appending a signed varint
+static void put_signed(FrameDelta *d, int v)
+{
+   put_varint(d, ((unsigned int)v << 1) ^ (unsigned int)(v >> 31));
+}
+
+// helper for reading an unsigned varint
+static bool get_varint(const unsigned char *buf, int bytes, int *pos, unsigned int *v)
+{
+   *v = 0;
+
+   for (int shift = 0; shift < 35; shift += 7)
+   {
+      if (*pos >= bytes) return(false);
+
+      unsigned char b = buf[(*pos)++];
+      *v |= (unsigned int)(b & 0x7F) << shift;
+
+      if (!(b & 0x80)) return(true);
+   }
+
+   return(false);
+}
+
+// helper for reading a signed varint
+static bool get_signed(const unsigned char *buf, int bytes, int *pos, int *v)
+{
+   unsigned int u;
+   if (!get_varint(buf, bytes, pos, &u)) return(false);
+
+   *v = (int)(u >> 1) ^ -(int)(u & 1);
+   return(true);
+}
+
+// helper for reading a 16 bit little endian integer
+static int get_u16(const unsigned char *buf)
+{
+   return(buf[0] | (buf[1] << 8));
+}
+
+// helper for appending a segment of cells with equal attributes
+static void put_segment(FrameDelta *d, int y, int x, const int *cells, int n, bool repeat)
+{
+   int attrs = cells[0] & ~char_mask;
+
+   reserve(d, 4 * 5 + (repeat ? 1 : n));
+
+   put_signed(d, y - d->y);
+   put_signed(d, x - d->x);
+   put_varint(d, ((unsigned int)n << 2) | (repeat ? 2 : 0) | (attrs == d->attrs ? 1 : 0));
+
+   if (attrs != d->attrs)
+      put_varint(d, (unsigned int)attrs >> 8);
+
+   if (repeat)
+      d->data[d->bytes++] = cells[0] & char_mask;
+   else
+      for (int i=0; i<n; i++)
+         d->data[d->bytes++] = cells[i] & char_mask;
+
+   d->y = y;
+   d->x = x + n;
+   d->attrs = attrs;
+   d->runs++;
+}
+
+// initialize an empty frame delta encoder
+void delta_init(FrameDelta *d)
+{
+   d->data = NULL;
+   d->bytes = 0;
+   d->capacity = 0;
+
+   delta_clear(d);
+}
+
+// release the buffer of a frame delta encoder
+void delta_free(FrameDelta *d)
+{
+   delete[] d->data;
+
+   d->data = NULL;
+   d->bytes = 0;
+   d->capacity = 0;
+}
+
+// remove all encoded frames
+void delta_clear(FrameDelta *d)
+{
+   d->bytes = 0;
+   d->start = 0;
+   d->lines = d->cols = 0;
+   d->runs = 0;
+   d->y = d->x = 0;
+   d->attrs = 0;
+}
+
+// begin a new frame
+void delta_begin(FrameDelta *d, int lines, int cols, bool keyframe)
+{
+   if (lines < 0) lines = 0;
+   if (lines > delta_max_size) lines = delta_max_size;
+   if (cols < 0) cols = 0;
+   if (cols > delta_max_size) cols = delta_max_size;
+
+   reserve(d, delta_header_bytes);
+
+   d->start = d->bytes;
+   d->bytes += delta_header_bytes;
+   d->data[d->start + 4] = keyframe ? DELTA_KEYFRAME : 0;
+   d->data[d->start + 5] = lines & 0xFF;
+   d->data[d->start + 6] = (lines >> 8) & 0xFF;
+   d->data[d->start + 7] = cols & 0xFF;
+   d->data[d->start + 8] = (cols >> 8) & 0xFF;
+
+   d->lines = lines;
+   d->cols = cols;
+
+   d->runs = 0;
+   d->y = d->x = 0;
+   d->attrs = 0;
+}
+
+// add a run of n changed cells at screen position (y, x) to the frame
+void delta_add_run(FrameDelta *d, int y, int x, const int *cells, int n)
+{
+   // clip the run to the screen, which the decoder checks
+   if (y < 0 || y >= d->lines) return;
+
+   if (x < 0)
+   {
+      cells -= x;
+      n += x;
+      x = 0;
+   }
+
+   if (x + n > d->cols) n = d->cols - x;
+
+   int i = 0;
+
+   while (i < n)
+   {
+      // find the span of equal attributes
+      int attrs = cells[i] & ~char_mask;
+      int j = i + 1;
+      while (j < n && (cells[j] & ~char_mask) == attrs) j++;
+
+      // split off the repeated characters
+      int literal = i;
+      for (int k=i; k<j;)
+      {
+         int r = k + 1;
+         while (r < j && cells[r] == cells[k]) r++;
+
+         if (r - k >= min_repeat)
+         {
+            if (k > literal) put_segment(d, y, x + literal, cells + literal, k - literal, false);
+            put_segment(d, y, x + k, cells + k, r - k, true);
+            literal = r;
+         }
+
+         k = r;
+      }
+
+      if (j > literal) put_segment(d, y, x + literal, cells + literal, j - literal, false);
+
+      i = j;
+   }
+}
+
+// end the frame
+int delta_end(FrameDelta *d)
+{
+   int bytes = d->bytes - d->start;
+
+   d->data[d->start] = bytes & 0xFF;
+   d->data[d->start + 1] = (bytes >> 8) & 0xFF;
+   d->data[d->start + 2] = (bytes >> 16) & 0xFF;
+   d->data[d->start + 3] = (bytes >> 24) & 0xFF;
+
+   return(bytes);
+}
+
+// get the number of bytes of the first frame of a buffer
+int delta_frame_bytes(const unsigned char *buf, int bytes)
+{
+   if (bytes < delta_header_bytes) return(0);
+
+   int length = buf[0] | (buf[1] << 8) | (buf[2] << 16) | (buf[3] << 24);
+
+   if (length < delta_header_bytes) return(-1);
+   if (bytes < length) return(0);
+
+   return(length);
+}
+
+// decode a complete frame
+bool delta_decode(const unsigned char *frame, int bytes, DeltaFunc func, void *data, bool *keyframe)
+{
+   if (delta_frame_bytes(frame, bytes) != bytes) return(false);
+
+   if (keyframe) *keyframe = frame[4] & DELTA_KEYFRAME;
+
+   int lines = get_u16(frame + 5);
+   int cols = get_u16(frame + 7);
+   if (lines > delta_max_size || cols > delta_max_size) return(false);
+
+   // each cell of the screen is changed at most once
+   long cells = (long)lines * cols;
+
+   int pos = delta_header_bytes;
+   int y = 0, x = 0;
+   int attrs = 0;
+   int span[max_span];
+
+   while (pos < bytes)
+   {
+      int dy, dx;
+      unsigned int header, a;
+
+      if (!get_signed(frame, bytes, &pos, &dy)) return(false);
+      if (!get_signed(frame, bytes, &pos, &dx)) return(false);
+      if (!get_varint(frame, bytes, &pos, &header)) return(false);
+
+      if (!(header & 1))
+      {
+         if (!get_varint(frame, bytes, &pos, &a)) return(false);
+         attrs = (int)(a << 8);
+      }
+
+      bool repeat = header & 2;
+      unsigned int n = header >> 2;
+
+      // the run must be within the screen
+      if (dy < -lines || dy > lines || dx < -cols || dx > cols) return(false);
+
+      y += dy;
+      x += dx;
+
+      if (y < 0 || y >= lines || x < 0 || x > cols) return(false);
+      if (n > (unsigned int)(cols - x) || (long)n > cells) return(false);
+
+      cells -= n;
+
+      if (pos + (repeat ? 1 : (int)n) > bytes) return(false);
+
+      // the cells are passed on in chunks
+      for (int i=0; i<(int)n; i+=max_span)
+      {
+         int m = (int)n - i < max_span ? (int)n - i : max_span;
+
+         for (int k=0; k<m; k++)
+            span[k] = frame[repeat ? pos : pos + i + k] | attrs;
+
+         func(y, x + i, span, m, data);
+      }
+
+      pos += repeat ? 1 : (int)n;
+      x += n;
+   }
+
+   return(true);
+}
@@ -0,0 +1,86 @@
+// NCurses frame delta encoding
+// * encodes the changed cells of a frame as a compact stream of runs
+// * a run is a span of changed cells within a row that share their attributes,
+//   spans of four or more equal characters are encoded as a single repeated character
+// * a frame starts with its length as 32 bit little endian integer, a flag byte
+//   and the screen size as 16 bit little endian lines and columns,
+//   followed by the runs, all numbers within a frame are LEB128 varints:
+//  * the row and column of a run relative to the end of the previous run (zigzag encoded)
+//  * the number of cells shifted left by two, or'ed with a repeat flag (bit 1)
+//    and a flag for unchanged attributes (bit 0)
+//  * the attributes without the character (shifted right by 8 bits) if they have changed
+//  * the characters, a single one for repeated characters
+// * the decoder rejects runs outside of the screen and frames that change more cells
+//   than the screen has, so that a corrupt frame cannot cause unbounded work
+
+#pragma once
+
+#include <stddef.h>
+
+//! frame flags
+enum DeltaFlags
+{
+   DELTA_KEYFRAME = 1 // the frame contains all cells, the receiver clears the screen first
+};
+
+//! size of the frame header
+const int delta_header_bytes = 9;
+
+//! maximum number of lines resp. columns of the screen of a frame
+const int delta_max_size = 4096;
+
+//! frame delta encoder
+struct FrameDelta
+{
+   unsigned char *data; // the encoded frames
+   int bytes;           // the number of encoded bytes
+   int capacity;        // the size of the buffer
+   int start;           // the position of the frame that is encoded
+   int lines, cols;     // the screen size of the frame
+   int runs;            // the number of runs of the frame
+   int y, x;            // the row and column after the previous run
+   int attrs;           // the attributes of the previous run
+};
+
+//! frame delta decoder callback
+//! * called for each decoded span of cells at screen position (y, x)
+typedef void (*DeltaFunc)(int y, int x, const int *cells, int n, void *data);
+
+//! initialize an empty frame delta encoder
+void delta_init(FrameDelta *d);
+
+//! release the buffer of a frame delta encoder
+void delta_free(FrameDelta *d);
+
+//! remove all encoded frames
+void delta_clear(FrameDelta *d);
+
+//! begin a new frame
+//! * "lines" and "cols" is the size of the screen the runs are drawn to,
+//!   at most delta_max_size each
+//! * "keyframe" tells the receiver that all visible cells follow
+void delta_begin(FrameDelta *d, int lines, int cols, bool keyframe = false);
+
+//! add a run of n changed cells at screen position (y, x) to the frame
+//! * the cells are NCurses characters including their attributes
+//! * runs are clipped to the screen of the frame
+//! * each cell may be changed at most once per frame
+void delta_add_run(FrameDelta *d, int y, int x, const int *cells, int n);
+
+//! end the frame
+//! * returns the number of bytes of the frame including its header
+int delta_end(FrameDelta *d);
+
+//! get the number of bytes of the first frame of a buffer
+//! * returns 0 if the frame is not complete yet
+//! * returns -1 if the length of the frame is corrupt,
+//!   the stream cannot be resynchronized then
+int delta_frame_bytes(const unsigned char *buf, int bytes);
+
+//! decode a complete frame
+//! * calls "func" for each decoded span of cells
+//! * "keyframe" receives the keyframe flag
+//! * returns false if the frame is corrupt, e.g. if a run is outside of the screen of the frame
+//!   or the frame changes more cells than the screen has,
+//!   the spans before the corrupt run have been passed to "func" already
+bool delta_decode(const unsigned char *frame, int bytes, DeltaFunc func, void *data = NULL, bool *keyframe = NULL);
@@ -3,12 +3,21 @@
 
 #include "gfx.h"
 #include "gridfont.h"
+#include "profiler.h"
+
+#include <poll.h>
 
 static WINDOW *W = NULL; // the drawing window
 
 static char *string_buffer = NULL; // the string buffer
 static int buffer_size = 0; // the string buffer size
 
+static int watched_fd = -1; // the additionally watched input
+
+static SCREEN *headless_screen = NULL; // the screen without a terminal
+static FILE *headless_out = NULL; // the discarded output of the headless screen
+static FILE *headless_in = NULL; // the empty input of the headless screen
+
 // init ASCII GFX
 void init_gfx()
 {
@@ -21,6 +30,37 @@ void init_gfx()
    push(); // init matrix stack
 }
 
+// init ASCII GFX without a terminal
+bool init_gfx_headless(int sx, int sy)
+{
+   headless_out = fopen("/dev/null", "w");
+   headless_in = fopen("/dev/null", "r");
+   if (!headless_out || !headless_in) return(false);
+
+   // try the actual terminal type first and fall back to common ones
+   const char *terms[] = {getenv("TERM"), "xterm", "vt100"};
+   for (int i=0; i<3 && !headless_screen; i++)
+      if (terms[i])
+         headless_screen = newterm(terms[i], headless_out, headless_in);
+
+   if (!headless_screen)
+   {
+      fclose(headless_out);
+      fclose(headless_in);
+      headless_out = headless_in = NULL;
+      return(false);
+   }
+
+   resize_term(sy, sx); // the size of the virtual screen
+   curs_set(FALSE); // disable text cursor
+   timeout(0); // configure getch() to be non-blocking
+   keypad(stdscr, TRUE); // configure getch() to return cursor key codes
+   noecho(); // do not echo keyboard input
+   push(); // init matrix stack
+
+   return(true);
+}
+
 // init ASCII GFX color display
 void init_color()
 {
@@ -43,12 +83,30 @@ void exit_gfx()
    // restore normal terminal behaviour before exiting
    endwin();
 
+   // release the headless screen
+   if (headless_screen)
+   {
+      delscreen(headless_screen);
+      fclose(headless_out);
+      fclose(headless_in);
+      headless_screen = NULL;
+      headless_out = headless_in = NULL;
+   }
+
    // deallocate string buffer
    delete[] string_buffer;
    string_buffer = NULL;
    buffer_size = 0;
 }
 
+// refresh the screen
+void refresh_gfx()
+{
+   ProfileScope scope(PROFILE_REFRESH);
+
+   refresh();
+}
+
 // set the drawing window
 void set_window(WINDOW *w)
 {
@@ -58,31 +116,41 @@ void set_window(WINDOW *w)
 // use indexed color pair for foreground/background colors of characters
 void use_color(int index)
 {
-   color_set(index, NULL);
+   WINDOW *w = W?W:stdscr;
+
+   wcolor_set(w, index, NULL);
 }
 
 // use attribute bold
 void use_attr_bold()
 {
-   attron(A_BOLD);
+   WINDOW *w = W?W:stdscr;
+
+   wattron(w, A_BOLD);
 }
 
 // use attribute blink
 void use_attr_blink()
 {
-   attron(A_BLINK);
+   WINDOW *w = W?W:stdscr;
+
+   wattron(w, A_BLINK);
 }
 
 // use attribute reverse
 void use_attr_reverse()
 {
-   attron(A_REVERSE);
+   WINDOW *w = W?W:stdscr;
+
+   wattron(w, A_REVERSE);
 }
 
 // use attribute normal
 void use_attr_normal()
 {
-   attrset(A_NORMAL);
+   WINDOW *w = W?W:stdscr;
+
+   wattrset(w, A_NORMAL);
 }
 
 // draw a formatted text at position (x, y)
@@ -99,10 +167,12 @@ void draw_text(int y, int x,
    vsnprintf(text, n+1, format, argp);
    va_end(argp);
 
-   move(y, x);
+   WINDOW *w = W?W:stdscr;
+
+   wmove(w, y, x);
    int c = strlen(text);
    for (int i=0; i<c; i++)
-      addch(isprint(text[i])?text[i]:' ');
+      waddch(w, isprint(text[i])?text[i]:' ');
 }
 
 // draw a sprite at barycenter position (x, y)
@@ -514,10 +584,53 @@ int peek(int y, int x)
    return(mvwinch(w, y, x) & A_CHARTEXT);
 }
 
+// helper for reading a buffered keycode without waiting
+static int read_keycode()
+{
+   ProfileScope scope(PROFILE_INPUT);
+
+   return(wgetch(stdscr));
+}
+
 // return wide keycode
 int get_keycode()
 {
-   return(wgetch(stdscr));
+   return(read_keycode());
+}
+
+// wait for a wide keycode
+int wait_keycode(float ms)
+{
+   struct pollfd fds[2];
+
+   fds[0].fd = STDIN_FILENO;
+   fds[0].events = POLLIN;
+   fds[1].fd = watched_fd;
+   fds[1].events = POLLIN;
+
+   // keys may already be buffered by NCurses
+   int keycode = read_keycode();
+
+   while (keycode == ERR)
+   {
+      // a resize signal interrupts the poll and is reported as KEY_RESIZE
+      fds[0].revents = fds[1].revents = 0;
+      poll(fds, watched_fd<0?1:2, ms<0?-1:(int)ceil(ms));
+      keycode = read_keycode();
+
+      // stop after the first wakeup with a timeout, on a closed stdin or on watched input
+      if (ms >= 0) break;
+      if (fds[0].revents & (POLLERR | POLLHUP | POLLNVAL)) break;
+      if (fds[1].revents) break;
+   }
+
+   return(keycode);
+}
+
+// watch an additional input while waiting for a keycode
+void watch_input(int fd)
+{
+   watched_fd = fd;
 }
 
 // decode wide keycode
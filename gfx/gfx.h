@@ -20,6 +20,12 @@
 //! * the screen origin (0, 0) is at the top left corner
 void init_gfx();
 
+//! init ASCII GFX without a terminal
+//! * setup a virtual screen whose output is discarded, e.g. for benchmarks
+//! * "sx" and "sy" is the size of the virtual screen
+//! * returns false if no terminal description is available
+bool init_gfx_headless(int sx = 80, int sy = 24);
+
 //! init ASCII GFX color display
 //! * default colors are white, red, green, blue with indices 1-4
 //! * and composite colors yellow, cyan, magenta with indices 5-7
@@ -30,8 +36,14 @@ void init_color();
 //! * close the standard screen of NCurses
 void exit_gfx();
 
+//! refresh the screen
+//! * outputs the changes of the standard screen to the terminal
+//! * the time spent is profiled, see profiler.h
+void refresh_gfx();
+
 //! set the drawing window
 //! * by default the standard screen is used
+//! * colors, attributes, texts, sprites, lines and frames apply to the drawing window
 void set_window(WINDOW *w);
 
 //! use indexed color pair for foreground/background colors of characters
@@ -116,6 +128,19 @@ int peek(int y, int x);
 //! return wide keycode
 int get_keycode();
 
+//! wait for a wide keycode
+//! * sleeps on stdin until a key is pressed instead of polling getch() in a busy loop
+//! * "ms" is the timeout in milli seconds, a negative timeout waits forever
+//! * returns ERR if the timeout has passed without a key press
+//! * returns KEY_RESIZE if the terminal has been resized
+//! * returns ERR as well if the watched input has become readable
+int wait_keycode(float ms = -1);
+
+//! watch an additional input while waiting for a keycode
+//! * "fd" is a file descriptor like a network socket, -1 disables watching
+//! * the watched input needs to be read by the application to not wake up again
+void watch_input(int fd);
+
 //! decode wide keycode
 //! * if a cursor event has been observed as a wide keycode, the function decodes it
 //! * the function returns a corresponding direction vector (dx, dy) via call-by-reference
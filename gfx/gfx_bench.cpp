@@ -0,0 +1,368 @@
+// ASCII GFX micro benchmarks
+// * times the hot paths of the library against a headless screen whose output is discarded
+// * each benchmark runs on canvas areas from 80x24 up to 4096x4096 cells,
+//   the displayed window follows the canvas size up to the size of a large terminal
+// * reports the time per call and per processed cell as CSV or JSON
+//
+// usage: gfx_bench [-size=n] [-time=ms] [-json]
+// * "size" limits the largest canvas to n x n cells
+// * "time" is the minimum measuring time of each benchmark in milli seconds
+
+#include "gfx.h"
+#include "scrollarea.h"
+#include "gridarea.h"
+#include "gridfont.h"
+#include "polygon.h"
+
+#include <time.h>
+#include <fcntl.h>
+
+// canvas sizes
+static const int canvases = 4;
+static const int canvas_x[canvases] = {80, 256, 1024, 4096};
+static const int canvas_y[canvases] = {24, 256, 1024, 4096};
+
+// size of a large terminal
+static const int screen_x = 320;
+static const int screen_y = 100;
+
+// largest flood-filled region, the recursive fill needs a stack frame per cell
+static const int fill_size = 128;
+
+// size of the sprites
+static const int sprite_x = 16;
+static const int sprite_y = 8;
+
+// launch parameters
+static int max_size = 4096; // the largest canvas size (option -size=n)
+static double min_time = 200; // the minimum measuring time in milli seconds (option -time=ms)
+static bool json = false; // print JSON instead of CSV (option -json)
+
+static bool first = true; // the next result is the first one
+static int sx = 0, sy = 0; // the actual canvas size
+static int wx = 0, wy = 0; // the actual window size
+static int param = 0; // the parameter of the actual benchmark
+static AnsiTerm term; // the ANSI terminal encoder whose output is discarded
+
+// benchmark function
+// * "i" is the number of the call
+// * returns the number of processed cells
+typedef long (*BenchFunc)(int i);
+
+// helper for getting the monotonic clock in seconds
+static double get_seconds()
+{
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return(t.tv_sec + t.tv_nsec * 1E-9);
+}
+
+// helper for filling the canvas area with a varying pattern
+static void fill_pattern()
+{
+   for (int y=0; y<sy; y++)
+      for (int x=0; x<sx; x++)
+         set_cell(x, y, (x*7 + y*13) % 5 ? ' ' : 'a' + (x + y) % 26);
+}
+
+// helper for enabling area-relative sprites spread over the displayed window
+static void enable_sprites(int n)
+{
+   disable_sprites();
+
+   for (int k=0; k<n; k++)
+   {
+      enable_sprite(k, sprite_x, sprite_y);
+      clear_sprite(k, '0' + k % 10);
+      set_sprite_position(k, (k * 37) % (wx > sprite_x ? wx - sprite_x : 1),
+                             (k * 11) % (wy > sprite_y ? wy - sprite_y : 1));
+   }
+}
+
+// helper for printing a result
+static void print_result(const char *name, long calls, double seconds, long cells)
+{
+   double ns_call = seconds * 1E9 / calls;
+   double ns_cell = cells > 0 ? seconds * 1E9 / cells : 0;
+
+   if (json)
+   {
+      printf("%s  {\"benchmark\": \"%s\", \"param\": %d, \"width\": %d, \"height\": %d, "
+             "\"window_width\": %d, \"window_height\": %d, \"calls\": %ld, "
+             "\"ns_per_call\": %.1f, \"ns_per_cell\": %.3f}",
+             first?"":",\n",
+             name, param, sx, sy, wx, wy, calls, ns_call, ns_cell);
+   }
+   else
+   {
+      if (first)
+         printf("benchmark,param,width,height,window_width,window_height,calls,ns_per_call,ns_per_cell\n");
+
+      printf("%s,%d,%d,%d,%d,%d,%ld,%.1f,%.3f\n",
+             name, param, sx, sy, wx, wy, calls, ns_call, ns_cell);
+   }
+
+   fflush(stdout);
+   first = false;
+}
+
+// helper for running a benchmark until the minimum measuring time has passed
+static void run(const char *name, BenchFunc func)
+{
+   func(0); // warm up
+
+   long calls = 0, cells = 0;
+   double start = get_seconds();
+   double seconds = 0;
+
+   do
+   {
+      cells += func(++calls);
+      seconds = get_seconds() - start;
+   }
+   while (seconds*1000 < min_time);
+
+   print_result(name, calls, seconds, cells);
+}
+
+// redraw an unchanged window
+static long bench_redraw_static(int)
+{
+   redraw_window(0, 0);
+   return(wx*wy);
+}
+
+// redraw a window that alternates between two positions, so that most cells change
+static long bench_redraw_scroll(int i)
+{
+   redraw_window(i & 1, 0);
+   return(wx*wy);
+}
+
+// redraw a window that alternates between two positions with the ANSI terminal encoder
+static long bench_redraw_ansi(int i)
+{
+   redraw_window(i & 1, 0);
+   ansi_flush(&term);
+   return(wx*wy);
+}
+
+// scroll the displayed window up and down by one row with the ANSI terminal encoder
+static long bench_scroll_window_ansi(int i)
+{
+   scroll_window(0, i & 1, 0, 0, false);
+   ansi_flush(&term);
+   return(wx*wy);
+}
+
+// render a star polygon with "param" vertices around the center of the canvas
+static long bench_polygon(int i)
+{
+   Vec2 *v = new Vec2[param];
+
+   float rx = sx/2.0f, ry = sy/2.0f;
+   for (int k=0; k<param; k++)
+   {
+      float a = 2*M_PI*k/param;
+      float r = (k & 1) ? 0.5f : 1.0f;
+      v[k] = vec2(rx + r*(rx - 1)*cos(a), ry + r*(ry - 1)*sin(a));
+   }
+
+   render_polygon(param, v, i & 1 ? '#' : '*');
+
+   delete[] v;
+   return((long)sx*sy);
+}
+
+// flood-fill a framed region with alternating characters
+static long bench_flood_fill(int i)
+{
+   flood_fill(1, 1, i & 1 ? 'a' : 'b');
+   return((long)(param - 2)*(param - 2));
+}
+
+// scroll the canvas area up
+static long bench_scroll_up(int)
+{
+   scroll_area_up();
+   return((long)sx*sy);
+}
+
+// scroll the canvas area down
+static long bench_scroll_down(int)
+{
+   scroll_area_down(1);
+   return((long)sx*sy);
+}
+
+// scroll the canvas area left
+static long bench_scroll_left(int)
+{
+   scroll_area_left(1);
+   return((long)sx*sy);
+}
+
+// scroll the canvas area right
+static long bench_scroll_right(int)
+{
+   scroll_area_right(1);
+   return((long)sx*sy);
+}
+
+// update a grid window whose grid characters all change
+static long bench_grid_window(int i)
+{
+   int gx = get_grid_width(), gy = get_grid_height();
+
+   for (int y=0; y<gy; y++)
+      for (int x=0; x<gx; x++)
+         set_grid(x, y, (x + y + i) & 1 ? 'X' : 'O');
+
+   update_grid_window();
+
+   return((long)gx*gy*get_grid_char_cols()*get_grid_char_lines());
+}
+
+// render a text with grid font characters
+static long bench_grid_text(int i)
+{
+   const char *text = i & 1 ? "THE QUICK BROWN FOX 0123456789" : "JUMPS OVER THE LAZY DOG 9876543";
+   render_grid_text(0, 0, text);
+   return((long)strlen(text)*get_grid_char_cols()*get_grid_char_lines());
+}
+
+// detect the collision of an opaque sprite with a transparent one, so that all cells are checked
+static long bench_collision(int)
+{
+   detect_sprite_collision(0, 1);
+   return(get_sprite_width(0)*get_sprite_height(0));
+}
+
+// run all benchmarks on a canvas area
+static void bench_canvas(int x, int y)
+{
+   sx = x;
+   sy = y;
+   wx = sx < screen_x ? sx : screen_x;
+   wy = sy < screen_y ? sy : screen_y;
+
+   set_area_size(sx, sy);
+   set_window_size(wx, wy);
+
+   // the encoded terminal has the size of the displayed window, so that scroll steps are moved by the terminal
+   term.cols = wx;
+   term.lines = wy;
+
+   // redraw with 0, 8 and 64 sprites
+   static const int sprite_counts[] = {0, 8, 64};
+   for (int k=0; k<3; k++)
+   {
+      param = sprite_counts[k];
+      if (param > get_sprite_num()) continue;
+
+      fill_pattern();
+      enable_sprites(param);
+      touch_window();
+      redraw_window(0, 0);
+
+      run("redraw_window_static", bench_redraw_static);
+      run("redraw_window_scroll", bench_redraw_scroll);
+
+      set_window_term(&term);
+      run("redraw_window_ansi", bench_redraw_ansi);
+      run("scroll_window_ansi", bench_scroll_window_ansi);
+      set_window_term(NULL);
+   }
+
+   disable_sprites();
+
+   // polygons with varied vertex counts
+   static const int vertex_counts[] = {3, 16, 128};
+   for (int k=0; k<3; k++)
+   {
+      param = vertex_counts[k];
+      clear_area();
+      run("render_polygon", bench_polygon);
+   }
+
+   // flood fill of a framed region
+   param = fill_size;
+   if (param > sx) param = sx;
+   if (param > sy) param = sy;
+   clear_area();
+   render_frame(0, 0, param - 1, param - 1, '|');
+   run("flood_fill", bench_flood_fill);
+
+   // scrolling in all directions
+   param = 1;
+   fill_pattern();
+   run("scroll_area_up", bench_scroll_up);
+   run("scroll_area_down", bench_scroll_down);
+   run("scroll_area_left", bench_scroll_left);
+   run("scroll_area_right", bench_scroll_right);
+
+   // sprite collision detection
+   param = 0;
+   enable_sprite(0, sx < 64 ? sx : 64, sy < 32 ? sy : 32);
+   clear_sprite(0, '#');
+   enable_sprite(1, get_sprite_width(0), get_sprite_height(0));
+   run("detect_sprite_collision", bench_collision);
+   disable_sprites();
+
+   // grid font rendering replaces the canvas area by a grid area of the same size
+   param = 0;
+   set_grid_size(sx / get_grid_char_cols(), sy / get_grid_char_lines());
+   set_window_size(wx, wy);
+   run("render_grid_text", bench_grid_text);
+   run("update_grid_window", bench_grid_window);
+
+   release_grid();
+}
+
+// main method
+int main(int argc, char *argv[])
+{
+   for (int i=1; get_opt(i, argc, argv) != NULL; i++)
+   {
+      double value;
+      const char *opt = get_opt(i, argc, argv, &value);
+
+      if (strpre("size", opt) == 0)
+         max_size = value;
+      else if (strpre("time", opt) == 0)
+         min_time = value;
+      else if (strpre("json", opt) == 0)
+         json = true;
+      else
+      {
+         fprintf(stderr, "unknown option: %s\n", opt);
+         return(1);
+      }
+   }
+
+   if (!init_gfx_headless(screen_x, screen_y))
+   {
+      fprintf(stderr, "no terminal description is available\n");
+      return(1);
+   }
+
+   int fd = open("/dev/null", O_WRONLY);
+   ansi_init(&term, fd, screen_y, screen_x);
+
+   if (json)
+      printf("[\n");
+
+   for (int c=0; c<canvases; c++)
+      if (canvas_x[c] <= max_size && canvas_y[c] <= max_size)
+         bench_canvas(canvas_x[c], canvas_y[c]);
+
+   if (json)
+      printf("\n]\n");
+
+   exit_gfx();
+
+   ansi_free(&term);
+   close(fd);
+
+   return(0);
+}
@@ -5,6 +5,7 @@
 
 #include "scrollarea.h"
 #include "gridfont.h"
+#include "profiler.h"
 
 static int gridx = 0, gridy = 0; // the size of the scrollable grid area
 static int fontx = 0, fonty = 0; // the size of the grid font
@@ -500,6 +501,8 @@ void update_grid_window()
 {
    static int frame = 0;
 
+   ProfileScope scope(PROFILE_GRID);
+
    for (int i=0; i<gridx; i++)
       for (int j=0; j<gridy; j++)
       {
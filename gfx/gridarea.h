@@ -102,6 +102,11 @@ void set_grid_animation(int ch, int num, const int *data);
 //! set character animation string
 void set_grid_animation_string(int ch, const char *str);
 
+//! update the canvas area with the changed grid cells
+//! * renders the grid chars that changed or are animated since the last update
+//! * called by redraw_grid_window and scroll_grid_window before redrawing
+void update_grid_window();
+
 //! redraw the displayed grid window at center grid position (x, y)
 void redraw_grid_window(int x, int y);
 
@@ -3,6 +3,7 @@
 
 #include "polygon.h"
 #include "scrollarea.h"
+#include "profiler.h"
 
 // 2D line edge type
 struct Edge2D
@@ -126,6 +127,8 @@ void render_polygon(int n, const Vec2 vertex[],
    if (n < 3) return;
    if (ch < 0) ch = ACS_CKBOARD;
 
+   ProfileScope scope(PROFILE_POLYGON);
+
    // transform vertex list
    Vec2 *v = new Vec2[n];
    Mat3 M = top();
@@ -0,0 +1,306 @@
+// NCurses frame profiler
+
+#include "profiler.h"
+#include "scrollarea.h"
+
+#include <time.h>
+
+// names of the profiled zones
+static const char *zone_names[PROFILE_ZONES] = {"redraw_window", "update_grid_window", "render_polygon", "input", "refresh"};
+
+// names of the counters
+static const char *counter_names[PROFILE_COUNTERS] = {"composed", "changed", "bytes"};
+
+// minimum time between two updates of the HUD in seconds
+static const double hud_period = 0.5;
+
+static bool enabled = false; // the profiler is enabled
+static double start = 0; // the time the profiler has been enabled
+static ProfileFrame current; // the actual frame
+
+static ProfileFrame frame_ring[profile_frames]; // the recorded frames
+static unsigned int frame_head = 0; // the number of recorded frames
+static ProfileEvent event_ring[profile_events]; // the recorded zones
+static unsigned int event_head = 0; // the number of recorded zones
+
+static double hud_time = 0; // the time the HUD has been updated
+
+// helper for getting the monotonic clock in seconds
+static double get_seconds()
+{
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return(t.tv_sec + t.tv_nsec * 1E-9);
+}
+
+// helper for beginning a frame
+static void begin_frame(int frame, double begin)
+{
+   memset(&current, 0, sizeof(current));
+   current.frame = frame;
+   current.begin = begin;
+}
+
+// helper for copying the latest entries of a ring buffer
+// * the entries are copied first and the entries that the writer
+//   may have overwritten in the meantime are dropped afterwards
+static int copy_ring(const void *ring, int size, unsigned int capacity,
+                     const unsigned int *head,
+                     void *out, int max)
+{
+   unsigned int h = __atomic_load_n(head, __ATOMIC_ACQUIRE);
+
+   // the slot after the last published entry may be written already
+   unsigned int n = h < capacity ? h : capacity - 1;
+   if (max < 0) max = 0;
+   if (n > (unsigned int)max) n = max;
+
+   unsigned int first = h - n;
+   for (unsigned int i=0; i<n; i++)
+      memcpy((char *)out + i*size, (const char *)ring + ((first + i) & (capacity - 1))*size, size);
+
+   __atomic_thread_fence(__ATOMIC_ACQUIRE);
+   unsigned int h2 = __atomic_load_n(head, __ATOMIC_RELAXED);
+
+   // drop the entries that the writer has overwritten while copying
+   unsigned int skip = 0;
+   if (h2 - first >= capacity)
+      skip = h2 - first - capacity + 1;
+   if (skip > n)
+      skip = n;
+
+   memmove(out, (char *)out + skip*size, (n - skip)*size);
+
+   return(n - skip);
+}
+
+// enable or disable the profiler
+void profile_enable(bool yes)
+{
+   if (yes && !enabled)
+   {
+      start = get_seconds();
+      __atomic_store_n(&frame_head, 0, __ATOMIC_RELEASE);
+      __atomic_store_n(&event_head, 0, __ATOMIC_RELEASE);
+      begin_frame(0, 0);
+      hud_time = -hud_period;
+   }
+
+   enabled = yes;
+}
+
+// is the profiler enabled?
+bool profile_enabled()
+{
+   return(enabled);
+}
+
+// get the time in seconds since the profiler has been enabled
+double profile_time()
+{
+   return(get_seconds() - start);
+}
+
+// begin a timed zone
+double profile_begin()
+{
+   if (!enabled) return(-1);
+
+   return(profile_time());
+}
+
+// end a timed zone
+void profile_end(int zone, double begin)
+{
+   if (!enabled || begin < 0) return;
+   if (zone < 0 || zone >= PROFILE_ZONES) return;
+
+   double end = profile_time();
+   current.zone[zone] += end - begin;
+
+   ProfileEvent *e = &event_ring[event_head & (profile_events - 1)];
+   e->frame = current.frame;
+   e->zone = zone;
+   e->begin = begin;
+   e->end = end;
+
+   __atomic_store_n(&event_head, event_head + 1, __ATOMIC_RELEASE);
+}
+
+// add n to a counter of the actual frame
+void profile_count(int counter, int n)
+{
+   if (!enabled) return;
+   if (counter < 0 || counter >= PROFILE_COUNTERS) return;
+
+   current.counter[counter] += n;
+}
+
+// end the actual frame and begin the next one
+void profile_frame()
+{
+   if (!enabled) return;
+
+   current.end = profile_time();
+   frame_ring[frame_head & (profile_frames - 1)] = current;
+
+   __atomic_store_n(&frame_head, frame_head + 1, __ATOMIC_RELEASE);
+
+   begin_frame(current.frame + 1, current.end);
+}
+
+// get the recorded frames
+int profile_get_frames(ProfileFrame *frames, int max)
+{
+   return(copy_ring(frame_ring, sizeof(ProfileFrame), profile_frames, &frame_head, frames, max));
+}
+
+// get the recorded zones
+int profile_get_events(ProfileEvent *events, int max)
+{
+   return(copy_ring(event_ring, sizeof(ProfileEvent), profile_events, &event_head, events, max));
+}
+
+// get a summary of the latest frames
+const char *profile_summary(int frames)
+{
+   static ProfileFrame latest[profile_frames];
+   static char summary[256];
+
+   if (frames > profile_frames) frames = profile_frames;
+   int n = profile_get_frames(latest, frames);
+
+   double work = 0, peak = 0;
+   double zone[PROFILE_ZONES] = {0};
+   double counter[PROFILE_COUNTERS] = {0};
+
+   for (int i=0; i<n; i++)
+   {
+      double w = 0;
+      for (int z=0; z<PROFILE_ZONES; z++)
+      {
+         zone[z] += latest[i].zone[z];
+         w += latest[i].zone[z];
+      }
+
+      for (int c=0; c<PROFILE_COUNTERS; c++)
+         counter[c] += latest[i].counter[c];
+
+      work += w;
+      if (w > peak) peak = w;
+   }
+
+   double fps = 0;
+   if (n > 0)
+   {
+      double span = latest[n-1].end - latest[0].begin;
+      if (span > 0) fps = n / span;
+
+      work /= n;
+      for (int z=0; z<PROFILE_ZONES; z++) zone[z] /= n;
+      for (int c=0; c<PROFILE_COUNTERS; c++) counter[c] /= n;
+   }
+
+   snprintf(summary, sizeof(summary),
+            "frame %.2fms max %.2fms %.1f fps\n"
+            "redraw %.2f grid %.2f poly %.2f input %.2f refresh %.2f\n"
+            "cells %.0f composed %.0f changed %.0f bytes",
+            work*1000, peak*1000, fps,
+            zone[PROFILE_REDRAW]*1000, zone[PROFILE_GRID]*1000, zone[PROFILE_POLYGON]*1000,
+            zone[PROFILE_INPUT]*1000, zone[PROFILE_REFRESH]*1000,
+            counter[PROFILE_COMPOSED], counter[PROFILE_CHANGED], counter[PROFILE_BYTES]);
+
+   return(summary);
+}
+
+// show the summary of the latest frames in a window-relative sprite
+void profile_hud(int num)
+{
+   if (!enabled) return;
+
+   const int sx = 56, sy = 3;
+
+   if (num < 0) num = get_sprite_num()-2;
+
+   double t = profile_time();
+   if (t - hud_time < hud_period && (!has_window() || is_sprite_enabled(num))) return;
+   hud_time = t;
+
+   const char *text = profile_summary();
+
+   if (has_window())
+   {
+      if (!is_sprite_enabled(num))
+         enable_sprite(num, sx, sy, true);
+
+      set_sprite_position(num, 1, get_window_height() - sy - 1);
+      clear_sprite(num, ' ');
+      print_sprite_text(num, 0, 0, text);
+   }
+   else
+   {
+      // without a displayed window the summary is drawn into the bottom lines of the screen
+      for (int line=LINES-sy; *text; line++)
+      {
+         const char *eol = strchr(text, '\n');
+         int n = eol?eol-text:strlen(text);
+
+         draw_text(line, 0, "%-*.*s", sx, n, text);
+
+         text += n;
+         if (*text) text++;
+      }
+   }
+}
+
+// export the recorded frames and zones as Chrome trace events
+bool profile_export_trace(const char *path)
+{
+   FILE *file = fopen(path, "w");
+   if (!file) return(false);
+
+   ProfileFrame *frames = new ProfileFrame[profile_frames];
+   ProfileEvent *events = new ProfileEvent[profile_events];
+
+   int nf = profile_get_frames(frames, profile_frames);
+   int ne = profile_get_events(events, profile_events);
+
+   fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+   fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"ASCII GFX\"}}");
+
+   // the frames and their counters
+   for (int i=0; i<nf; i++)
+   {
+      const ProfileFrame *f = &frames[i];
+
+      fprintf(file, ",\n{\"name\":\"frame\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+                    "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%d}}",
+              f->begin*1E6, (f->end - f->begin)*1E6, f->frame);
+
+      fprintf(file, ",\n{\"name\":\"cells\",\"ph\":\"C\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"args\":{",
+              f->end*1E6);
+      for (int c=0; c<PROFILE_COUNTERS; c++)
+         fprintf(file, "%s\"%s\":%d", c>0?",":"", counter_names[c], f->counter[c]);
+      fprintf(file, "}}");
+   }
+
+   // the timed zones
+   for (int i=0; i<ne; i++)
+   {
+      const ProfileEvent *e = &events[i];
+
+      fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"gfx\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+                    "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%d}}",
+              zone_names[e->zone], e->begin*1E6, (e->end - e->begin)*1E6, e->frame);
+   }
+
+   fprintf(file, "\n]}\n");
+
+   delete[] frames;
+   delete[] events;
+
+   bool ok = !ferror(file);
+   if (fclose(file) != 0) ok = false;
+
+   return(ok);
+}
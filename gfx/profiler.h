@@ -0,0 +1,130 @@
+// NCurses frame profiler
+// * measures the time spent in the zones of a frame with scoped timers
+//   and counts the composed, changed and emitted cells of each frame
+// * the frames and the timed zones are kept in lock-free ring buffers,
+//   so that another thread can read them while new frames are recorded
+// * the frames are summarized in a HUD sprite
+//   and exported as Chrome trace events, see chrome://tracing or ui.perfetto.dev
+// * a disabled profiler costs a single branch per scope and counter
+
+#pragma once
+
+#include <stddef.h>
+
+//! profiled zones of a frame
+enum ProfileZone
+{
+   PROFILE_REDRAW = 0, // redraw_window
+   PROFILE_GRID,       // update_grid_window
+   PROFILE_POLYGON,    // render_polygon
+   PROFILE_INPUT,      // reading keys without waiting for them
+   PROFILE_REFRESH,    // refreshing the terminal
+   PROFILE_ZONES       // the number of zones
+};
+
+//! counters of a frame
+enum ProfileCounter
+{
+   PROFILE_COMPOSED = 0, // the number of cells composed from the canvas and the sprites
+   PROFILE_CHANGED,      // the number of changed cells drawn to the screen
+   PROFILE_BYTES,        // the estimated number of bytes emitted to the terminal
+   PROFILE_COUNTERS      // the number of counters
+};
+
+//! number of frames kept by the profiler (a power of two)
+const int profile_frames = 256;
+
+//! number of timed zones kept by the profiler (a power of two)
+const int profile_events = 4096;
+
+//! profiled frame
+struct ProfileFrame
+{
+   int frame;                     // the number of the frame
+   double begin;                  // the begin of the frame in seconds
+   double end;                    // the end of the frame in seconds
+   double zone[PROFILE_ZONES];    // the time spent per zone in seconds
+   int counter[PROFILE_COUNTERS]; // the counters of the frame
+};
+
+//! timed zone
+struct ProfileEvent
+{
+   int frame;    // the number of the frame
+   int zone;     // the profiled zone
+   double begin; // the begin of the zone in seconds
+   double end;   // the end of the zone in seconds
+};
+
+//! enable or disable the profiler
+//! * enabling the profiler discards the recorded frames and starts a new frame
+void profile_enable(bool yes = true);
+
+//! is the profiler enabled?
+bool profile_enabled();
+
+//! get the time in seconds since the profiler has been enabled
+double profile_time();
+
+//! begin a timed zone
+//! * returns the begin time to be passed to profile_end
+double profile_begin();
+
+//! end a timed zone
+void profile_end(int zone, double begin);
+
+//! scoped timer
+//! * times the zone from its construction to the end of the enclosing scope
+struct ProfileScope
+{
+   int zone;
+   double begin;
+
+   ProfileScope(int z)
+   {
+      zone = z;
+      begin = profile_begin();
+   }
+
+   ~ProfileScope()
+   {
+      profile_end(zone, begin);
+   }
+};
+
+//! add n to a counter of the actual frame
+void profile_count(int counter, int n);
+
+//! end the actual frame and begin the next one
+void profile_frame();
+
+//! get the recorded frames
+//! * copies at most "max" of the latest frames in their recorded order
+//! * may be called from another thread while frames are recorded
+//! * returns the number of copied frames
+int profile_get_frames(ProfileFrame *frames, int max);
+
+//! get the recorded zones
+//! * copies at most "max" of the latest zones in their recorded order
+//! * may be called from another thread while frames are recorded
+//! * returns the number of copied zones
+int profile_get_events(ProfileEvent *events, int max);
+
+//! get a summary of the latest frames
+//! * the average and maximum work time and the average time spent per zone and counters
+//! * returns a string buffer that is valid until the next call
+const char *profile_summary(int frames = 60);
+
+//! show the summary of the latest frames in a window-relative sprite
+//! * "num" is the number of the sprite, by default the second to last one
+//! * the sprite is shown in the bottom left corner of the displayed window
+//! * without a displayed window the summary is drawn into the bottom lines of the screen
+//! * the summary is updated at most twice per second, so that the HUD stays readable
+//!   and does not change the counted cells of each frame
+void profile_hud(int num = -1);
+
+//! export the recorded frames and zones as Chrome trace events
+//! * the file is in the JSON object format with complete events per frame and zone
+//!   and counter events per frame, the time stamps are micro seconds since enabling
+//! * returns false if the file cannot be written
+bool profile_export_trace(const char *path);
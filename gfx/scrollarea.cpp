@@ -4,7 +4,16 @@
 #include "scrollarea.h"
 
 #include <stdarg.h>
+#include <stdint.h>
 #include "gridfont.h"
+#include "profiler.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 static int sizex = 0, sizey = 0; // the size of the scrollable area
 static int winx = 0, winy = 0; // the size of the displayed window
@@ -14,10 +23,16 @@ static int scrollx = 0, scrolly = 0; // the actual scrolled position
 static WINDOW *W = NULL; // the drawing window
 static int *area = NULL; // the scrollable area
 static int *window = NULL; // the displayed window
+static int *frame = NULL; // the composed row of the displayed window
+static int *backdrop = NULL; // the canvas row behind the sprites
+static int *diff_runs = NULL; // the runs of changed cells of a row
 static bool window_change = false; // the displayed window was changed
 static int window_border_ch = -1; // the displayed window border
 static int coordx = 0, coordy = 0; // the cell coordinate offset
 static int mode = 0; // the cell modification mode
+static FrameDelta *delta = NULL; // the frame delta the changed cells are recorded to
+static AnsiTerm *term = NULL; // the ANSI terminal the changed cells are encoded to instead of NCurses
+static bool hardware_scroll = true; // scroll steps are moved by the terminal
 
 struct SpriteType
 {
@@ -37,6 +52,11 @@ static SpriteType sprite[sprites] = {{0}}; // the sprite data
 static int sprite_begin = 0; // the begin of the active sprite range
 static int sprite_end = -1; // the end of the active sprite range
 
+static int *bin_first = NULL; // the first entry of each window row in the sprite bins
+static int *bin_sprite = NULL; // the sprites that overlap each window row
+static int bin_rows = 0; // the number of rows the sprite bins can hold
+static int bin_capacity = 0; // the number of entries the sprite bins can hold
+
 // set the drawing window
 void set_drawing_window(WINDOW *w)
 {
@@ -94,6 +114,15 @@ void set_window_size(int sx, int sy)
    if (window) delete[] window;
    window = new int[winx*winy];
 
+   if (frame) delete[] frame;
+   frame = new int[winx];
+
+   if (backdrop) delete[] backdrop;
+   backdrop = new int[winx];
+
+   if (diff_runs) delete[] diff_runs;
+   diff_runs = new int[winx+2];
+
    window_change = true;
 }
 
@@ -1197,97 +1226,532 @@ void disable_sprites()
    sprite_end = -1;
 }
 
+// helper for estimating the bytes of a cursor addressing sequence (ESC [ row ; col H)
+static int addressing_bytes(int y, int x)
+{
+   int bytes = 4;
+
+   for (int v=y+1; v>0; v/=10) bytes++;
+   for (int v=x+1; v>0; v/=10) bytes++;
+
+   return(bytes);
+}
+
+// helper for mapping a window cell to a sprite cell
+static void map_sprite_cell(const SpriteType *s, int x, int y,
+                            int i, int j,
+                            int *ax, int *ay)
+{
+   int u = i - s->x;
+   int v = j - s->y;
+
+   if (!s->window)
+   {
+      u += x;
+      v += y;
+
+      if (s->parallax)
+      {
+         u += s->dx * x;
+         v += s->dy * y;
+      }
+   }
+
+   *ax = u;
+   *ay = v;
+}
+
+// helper for copying a canvas row into a row of the displayed window
+// * the viewport is clipped against the canvas area once per row
+static void compose_canvas_row(int x, int y, int *row)
+{
+   x += coordx;
+   y += coordy;
+
+   if (y < 0 || y >= sizey)
+   {
+      for (int i=0; i<winx; i++) row[i] = ' ';
+      return;
+   }
+
+   int i1 = x < 0 ? -x : 0;
+   int i2 = sizex - x < winx ? sizex - x : winx;
+
+   if (i1 >= i2)
+   {
+      for (int i=0; i<winx; i++) row[i] = ' ';
+      return;
+   }
+
+   for (int i=0; i<i1; i++) row[i] = ' ';
+   memcpy(row + i1, area + (x + i1) + y*sizex, (i2 - i1)*sizeof(int));
+   for (int i=i2; i<winx; i++) row[i] = ' ';
+}
+
+// helper for overlaying the row of a sprite onto a row of the displayed window
+// * the sprite row is clipped against the window once,
+//   runs of transparent cells are skipped and runs of opaque cells are copied
+// * a background sprite only shows where the canvas row "back" is empty
+static void compose_sprite_row(const SpriteType *s, int x, int y, int j,
+                               const int *back, int *row)
+{
+   int ax, ay;
+   map_sprite_cell(s, x, y, 0, j, &ax, &ay);
+
+   if (ay < 0 || ay >= s->sy) return;
+
+   const int *data = s->data + ay*s->sx;
+
+   // parallax offsets are truncated per cell, so that the columns are mapped one by one
+   if (s->parallax && !s->window)
+   {
+      for (int i=0; i<winx; i++)
+      {
+         map_sprite_cell(s, x, y, i, j, &ax, &ay);
+
+         if (ax >= 0 && ax < s->sx)
+         {
+            int c = data[ax];
+            if (c >= 0 && (!s->background || back[i] == ' '))
+               row[i] = c;
+         }
+      }
+
+      return;
+   }
+
+   int i1 = ax < 0 ? -ax : 0;
+   int i2 = s->sx - ax < winx ? s->sx - ax : winx;
+
+   // the sprite cell of window column i is data[ax + i], which is only formed within the clipped columns
+   if (s->background)
+   {
+      for (int i=i1; i<i2; i++)
+         if (data[ax + i] >= 0 && back[i] == ' ')
+            row[i] = data[ax + i];
+
+      return;
+   }
+
+   for (int i=i1; i<i2;)
+   {
+      while (i < i2 && data[ax + i] < 0) i++;
+
+      int run = i;
+      while (i < i2 && data[ax + i] >= 0) i++;
+
+      if (i > run)
+         memcpy(row + run, data + ax + run, (i - run)*sizeof(int));
+   }
+}
+
+// helper for comparing up to 64 cells of two rows
+// * returns a bit mask of the changed cells
+// * compares 32 cells per step with AVX2 or 16 cells with SSE2,
+//   whose compare results are packed into one byte per cell,
+//   and the remaining cells one by one
+static uint64_t diff_mask(const int *row, const int *shown, int n)
+{
+   uint64_t mask = 0;
+   int i = 0;
+
+#if defined(__AVX2__)
+   for (; i+32<=n; i+=32)
+   {
+      uint64_t equal = 0;
+      for (int k=0; k<4; k++)
+      {
+         __m256i a = _mm256_loadu_si256((const __m256i *)(row + i + 8*k));
+         __m256i b = _mm256_loadu_si256((const __m256i *)(shown + i + 8*k));
+         equal |= (uint64_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b))) << 8*k;
+      }
+      mask |= (~equal & 0xFFFFFFFF) << i;
+   }
+#endif
+
+#if defined(__SSE2__)
+   for (; i+16<=n; i+=16)
+   {
+      __m128i e0 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(row + i)),
+                                   _mm_loadu_si128((const __m128i *)(shown + i)));
+      __m128i e1 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(row + i + 4)),
+                                   _mm_loadu_si128((const __m128i *)(shown + i + 4)));
+      __m128i e2 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(row + i + 8)),
+                                   _mm_loadu_si128((const __m128i *)(shown + i + 8)));
+      __m128i e3 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(row + i + 12)),
+                                   _mm_loadu_si128((const __m128i *)(shown + i + 12)));
+
+      // the saturating packs keep the cell order and turn -1 into a set byte
+      __m128i packed = _mm_packs_epi16(_mm_packs_epi32(e0, e1), _mm_packs_epi32(e2, e3));
+      int equal = _mm_movemask_epi8(packed);
+
+      mask |= (uint64_t)(~equal & 0xFFFF) << i;
+   }
+#endif
+
+   for (; i<n; i++)
+      if (row[i] != shown[i])
+         mask |= (uint64_t)1 << i;
+
+   return(mask);
+}
+
+// helper for diffing a composed row against the displayed row
+// * the changed cells are masked 64 cells at a time
+//   and the runs of changed cells are extracted from the masks with bit scans
+// * "runs" receives the begin and end of each run of changed cells
+// * returns the number of runs
+static int diff_row(const int *row, const int *shown, int n, int *runs)
+{
+   int count = 0;
+   bool open = false;
+
+   for (int base=0; base<n; base+=64)
+   {
+      int m = n-base<64 ? n-base : 64;
+
+      uint64_t bits = diff_mask(row + base, shown + base, m);
+      uint64_t valid = m<64 ? ((uint64_t)1 << m) - 1 : ~(uint64_t)0;
+
+      // alternately scan for the begin and the end of a run
+      int pos = 0;
+      while (true)
+      {
+         uint64_t scan = (open ? ~bits : bits) & valid & (~(uint64_t)0 << pos);
+         if (!scan) break;
+
+         pos = __builtin_ctzll(scan);
+
+         if (open) runs[2*count++ + 1] = base + pos;
+         else runs[2*count] = base + pos;
+
+         open = !open;
+      }
+   }
+
+   if (open) runs[2*count++ + 1] = n;
+
+   return(count);
+}
+
+// helper for binning the visible sprites into the rows of the displayed window
+// * the sprites are counting sorted by the rows of their clipped vertical range,
+//   each row keeps the order of "visible", which is the overlay order
+// * the range of a parallax sprite is widened by one row, as its offset is truncated
+static void bin_sprites(int x, int y, const int *visible, int count)
+{
+   if (winy > bin_rows)
+   {
+      if (bin_first) delete[] bin_first;
+      bin_first = new int[winy+1];
+      bin_rows = winy;
+   }
+
+   for (int j=0; j<=winy; j++)
+      bin_first[j] = 0;
+
+   // the clipped row range of each visible sprite
+   int range[sprites][2];
+   int entries = 0;
+
+   for (int k=0; k<count; k++)
+   {
+      const SpriteType *s = &sprite[visible[k]];
+
+      int y1 = s->y, margin = 0;
+
+      if (!s->window)
+      {
+         y1 -= y;
+
+         if (s->parallax)
+         {
+            y1 -= (int)(s->dy * y);
+            margin = 1;
+         }
+      }
+
+      int y2 = y1 + s->sy - 1 + margin;
+      y1 -= margin;
+
+      if (y1 < 0) y1 = 0;
+      if (y2 >= winy) y2 = winy-1;
+
+      range[k][0] = y1;
+      range[k][1] = y2;
+
+      for (int j=y1; j<=y2; j++)
+         bin_first[j+1]++;
+
+      if (y1 <= y2) entries += y2-y1+1;
+   }
+
+   if (entries > bin_capacity)
+   {
+      if (bin_sprite) delete[] bin_sprite;
+      bin_sprite = new int[entries];
+      bin_capacity = entries;
+   }
+
+   // the rows are counting sorted by using their first entry as insertion cursor
+   for (int j=0; j<winy; j++)
+      bin_first[j+1] += bin_first[j];
+
+   for (int k=0; k<count; k++)
+      for (int j=range[k][0]; j<=range[k][1]; j++)
+         bin_sprite[bin_first[j]++] = visible[k];
+
+   for (int j=winy; j>0; j--)
+      bin_first[j] = bin_first[j-1];
+   bin_first[0] = 0;
+}
+
 // redraw the displayed window at top-left position (x, y)
+// * each row is composed from a clipped span of the canvas area
+//   and the clipped spans of the sprites overlapping it
+// * the sprites are overlaid from the last to the first one,
+//   so that the first opaque sprite of a cell takes precedence
+// * the visible sprites are binned by the rows they overlap once per redraw,
+//   so a row only visits the sprites overlapping it
+// * each composed row is diffed against the displayed row
+//   and only its runs of changed cells are drawn and recorded
 void redraw_window(int x, int y)
 {
    if (!area || !window) return;
 
+   ProfileScope scope(PROFILE_REDRAW);
+
    WINDOW *w = W?W:stdscr;
 
-   bool reposition = true;
+   int changed = 0, bytes = 0;
+
+   // the visible sprites
+   int visible[sprites];
+   int count = 0;
+   bool background = false;
 
-   // process each visible cell
+   for (int k=sprite_end; k>=sprite_begin; k--)
+   {
+      SpriteType *s = &sprite[k];
+
+      if (s->data != NULL &&
+          s->sx > 0 && s->sy > 0 &&
+          !s->hidden)
+      {
+         visible[count++] = k;
+         if (s->background) background = true;
+      }
+   }
+
+   bin_sprites(x, y, visible, count);
+
+   // process each visible row
    for (int j=0; j<winy; j++)
    {
-      for (int i=0; i<winx; i++)
+      // get visible canvas row, which is kept for background sprites
+      compose_canvas_row(x, y+j, frame);
+      if (background)
+         memcpy(backdrop, frame, winx*sizeof(int));
+
+      // override visible characters with the data of the sprites binned into the row
+      for (int b=bin_first[j]; b<bin_first[j+1]; b++)
+         compose_sprite_row(&sprite[bin_sprite[b]], x, y, j, backdrop, frame);
+
+      // override visible characters with window border
+      if (window_border_ch >= 0)
+      {
+         if (j == 0 || j == winy-1)
+            for (int i=0; i<winx; i++) frame[i] = window_border_ch;
+         else
+            frame[0] = frame[winx-1] = window_border_ch;
+      }
+
+      // get the runs of changed characters
+      int *prev = &window[j*winx];
+      int runs = 1;
+
+      if (window_change)
       {
-         // get visible cell character
-         int ch = get_cell(x+i, y+j);
-         if (ch < 0) ch = ' ';
+         diff_runs[0] = 0;
+         diff_runs[1] = winx;
+      }
+      else
+         runs = diff_row(frame, prev, winx, diff_runs);
 
-         // override visible character with sprite data
-         for (int k=sprite_begin; k<=sprite_end; k++)
+      // draw the runs of changed characters
+      for (int r=0; r<runs; r++)
+      {
+         int begin = diff_runs[2*r];
+         int end = diff_runs[2*r+1];
+
+         if (term)
          {
-            SpriteType *s = &sprite[k];
+            int before = term->bytes;
+            ansi_add_run(term, j+offy, begin+offx, frame + begin, end-begin);
+            bytes += term->bytes - before;
+         }
+         else
+         {
+            wmove(w, j+offy, begin+offx);
+            bytes += addressing_bytes(j+offy, begin+offx);
 
-            if (s->data != NULL &&
-                s->sx > 0 && s->sy > 0 &&
-                !s->hidden)
+            for (int i=begin; i<end; i++)
             {
-               int ax = i - s->x;
-               int ay = j - s->y;
-
-               if (!s->window)
-               {
-                  ax += x;
-                  ay += y;
-
-                  if (s->parallax)
-                  {
-                     ax += s->dx * x;
-                     ay += s->dy * y;
-                  }
-               }
-
-               if (ax >= 0 && ax < s->sx && ay >= 0 && ay < s->sy)
-               {
-                  int c = s->data[ax+ay*s->sx];
-                  if (c >= 0)
-                  {
-                     if (!s->background || ch == ' ')
-                     {
-                        ch = c;
-                        break;
-                     }
-                  }
-               }
+               waddch(w, frame[i]);
+               bytes += (frame[i] & A_ALTCHARSET)?3:1;
             }
          }
 
-         // override visible character with window border
-         if (window_border_ch >= 0)
-            if (i == 0 || i == winx-1 || j == 0 || j == winy-1)
-               ch = window_border_ch;
+         changed += end-begin;
+
+         // save changed characters
+         memcpy(prev + begin, frame + begin, (end-begin)*sizeof(int));
+
+         // record the run of changed characters
+         if (delta)
+            delta_add_run(delta, j+offy, begin+offx, prev + begin, end-begin);
+      }
+   }
+
+   window_change = false;
+
+   scrollx = x;
+   scrolly = y;
+
+   profile_count(PROFILE_COMPOSED, winx*winy);
+   profile_count(PROFILE_CHANGED, changed);
+   profile_count(PROFILE_BYTES, bytes);
+}
+
+// set the frame delta the changed cells of the displayed window are recorded to
+void set_window_delta(FrameDelta *d)
+{
+   delta = d;
+}
+
+// set the ANSI terminal the changed cells of the displayed window are encoded to
+void set_window_term(AnsiTerm *t)
+{
+   term = t;
+}
+
+// mark all cells of the displayed window as changed
+void touch_window()
+{
+   window_change = true;
+}
+
+// enable or disable hardware scrolling of the displayed window
+void set_window_scrolling(bool hardware)
+{
+   hardware_scroll = hardware;
+}
+
+// helper for moving the displayed window content by the terminal
+// * the displayed rows are moved with a scroll region
+//   and the displayed columns by deleting resp. inserting characters,
+//   which needs the window to span the whole width resp. to reach the right edge,
+//   as the terminal moves the cells outside of the window as well
+// * the saved window cells are moved along, so that the next redraw only draws
+//   the exposed cells and the cells that changed otherwise
+// * the exposed cells are marked with an invalid character
+static void scroll_screen(int dx, int dy)
+{
+   if (!hardware_scroll || !window || window_change) return;
+
+   // a frame delta has no means to record the moved cells
+   if (delta) return;
+
+   if (dx <= -winx || dx >= winx) dx = 0;
+   if (dy <= -winy || dy >= winy) dy = 0;
+   if (dx == 0 && dy == 0) return;
+
+   WINDOW *w = W?W:stdscr;
+
+   int cols = term?term->cols:getmaxx(w);
+   int lines = term?term->lines:getmaxy(w);
+
+   if (offx < 0 || offy < 0 || offy+winy > lines) return;
+
+   if (offx != 0 || winx != cols) dy = 0;
+   if (offx+winx != cols) dx = 0;
+   if (dx == 0 && dy == 0) return;
+
+   int bytes = term?term->bytes:0;
+
+   // move the displayed rows
+   if (dy != 0)
+   {
+      if (term)
+         ansi_scroll(term, offy, offy+winy-1, dy);
+      else
+      {
+         int top = 0, bottom = getmaxy(w)-1;
+         wgetscrreg(w, &top, &bottom);
+         bool scroll = is_scrollok(w);
+
+         idlok(w, TRUE);
+         scrollok(w, TRUE);
+         wsetscrreg(w, offy, offy+winy-1);
+         wscrl(w, dy);
+         wsetscrreg(w, top, bottom);
+         scrollok(w, scroll);
+
+         bytes += 16;
+      }
+
+      int n = dy>0?dy:-dy;
+
+      if (dy > 0)
+      {
+         memmove(window, window + n*winx, (winy-n)*winx*sizeof(int));
+         for (int i=(winy-n)*winx; i<winy*winx; i++) window[i] = -1;
+      }
+      else
+      {
+         memmove(window + n*winx, window, (winy-n)*winx*sizeof(int));
+         for (int i=0; i<n*winx; i++) window[i] = -1;
+      }
+   }
+
+   // move the displayed columns
+   if (dx != 0)
+   {
+      int n = dx>0?dx:-dx;
 
-         // check for character change
-         if (window_change || ch != window[i+j*winx])
+      for (int j=0; j<winy; j++)
+      {
+         int *row = &window[j*winx];
+
+         // rows that are exposed entirely are drawn anyway
+         if (row[0] == -1 && row[winx-1] == -1) continue;
+
+         if (term)
+            ansi_shift(term, j+offy, offx, dx);
+         else
          {
-            // check for cursor repositioning
-            if (reposition)
-            {
-               wmove(w, j+offy, i+offx);
-               reposition = false;
-            }
+            wmove(w, j+offy, offx);
+            for (int i=0; i<n; i++)
+               if (dx > 0) wdelch(w);
+               else winsch(w, ' ');
 
-            // draw changed character
-            waddch(w, ch);
+            bytes += addressing_bytes(j+offy, offx) + 4;
+         }
 
-            // save changed character
-            window[i+j*winx] = ch;
+         if (dx > 0)
+         {
+            memmove(row, row + n, (winx-n)*sizeof(int));
+            for (int i=winx-n; i<winx; i++) row[i] = -1;
          }
          else
          {
-            reposition = true;
+            memmove(row + n, row, (winx-n)*sizeof(int));
+            for (int i=0; i<n; i++) row[i] = -1;
          }
       }
-
-      reposition = true;
    }
 
-   window_change = false;
-
-   scrollx = x;
-   scrolly = y;
+   profile_count(PROFILE_BYTES, term?term->bytes-bytes:bytes);
 }
 
 // position the displayed window at center position (x, y)
@@ -1299,6 +1763,8 @@ void position_window(int x, int y)
 // scroll the displayed window to top-left position (x, y)
 void scroll_window(int x, int y, int deltax, int deltay, bool stop)
 {
+   int lastx = scrollx, lasty = scrolly;
+
    if (stop)
    {
       int offx = 0, offy = 0;
@@ -1320,6 +1786,8 @@ void scroll_window(int x, int y, int deltax, int deltay, bool stop)
       else if (y-deltay > scrolly) scrolly++;
    }
 
+   scroll_screen(scrollx - lastx, scrolly - lasty);
+
    redraw_window(scrollx, scrolly);
 }
 
@@ -1345,6 +1813,23 @@ void release_area()
    if (window) delete[] window;
    window = NULL;
 
+   if (frame) delete[] frame;
+   frame = NULL;
+
+   if (backdrop) delete[] backdrop;
+   backdrop = NULL;
+
+   if (diff_runs) delete[] diff_runs;
+   diff_runs = NULL;
+
+   if (bin_first) delete[] bin_first;
+   bin_first = NULL;
+   bin_rows = 0;
+
+   if (bin_sprite) delete[] bin_sprite;
+   bin_sprite = NULL;
+   bin_capacity = 0;
+
    for (int i=0; i<sprites; i++)
       disable_sprite(i);
 
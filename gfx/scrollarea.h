@@ -4,6 +4,8 @@
 #pragma once
 
 #include "gfx.h"
+#include "framedelta.h"
+#include "ansiterm.h"
 
 //! set the drawing window
 //! * stdscr is used by default
@@ -345,16 +347,41 @@ void disable_sprites();
 //! redraw the displayed window at top-left position (x, y)
 //! * it is assumed that the displayed window area has been cleared once
 //! * subsequent calls will only update modifications to the canvas area
+//! * the changed cells are recorded as runs into the frame delta, if one is set
 void redraw_window(int x, int y);
 
+//! set the frame delta the changed cells of the displayed window are recorded to
+//! * the runs are recorded at their screen position into the frame begun by the caller
+//! * NULL disables recording
+void set_window_delta(FrameDelta *d);
+
+//! set the ANSI terminal the changed cells of the displayed window are encoded to
+//! * the runs are encoded instead of drawn with NCurses and are written by ansi_flush
+//! * NULL draws with NCurses again
+void set_window_term(AnsiTerm *t);
+
+//! mark all cells of the displayed window as changed
+//! * the next redraw draws and records the whole window, e.g. for a keyframe
+void touch_window();
+
 //! position the displayed window at center position (x, y)
 //! * it is assumed that the displayed window area has been cleared once
 //! * subsequent calls will only update modifications to the canvas area
 void position_window(int x, int y);
 
+//! enable or disable hardware scrolling of the displayed window
+//! * enabled by default
+//! * scroll steps of scroll_window move the displayed cells with the terminal,
+//!   so that only the exposed cells are redrawn
+//! * vertical steps need a window that spans the whole width of the drawing window resp. terminal,
+//!   horizontal steps a window that reaches its right edge
+//! * steps are redrawn entirely while a frame delta is recorded
+void set_window_scrolling(bool hardware = true);
+
 //! scroll the displayed window to top-left position (x, y)
 //! * "deltax" and "deltay" is the position delta that triggers scrolling
 //! * "stop" determines if scrolling should stop at the edges of the scrollable area
+//! * scroll steps are moved by the terminal, see set_window_scrolling
 void scroll_window(int x, int y, int deltax = 0, int deltay = 0, bool stop = true);
 
 //! scroll the displayed window to center position (x, y)
@@ -17,18 +17,68 @@ void msleep(float ms)
    usleep(us);
 }
 
+static Random global_random;
+static bool global_random_init = false;
+
 // generate a random float number in the range [0,1[
 float rnd()
 {
-   static bool init = false;
+   if (!global_random_init)
+      rnd_seed(time(NULL));
+
+   return(rnd(&global_random));
+}
+
+// seed the global random number generator
+void rnd_seed(uint64_t seed)
+{
+   rnd_seed(&global_random, seed);
+   global_random_init = true;
+}
+
+// seed a random number generator
+void rnd_seed(Random *r, uint64_t seed, uint64_t stream)
+{
+   r->state = 0;
+   r->inc = (stream << 1) | 1;
+   rnd_next(r);
+   r->state += seed;
+   rnd_next(r);
+}
+
+// generate a random 32-bit number
+uint32_t rnd_next(Random *r)
+{
+   uint64_t old = r->state;
+   r->state = old*6364136223846793005ULL + r->inc;
+
+   uint32_t xorshifted = ((old >> 18) ^ old) >> 27;
+   uint32_t rot = old >> 59;
+
+   return((xorshifted >> rot) | (xorshifted << ((-rot) & 31)));
+}
+
+// generate an unbiased random integer number in the range [0,n[
+// * multiplies into 64 bits and rejects the few biased low products
+int rnd_int(Random *r, int n)
+{
+   uint32_t range = n;
+   uint64_t m = (uint64_t)rnd_next(r)*range;
 
-   if (!init)
+   if ((uint32_t)m < range)
    {
-      srand((int)time(NULL));
-      init = true;
+      uint32_t threshold = -range % range;
+      while ((uint32_t)m < threshold)
+         m = (uint64_t)rnd_next(r)*range;
    }
 
-   return(rand()/((float)RAND_MAX+1));
+   return(m >> 32);
+}
+
+// generate a random float number in the range [0,1[
+float rnd(Random *r)
+{
+   return((rnd_next(r) >> 8)/16777216.0f);
 }
 
 // check for a repeating time period
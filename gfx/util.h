@@ -4,14 +4,43 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
 #include "math2d.h"
 
 //! sleep for a period of time given in milli seconds
 void msleep(float ms);
 
 //! generate a random float number in the range [0,1[
+//! * uses a global random number generator, which is seeded with the time
+//!   unless it has been seeded explicitly
 float rnd();
 
+//! seed the global random number generator
+void rnd_seed(uint64_t seed);
+
+//! state of a pseudo random number generator (PCG32)
+//! * each stream of a seed generates an independent sequence,
+//!   so that parallel threads or games can use separate streams of the same seed
+struct Random
+{
+   uint64_t state; // the internal state
+   uint64_t inc;   // the stream increment (always odd)
+};
+
+//! seed a random number generator
+//! * "stream" selects one of 2^63 independent sequences
+void rnd_seed(Random *r, uint64_t seed, uint64_t stream = 0);
+
+//! generate a random 32-bit number
+uint32_t rnd_next(Random *r);
+
+//! generate an unbiased random integer number in the range [0,n[
+//! * "n" must be positive
+int rnd_int(Random *r, int n);
+
+//! generate a random float number in the range [0,1[
+float rnd(Random *r);
+
 //! check for a repeating time period
 //! * "time" is the actual time
 //! * "period" is the repeating time period
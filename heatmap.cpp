@@ -0,0 +1,188 @@
+// Sink Ships heat map
+
+#include "heatmap.h"
+
+// lowest probability of each bucket
+static const float bucket_odds[heatmap_buckets] = {0, 0.1f, 0.2f, 0.35f, 0.55f};
+
+// helper for getting the bucket of a probability
+static int get_bucket(float odds)
+{
+    int b = 0;
+    while (b + 1 < heatmap_buckets && odds >= bucket_odds[b + 1])
+        b++;
+
+    return b;
+}
+
+// helper for estimating the cells covered by the ships behind the damaged cells
+// * "target" receives per cell the largest share of the explaining placements through a damaged cell
+static void estimate_targets(const Ai *a, float *target)
+{
+    Bits128 hits = a->hit_bits;
+    while (!bits_empty(hits))
+    {
+        int h = bits_pop(&hits);
+
+        float cover[bitboard_size * bitboard_size] = {0};
+        float total = 0;
+
+        for (int k = 0; k < a->gen->lists; k++)
+        {
+            if (a->remaining[k] == 0)
+                continue;
+
+            const PlacementList *l = &a->gen->placements[k];
+
+            for (int w = 0; w < placement_words; w++)
+            {
+                uint64_t bits = a->valid[k].w[w] & l->cover[h].w[w];
+
+                while (bits)
+                {
+                    const Placement *m = l->ref[(w << 6) + __builtin_ctzll(bits)].mask;
+                    bits &= bits - 1;
+
+                    // a ship cannot touch damaged cells of another ship
+                    if (!bits_empty(bits_andnot(bits_and(m->halo, a->hit_bits), m->ship)))
+                        continue;
+
+                    total += a->remaining[k];
+
+                    Bits128 cells = m->ship;
+                    while (!bits_empty(cells))
+                        cover[bits_pop(&cells)] += a->remaining[k];
+                }
+            }
+        }
+
+        for (int c = 0; total > 0 && c < bitboard_size * bitboard_size; c++)
+            if (cover[c] / total > target[c])
+                target[c] = cover[c] / total;
+    }
+}
+
+// initialize the heat map of the observations of an opponent
+void heatmap_init(HeatMap *h, const Ai *a, bool exact)
+{
+    h->ai = a;
+    h->changes = 0;
+    h->exact = false;
+
+    h->counter = NULL;
+    if (exact && a->gen->placements)
+    {
+        h->counter = new FleetCount;
+        fleetcount_init(h->counter, a->gen, heatmap_exact_limit);
+    }
+
+    for (int c = 0; c < bitboard_size * bitboard_size; c++)
+    {
+        h->odds[c] = 0;
+        h->bucket[c] = 0;
+    }
+
+    heatmap_update(h);
+}
+
+// release the fleet counter of a heat map
+void heatmap_free(HeatMap *h)
+{
+    if (h->counter)
+        fleetcount_free(h->counter);
+
+    delete h->counter;
+    h->counter = NULL;
+}
+
+// update the heat map after the opponent has been updated with a shot
+int heatmap_update(HeatMap *h)
+{
+    const Ai *a = h->ai;
+    int size = a->gen->size;
+
+    h->changes = 0;
+    if (!a->gen->placements)
+        return 0;
+
+    // the exact probabilities fail while there are too many layouts to count them quickly
+    double exact[bitboard_size * bitboard_size];
+    h->exact = h->counter && fleetcount_observe(h->counter, a) > 0 && fleetcount_odds(h->counter, exact);
+
+    // the share of the valid placements of each size that one of its remaining ships takes
+    float share[bitboard_size];
+    float target[bitboard_size * bitboard_size] = {0};
+    if (!h->exact)
+    {
+        for (int k = 0; k < a->gen->lists; k++)
+        {
+            int placements = pset_count(&a->valid[k]);
+            share[k] = placements > 0 ? (float)a->remaining[k] / placements : 0;
+        }
+
+        estimate_targets(a, target);
+    }
+
+    for (int y = 0; y < size; y++)
+        for (int x = 0; x < size; x++)
+        {
+            int c = bits_index(y, x);
+            bool shot = bits_test(a->shot_bits, c);
+
+            float odds = 0;
+            if (shot)
+                odds = bits_test(a->hit_bits, c) || bits_test(a->sunk_bits, c) ? 1 : 0;
+            else if (h->exact)
+                odds = exact[c];
+            else
+            {
+                float expected = 0;
+                for (int k = 0; k < a->gen->lists; k++)
+                    expected += share[k] * a->count[k][c];
+
+                if (expected > 1)
+                    expected = 1;
+
+                odds = 1 - (1 - expected) * (1 - target[c]);
+            }
+
+            h->odds[c] = odds;
+
+            // shot cells are not shaded
+            int b = shot ? 0 : get_bucket(odds);
+            if (b != h->bucket[c])
+            {
+                h->bucket[c] = b;
+                h->changed[h->changes++] = c;
+            }
+        }
+
+    return h->changes;
+}
+
+// get the position of the i-th cell whose bucket changed with the last update
+void heatmap_get_changed(const HeatMap *h, int i, int *y, int *x)
+{
+    *y = h->changed[i] / bitboard_size;
+    *x = h->changed[i] % bitboard_size;
+}
+
+// get the estimated probability that a cell holds a ship
+float heatmap_get_odds(const HeatMap *h, int y, int x)
+{
+    int size = h->ai->gen->size;
+    if (y < 0 || x < 0 || y >= size || x >= size || !h->ai->gen->placements)
+        return 0;
+
+    return h->odds[bits_index(y, x)];
+}
+
+// get the shading bucket of a cell
+int heatmap_get_bucket(const HeatMap *h, int y, int x)
+{
+    int size = h->ai->gen->size;
+    if (y < 0 || x < 0 || y >= size || x >= size || !h->ai->gen->placements)
+        return 0;
+
+    return h->bucket[bits_index(y, x)];
+}
@@ -0,0 +1,62 @@
+// Sink Ships heat map
+// * estimates for each cell of an arena the probability that it holds a ship of the remaining fleet,
+//   as seen by an opponent that only knows the results of its own shots
+// * the estimate only reads the placement counts the opponent keeps up to date after each shot,
+//   see ai.h, so an update costs a few microseconds:
+//  * the remaining ships are treated as independent, each ship covers a cell with the share
+//    of the valid placements of its size that cover the cell
+//  * the ship behind a damaged cell is one of the valid placements through it, which explain
+//    the damaged cell without touching other damaged cells
+// * the probabilities are quantized into shading buckets and the cells whose bucket changed
+//   are collected, so a view only redraws these cells
+// * in exact mode the probabilities are counted by the fleet counter instead, see fleetcount.h,
+//   once the remaining layouts are few enough to count them within a few milliseconds,
+//   until then the estimate is used
+// * only arenas within the bitboard size are estimated
+
+#pragma once
+
+#include "ai.h"
+#include "fleetcount.h"
+
+//! number of shading buckets, bucket 0 is not shaded
+const int heatmap_buckets = 5;
+
+//! maximum number of transitions times compositions of an exact count, see fleetcount_init
+//! * the count and the odds of a 10x10 arena take at most about 30 milliseconds
+const long heatmap_exact_limit = 1 << 22;
+
+//! heat map of an arena
+struct HeatMap
+{
+    const Ai *ai;                                        // the opponent whose observations are estimated
+    float odds[bitboard_size * bitboard_size];           // the estimated probability of each cell by bit index
+    unsigned char bucket[bitboard_size * bitboard_size]; // the shading bucket of each cell by bit index
+    int changed[bitboard_size * bitboard_size];          // the bit indices of the cells whose bucket changed
+    int changes;                                         // the number of cells whose bucket changed
+    FleetCount *counter;                                 // the fleet counter of exact mode, NULL for the estimate only
+    bool exact;                                          // decides if the last update counted the exact probabilities
+};
+
+//! initialize the heat map of the observations of an opponent
+//! * the opponent must outlive the heat map
+//! * "exact" counts the exact probabilities once that is cheap enough
+void heatmap_init(HeatMap *h, const Ai *a, bool exact = false);
+
+//! release the fleet counter of a heat map
+void heatmap_free(HeatMap *h);
+
+//! update the heat map after the opponent has been updated with a shot
+//! * returns the number of cells whose bucket changed, see heatmap_get_changed
+int heatmap_update(HeatMap *h);
+
+//! get the position (y, x) of the i-th cell whose bucket changed with the last update
+void heatmap_get_changed(const HeatMap *h, int i, int *y, int *x);
+
+//! get the estimated probability that the cell at position (y, x) holds a ship
+//! * damaged cells report 1, other shot cells and cells outside the arena report 0
+float heatmap_get_odds(const HeatMap *h, int y, int x);
+
+//! get the shading bucket of the cell at position (y, x)
+//! * returns a bucket below heatmap_buckets, shot cells are not shaded
+int heatmap_get_bucket(const HeatMap *h, int y, int x);
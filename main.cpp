@@ -1,13 +1,40 @@
 #include "gfx.h"
 #include "gridfont.h"
 #include "sound.h"
+#include "game.h"
+#include "ai.h"
+#include "heatmap.h"
+#include "solver.h"
+#include "threadpool.h"
+#include "timeline.h"
+#include "replay.h"
+#include "protocol.h"
+#include "spectate.h"
+#include "scrollarea.h"
+#include "profiler.h"
+#include <poll.h>
 #include <time.h>
 
 // instance vars
 static int max_x = 0, max_y = 0; // screen size
 
 // launch parameters
-bool manualShipPlacement = true; // decides if user will manually place the ships (default: true)
+bool manualShipPlacement = true;    // decides if user will manually place the ships (default: true)
+bool hardOpponent = false;          // decides if the computer samples possible fleets on all cores (option -hard)
+bool exactHeat = false;             // decides if the heat map counts the exact odds once that is cheap enough (option -exact)
+float moveBudget = 5;               // time budget of a computer move in milliseconds (option -budget=ms)
+float endgameBudget = 0;            // time budget of an endgame move in milliseconds, 0 disables the solver (option -endgame=ms)
+uint64_t randomSeed = time(NULL);   // seed of all random numbers, replays a game with the same seed (option -seed=n)
+bool fastMode = false;              // decides if the effects of shots are played without delays (option -fast)
+int arenaSize = board_default_size; // number of rows and columns of an arena (option -size=n)
+Fleet fleet;                        // ship sizes in placement order (option -fleet=4,3,3,2,...)
+const char *recordPath = NULL;       // file all moves are recorded to, by default none (option -record[=file])
+const char *replayPath = NULL;      // file of a recorded game that is replayed instead of playing (option -replay=file)
+float replaySpeed = 4;              // number of replayed moves per second, changed with '+' and '-' (option -speed=n)
+const char *connectPath = NULL;     // socket of a game server that hosts the game instead of the computer (option -connect=path)
+bool versusMode = false;            // decides if the server matches the player with another client (option -versus)
+const char *spectatePath = NULL;    // socket spectators watch the game on (option -spectate=path)
+const char *profilePath = NULL;     // file the frame profile is exported to as Chrome trace events, shows the profiler HUD (option -profile[=file])
 
 // menu
 bool menuChoiceMade = false;
@@ -18,8 +45,13 @@ const int cellWidth = 9;  // width of an arena cell
 
 const int offsetBetweenArenas = 10; // offset between two arenas
 
-// arena size
-const int arenaSize = 10;
+// largest arena size that is drawn with big cells
+// * larger arenas are drawn with one char per cell into a scrollable canvas,
+//   of which each arena shows a viewport that follows the pointer or the last shot
+const int maxClassicSize = board_default_size;
+
+// decides if the arenas are drawn into the scrollable canvas
+bool largeArenas = false;
 
 // colors
 // 1: white
@@ -37,23 +69,91 @@ const char pointerChar = '#';
 const char shotCellChar = '/';
 const char emptyCellChar = ' ';
 
+// shading of the heat map, one char and color per bucket from unlikely to likely ship cells
+const char heatChars[heatmap_buckets] = {emptyCellChar, '.', ':', 'o', 'O'};
+const int heatColors[heatmap_buckets] = {aliveShipColor, 4, 6, 5, 7};
+
 // coordinates of the arenas
 const int firstPlayersArenaY = 3;
 const int firstPlayersArenaX = 5;
 const int secondPlayersArenaY = firstPlayersArenaY;
-const int secondPlayersArenaX = firstPlayersArenaX + cellWidth * arenaSize + offsetBetweenArenas;
+int secondPlayersArenaX = firstPlayersArenaX + cellWidth * arenaSize + offsetBetweenArenas;
+
+// game state, contains information about all the cells on both arenas and the content inside
+Game game;
+
+// fleet generator, contains all legal ship placements
+FleetGen generator;
 
-// addressing array, contains information about all the cells on both arenas and the content inside
-int cells[arenaSize][arenaSize][2];
+// computer opponent, keeps track of the remaining ship placements on the first arena
+Ai ai;
 
-// ship counters
-int firstPlayerShips;
-int secondPlayerShips;
+// thread pool of the hard computer opponent, NULL for the default opponent
+ThreadPool *sampler = NULL;
+
+// endgame solver of the computer opponent, plays optimally once few ships remain
+Solver solver;
+
+// the player's view of the computer's arena, keeps track of the remaining ship placements for the heat map
+Ai observer;
+
+// heat map of the computer's arena, shades the cells by the odds of holding a ship (toggled with 'h')
+HeatMap heatmap;
+bool showHeat = false;
 
 // pointer coordinates
 int yPointer = 0;
 int xPointer = 0;
 
+// static arena frame (grid lines and coordinates), rasterized once and copied to both arenas
+// * the frame starts one row above and two columns left of an arena for the coordinates
+WINDOW *arenaFrame = NULL;
+int frameHeight = (cellHeight - 1) * arenaSize + 2; // the number of rows of the arena frame
+int frameWidth = (cellWidth - 1) * arenaSize + 3;   // the number of columns of the arena frame
+
+// retained cell model of both arenas, each cell holds the char with its attributes
+chtype cellView[2][maxClassicSize][maxClassicSize];  // the chars that should be displayed
+chtype cellShown[2][maxClassicSize][maxClassicSize]; // the chars that are displayed, 0 if unknown
+bool cellDirty[2][maxClassicSize][maxClassicSize];   // decides if a cell has changed since the last flush
+int dirtyCells[2 * maxClassicSize * maxClassicSize]; // the changed cells, encoded as (player * arenaSize + y) * arenaSize + x
+int dirtyCount = 0;                                  // the number of changed cells
+
+// viewports of the large arenas into the scrollable canvas
+// * the canvas holds both framed arenas side by side
+const int viewTop = 2;    // the screen row of the viewports
+const int viewMargin = 3; // the number of cells kept visible around the focused cell
+int viewHeight = 0;       // the number of rows of a viewport
+int viewWidth = 0;        // the number of columns of a viewport
+int viewY[2] = {0, 0};    // the top-left position of the viewport of each arena within its frame
+int viewX[2] = {0, 0};
+int focusY[2] = {0, 0};   // the cell each viewport keeps visible
+int focusX[2] = {0, 0};
+
+// timeline, sequences the delayed effects of shots
+Timeline timeline;
+
+// delay after the effect of a shot in milliseconds
+const float effectDelay = 2000;
+
+// decides if the first player is allowed to shoot
+bool playersTurn = true;
+
+// replay log, records the moves of a game or holds the replayed game
+Replay replay;
+
+// connection to the game server, -1 if the game is played locally
+// * the local game state mirrors the own arena and the shot results on the opponent's arena
+int serverSocket = -1;
+Inbox inbox;           // the received messages of the server
+int remoteWinner = -1; // the winner reported by the server, -1 while the match is running
+
+// spectators of the game, receive the changed cells of the canvas as delta-compressed frames
+// * large arenas stream their viewports, classic arenas are mirrored into a canvas
+//   with one char per cell, which is drawn into an off-screen pad
+SpectatorHub spectators;
+bool spectating = false;
+WINDOW *spectatorPad = NULL;
+
 // draws a square on y, x with height and width
 void draw_square(int y, int x, int height, int width)
 {
@@ -95,7 +195,7 @@ void printGameRules()
 {
     move(2, 3);
     printw("Game rules: \n\n   Players place their ships on a grid and take turns \n   guessing the coordinates to attack the opponent's \n   ships. The first player to sink all the opponent's ships wins. \n\n   Use arrow keys or WASD to"
-           " control the pointer, space to shoot, \n   'r' to rotate");
+           " control the pointer, space to shoot, \n   'r' to rotate, 'h' to show the odds of the computer's ships");
     draw_square(1, 1, 10, 67);
 }
 
@@ -106,7 +206,7 @@ void intro()
     printHintToStartGame();
     printGameRules();
 
-    int input = tolower(getch());
+    int input = tolower(wait_keycode());
 
     while (input != ' ')
     {
@@ -115,34 +215,27 @@ void intro()
             exit_gfx();
             exit(0);
         }
-        msleep(1);
 
-        input = tolower(getch());
+        input = tolower(wait_keycode());
     }
 
     clear();
     sound_play("Sounds/correct.wav");
 }
 
-// draws an arena on y, x with height and width
+// draws an arena on y, x with height and width into the drawing window
 void draw_arena(int y, int x, int height, int width)
 {
     use_color(3);
     // draws coordinates
-    const char letterCoordinates[] = "ABCDEFGHIG";
-    for (int i = 0; i <= 9; i++)
+    for (int i = 0; i < width; i++)
     {
-        move(y - 1, x + ((cellWidth - 1) / 2) + (cellWidth - 1) * i);
-        printw("%c", letterCoordinates[i]);
+        draw_text(y - 1, x + ((cellWidth - 1) / 2) + (cellWidth - 1) * i, "%c", 'A' + i);
     }
-    const char numberCoordinates[] = "123456789";
-    for (int i = 0; i < 9; i++)
+    for (int i = 0; i < height; i++)
     {
-        move(y + ((cellHeight - 1) / 2) + (cellHeight - 1) * i, x - 1);
-        printw("%c", numberCoordinates[i]);
+        draw_text(y + ((cellHeight - 1) / 2) + (cellHeight - 1) * i, x - (i < 9 ? 1 : 2), "%d", i + 1);
     }
-    move(y + ((cellHeight - 1) / 2) + (cellHeight - 1) * 9, x - 2);
-    printw("10");
 
     // draws table
     for (int i = 0; i < height; i++)
@@ -152,21 +245,10 @@ void draw_arena(int y, int x, int height, int width)
             draw_square(y + i * (cellHeight - 1), x + j * (cellWidth - 1), cellHeight, cellWidth);
         }
     }
-
-    // fills all cells with zeroes
-    for (int i = 0; i < 10; i++)
-    {
-        for (int j = 0; j < 10; j++)
-        {
-            for (int p = 0; p < 2; p++)
-            {
-                cells[i][j][p] = 0;
-            }
-        }
-    }
 }
 
 // fills one cell on y, x with some chars with a color on a specific arena
+// * only the cell model is updated, the changed cells are drawn by flushCells()
 void fillOneCell(int y, int x, int player, int color, char c)
 {
     // sets the char color
@@ -174,39 +256,188 @@ void fillOneCell(int y, int x, int player, int color, char c)
     // 2: red
     // 3: green
     // 4: blue
-    use_color(color);
+    chtype ch = (unsigned char)c | COLOR_PAIR(color) | (getattrs(stdscr) & ~A_COLOR);
 
-    // initializes the coordinates of the arena
-    int arenaY = 0;
-    int arenaX = 0;
+    // large arenas are drawn into the canvas, one char per cell
+    if (largeArenas || spectating)
+        set_cell(player * (arenaSize + 2) + x + 1, y + 1, ch);
+    if (largeArenas)
+        return;
 
-    // sets the arena coordinates
-    switch (player)
+    cellView[player][y][x] = ch;
+
+    if (!cellDirty[player][y][x])
     {
-    case 0:
-        arenaY = firstPlayersArenaY;
-        arenaX = firstPlayersArenaX;
-        break;
-    case 1:
-        arenaY = secondPlayersArenaY;
-        arenaX = secondPlayersArenaX;
-        break;
-    default:
-        // we should never get here
-        break;
+        cellDirty[player][y][x] = true;
+        dirtyCells[dirtyCount++] = (player * arenaSize + y) * arenaSize + x;
     }
+}
+
+// draws all changed cells of both arenas
+// * horizontally adjacent changed cells are merged into one span per row,
+//   the grid lines between them are taken from the arena frame
+void flushCells()
+{
+    bool changed[2][maxClassicSize][maxClassicSize] = {{{false}}};
+    bool rowChanged[2][maxClassicSize] = {{false}};
+
+    for (int k = 0; k < dirtyCount; k++)
+    {
+        int x = dirtyCells[k] % arenaSize;
+        int y = dirtyCells[k] / arenaSize % arenaSize;
+        int player = dirtyCells[k] / (arenaSize * arenaSize);
+
+        cellDirty[player][y][x] = false;
+
+        // skip cells that are displayed already
+        chtype ch = cellView[player][y][x];
+        if (cellShown[player][y][x] == ch)
+            continue;
+
+        cellShown[player][y][x] = ch;
+        changed[player][y][x] = true;
+        rowChanged[player][y] = true;
+    }
+
+    dirtyCount = 0;
 
-    // fills a cell with chars
-    for (int i = 0; i < cellWidth - 2; i++)
+    chtype span[(cellWidth - 1) * maxClassicSize];
+
+    for (int player = 0; player < 2; player++)
     {
-        for (int j = 0; j < cellHeight - 2; j++)
+        // initializes the coordinates of the arena
+        int arenaY = player == 0 ? firstPlayersArenaY : secondPlayersArenaY;
+        int arenaX = player == 0 ? firstPlayersArenaX : secondPlayersArenaX;
+
+        for (int y = 0; y < arenaSize; y++)
         {
-            move(((arenaY + 1) + (cellHeight - 1) * y) + 1 * j, ((arenaX + 1) + (cellWidth - 1) * x) + 1 * i);
-            printw("%c", c);
+            if (!rowChanged[player][y])
+                continue;
+
+            for (int x1 = 0; x1 < arenaSize; x1++)
+            {
+                if (!changed[player][y][x1])
+                    continue;
+
+                // find the run of changed cells
+                int x2 = x1;
+                while (x2 + 1 < arenaSize && changed[player][y][x2 + 1])
+                    x2++;
+
+                int length = (cellWidth - 1) * (x2 - x1 + 1) - 1;
+
+                for (int j = 0; j < cellHeight - 2; j++)
+                {
+                    int row = ((arenaY + 1) + (cellHeight - 1) * y) + 1 * j;
+
+                    for (int i = 0; i < length; i++)
+                    {
+                        int x = x1 + i / (cellWidth - 1);
+
+                        if (i % (cellWidth - 1) < cellWidth - 2)
+                            span[i] = cellView[player][y][x];
+                        else
+                            span[i] = mvwinch(arenaFrame, row - (arenaY - 1), (cellWidth - 1) * (x + 1) + 2);
+                    }
+
+                    mvaddchnstr(row, (arenaX + 1) + (cellWidth - 1) * x1, span, length);
+                }
+
+                x1 = x2;
+            }
         }
     }
 }
 
+// moves a viewport so that its focused cell stays visible with a margin
+void followFocus(int player)
+{
+    // the viewport shows the arena frame as well, so the cell at y is at y + 1
+    int y = focusY[player] + 1;
+    int x = focusX[player] + 1;
+
+    int marginY = viewHeight > 2 * viewMargin ? viewMargin : 0;
+    int marginX = viewWidth > 2 * viewMargin ? viewMargin : 0;
+
+    if (y < viewY[player] + marginY)
+        viewY[player] = y - marginY;
+    if (y > viewY[player] + viewHeight - 1 - marginY)
+        viewY[player] = y - (viewHeight - 1 - marginY);
+    if (x < viewX[player] + marginX)
+        viewX[player] = x - marginX;
+    if (x > viewX[player] + viewWidth - 1 - marginX)
+        viewX[player] = x - (viewWidth - 1 - marginX);
+
+    // keep the viewport inside the arena frame
+    if (viewY[player] > arenaSize + 2 - viewHeight)
+        viewY[player] = arenaSize + 2 - viewHeight;
+    if (viewX[player] > arenaSize + 2 - viewWidth)
+        viewX[player] = arenaSize + 2 - viewWidth;
+    if (viewY[player] < 0)
+        viewY[player] = 0;
+    if (viewX[player] < 0)
+        viewX[player] = 0;
+}
+
+// draws the viewports of both large arenas together with the coordinates of their focused cells
+void drawViewports()
+{
+    const char *names[2] = {"Your arena", "Computer's arena"};
+
+    for (int player = 0; player < 2; player++)
+    {
+        int x = 2 + player * (viewWidth + 4);
+
+        followFocus(player);
+
+        set_window_offset(x, viewTop);
+        redraw_window(player * (arenaSize + 2) + viewX[player], viewY[player]);
+
+        use_color(interfaceColor);
+        move(viewTop - 1, x);
+        printw("%s %dx%d, row %d, column %d    ", names[player], arenaSize, arenaSize,
+               focusY[player] + 1, focusX[player] + 1);
+    }
+}
+
+// draws the changed cells and refreshes the screen
+// * the changed cells of the canvas are streamed to the spectators
+void present()
+{
+    // classic arenas are recorded from the off-screen pad
+    int lines = LINES, cols = COLS;
+    if (spectating && !largeArenas)
+        getmaxyx(spectatorPad, lines, cols);
+
+    bool watched = spectating && spectate_begin_frame(&spectators, lines, cols);
+
+    if (watched)
+    {
+        if (spectators.keyframe)
+            touch_window();
+        set_window_delta(&spectators.delta);
+    }
+
+    if (largeArenas)
+        drawViewports();
+    else
+    {
+        flushCells();
+        if (watched)
+            redraw_window(0, 0);
+    }
+
+    if (watched)
+    {
+        set_window_delta(NULL);
+        spectate_end_frame(&spectators);
+    }
+
+    profile_hud();
+    refresh_gfx();
+    profile_frame();
+}
+
 // draws a ship on y, x with height and width on a specific arena
 void draw_ship(int y, int x, int height, int width, int player, int color)
 {
@@ -219,6 +450,45 @@ void draw_ship(int y, int x, int height, int width, int player, int color)
     }
 }
 
+// draws a cell on y, x on a specific arena that is not yet shot
+// * the cells of the computer's arena are shaded by the heat map if it is shown
+void drawUnshotCell(int y, int x, int player)
+{
+    int bucket = player == 1 && showHeat ? heatmap_get_bucket(&heatmap, y, x) : 0;
+    fillOneCell(y, x, player, heatColors[bucket], heatChars[bucket]);
+}
+
+// draws a cell on y, x on a specific arena according to its state
+void drawCell(int y, int x, int player, int state)
+{
+    switch (state)
+    {
+    case CELL_EMPTY:
+        drawUnshotCell(y, x, player); // the cell is not yet shot
+        break;
+    case CELL_SHOT:
+        fillOneCell(y, x, player, aliveShipColor, shotCellChar); // the cell is shot and there is no ship
+        break;
+    case CELL_SHIP:
+        if (player == 0)
+            fillOneCell(y, x, player, interfaceColor, aliveShipChar); // own ships are visible
+        else
+            drawUnshotCell(y, x, player); // ships of the computer are hidden
+        break;
+    case CELL_DAMAGED:
+        fillOneCell(y, x, player, damagedShipColor, damagedShipChar); // the cell is shot and there is a ship
+        break;
+    default:
+        break;
+    }
+}
+
+// rendering adapter, observes state changes of the game engine
+void cellChanged(int player, int y, int x, int state, void *data)
+{
+    drawCell(y, x, player, state);
+}
+
 // clears a ship on y, x with height and width on a specific arena
 void clear_ship(int y, int x, int player, int height, int width)
 {
@@ -226,81 +496,297 @@ void clear_ship(int y, int x, int player, int height, int width)
     {
         for (int j = 0; j < width; j++)
         {
-            fillOneCell(y + 1 * i, x + 1 * j, player, aliveShipColor, emptyCellChar);
-            if (cells[y + 1 * i][x + 1 * j][player] == 2)
+            drawCell(y + 1 * i, x + 1 * j, player, game_get_cell(&game, player, y + 1 * i, x + 1 * j));
+        }
+    }
+}
+
+// resets the cell model of both arenas to blank cells
+void resetCells()
+{
+    for (int player = 0; player < 2; player++)
+        for (int y = 0; y < arenaSize; y++)
+            for (int x = 0; x < arenaSize; x++)
+            {
+                cellView[player][y][x] = 0;
+                cellShown[player][y][x] = 0;
+                cellDirty[player][y][x] = false;
+            }
+
+    dirtyCount = 0;
+}
+
+// rasterizes the static arena frame into an off-screen pad
+// * needs to be called again only when the look of the arenas changes
+void buildArenaFrame()
+{
+    if (arenaFrame)
+        delwin(arenaFrame);
+
+    arenaFrame = newpad(frameHeight, frameWidth);
+    wattrset(arenaFrame, getattrs(stdscr));
+
+    set_window(arenaFrame);
+    draw_arena(1, 2, arenaSize, arenaSize);
+    set_window(NULL);
+}
+
+// copies the arena frame to both arenas and marks all drawn cells as changed
+void drawArenas()
+{
+    copywin(arenaFrame, stdscr, 0, 0, firstPlayersArenaY - 1, firstPlayersArenaX - 2,
+            firstPlayersArenaY - 2 + frameHeight, firstPlayersArenaX - 3 + frameWidth, FALSE);
+    copywin(arenaFrame, stdscr, 0, 0, secondPlayersArenaY - 1, secondPlayersArenaX - 2,
+            secondPlayersArenaY - 2 + frameHeight, secondPlayersArenaX - 3 + frameWidth, FALSE);
+
+    // the frame overwrites the cells with blanks
+    for (int player = 0; player < 2; player++)
+        for (int y = 0; y < arenaSize; y++)
+            for (int x = 0; x < arenaSize; x++)
             {
-                fillOneCell(y + 1 * i, x + 1 * j, player, interfaceColor, aliveShipChar);
+                cellShown[player][y][x] = 0;
+                if (cellView[player][y][x] != 0 && !cellDirty[player][y][x])
+                {
+                    cellDirty[player][y][x] = true;
+                    dirtyCells[dirtyCount++] = (player * arenaSize + y) * arenaSize + x;
+                }
             }
+}
+
+// fits the viewports of the large arenas into the screen
+void layoutViewports()
+{
+    getmaxyx(stdscr, max_y, max_x);
+
+    viewHeight = max_y - viewTop - 2;
+    viewWidth = (max_x - 8) / 2;
+
+    if (viewHeight > arenaSize + 2)
+        viewHeight = arenaSize + 2;
+    if (viewWidth > arenaSize + 2)
+        viewWidth = arenaSize + 2;
+    if (viewHeight < 1)
+        viewHeight = 1;
+    if (viewWidth < 1)
+        viewWidth = 1;
+
+    set_window_size(viewWidth, viewHeight);
+}
+
+// renders the frames of both arenas into the canvas
+void buildCanvas()
+{
+    set_area_size(2 * (arenaSize + 2), arenaSize + 2);
+
+    chtype attrs = COLOR_PAIR(interfaceColor) | (getattrs(stdscr) & ~A_COLOR);
+
+    for (int player = 0; player < 2; player++)
+    {
+        int x1 = player * (arenaSize + 2);
+        int x2 = x1 + arenaSize + 1;
+
+        render_frame(x1, 0, x2, arenaSize + 1);
+
+        // the frame has the color of the interface
+        for (int i = x1; i <= x2; i++)
+        {
+            set_cell(i, 0, get_cell(i, 0) | attrs);
+            set_cell(i, arenaSize + 1, get_cell(i, arenaSize + 1) | attrs);
+        }
+        for (int j = 1; j <= arenaSize; j++)
+        {
+            set_cell(x1, j, get_cell(x1, j) | attrs);
+            set_cell(x2, j, get_cell(x2, j) | attrs);
         }
     }
 }
 
+// renders the large arenas into the canvas and fits their viewports into the screen
+void buildLargeArenas()
+{
+    buildCanvas();
+    layoutViewports();
+}
+
+// mirrors the classic arenas into the canvas, which is drawn for the spectators only
+void buildSpectatorCanvas()
+{
+    buildCanvas();
+
+    if (spectatorPad)
+        delwin(spectatorPad);
+
+    spectatorPad = newpad(arenaSize + 2, 2 * (arenaSize + 2));
+
+    set_window_size(2 * (arenaSize + 2), arenaSize + 2);
+    set_window_offset(0, 0);
+    set_drawing_window(spectatorPad);
+}
+
+// redraws both arenas after the terminal has been resized
+void resizeArenas()
+{
+    if (largeArenas)
+    {
+        clear();
+        layoutViewports();
+        present();
+        return;
+    }
+
+    buildArenaFrame();
+    drawArenas();
+    present();
+}
+
 // draws both arenas
 void setup()
 {
-    draw_arena(firstPlayersArenaY, firstPlayersArenaX, 10, 10);
-    draw_arena(secondPlayersArenaY, secondPlayersArenaX, 10, 10);
+    if (largeArenas)
+    {
+        buildLargeArenas();
+        return;
+    }
+
+    resetCells();
+    buildArenaFrame();
+    drawArenas();
+
+    if (spectating)
+        buildSpectatorCanvas();
 }
 
-// checks a cell on y, x on a specific arena
-int shoot(int y, int x, int player)
+// sends a message to the game server, quits if the connection is broken
+void sendMessage(int type, int a = -1, int b = -1, int c = -1, int d = -1)
 {
-    int status = cells[y][x][player];
-    switch (status)
+    Message m;
+    message_make(&m, type, a, b, c, d);
+
+    if (!protocol_send(serverSocket, &m))
     {
-    case 0:                      // there is nothing
-        cells[y][x][player] = 1; // this cell is now shot
-        fillOneCell(y, x, player, aliveShipColor, shotCellChar);
-        return 1; // means player missed
-        break;
-    case 1: // the cell was shot yet
-        // do nothing
-        return 0; // means no shot was made
-        break;
-    case 2:                      // there is a ship
-        cells[y][x][player] = 3; // the cell has now a damaged ship
-        fillOneCell(y, x, player, damagedShipColor, damagedShipChar);
+        exit_gfx();
+        fprintf(stderr, "The connection to the server is broken.\n");
+        exit(1);
+    }
+}
 
-        // update number of ship cells
-        if (player == 0)
-            firstPlayerShips -= 1;
-        else if (player == 1)
-            secondPlayerShips -= 1;
+// reads the messages that have arrived from the game server without blocking
+void receiveMessages()
+{
+    struct pollfd fds = {serverSocket, POLLIN, 0};
 
-        return 2; // means player hit a ship
-        break;
-    case 3: // there is a damaged ship
-        // do nothing
-        return 0; // means no shot was made
-        break;
-    default:
-        // we should never get here
-        return 0;
-        break;
+    if (poll(&fds, 1, 0) > 0 && !inbox_read(&inbox, serverSocket))
+    {
+        exit_gfx();
+        fprintf(stderr, "The server closed the connection.\n");
+        exit(1);
+    }
+}
+
+// waits for the next message of the game server
+void awaitMessage(Message *m)
+{
+    while (inbox_next(&inbox, m) <= 0)
+        if (!inbox_read(&inbox, serverSocket))
+        {
+            exit_gfx();
+            fprintf(stderr, "The server closed the connection.\n");
+            exit(1);
+        }
+}
+
+// waits for the answer of the game server to a move
+// * an end of the match is recorded, it is no answer
+bool awaitAnswer(Message *m)
+{
+    awaitMessage(m);
+
+    if (m->type == MSG_OVER)
+    {
+        remoteWinner = m->field[0] ? 0 : 1;
+        return false;
     }
+
+    return m->type != MSG_ERROR;
+}
+
+// checks if the game is over
+bool gameOver()
+{
+    if (serverSocket >= 0)
+        return remoteWinner >= 0;
+
+    return game_over(&game);
+}
+
+// gets the winner of the game
+int gameWinner()
+{
+    if (serverSocket >= 0)
+        return remoteWinner;
+
+    return game_winner(&game);
 }
 
-// asks user to manually place 10 ships on a specific arena (1 with size of 4; 2 with size of 3; 3 with size of 2 and 4 with size of 1)
+// checks a cell on y, x on a specific arena
+int shoot(int y, int x, int player)
+{
+    if (serverSocket < 0)
+        return game_shoot(&game, player, y, x); // the rendering adapter draws the changed cell
+
+    // the server reports the result of the shot at the opponent's arena
+    Message m;
+    sendMessage(MSG_SHOOT, y, x);
+    if (!awaitAnswer(&m) || m.type != MSG_SHOT)
+        return SHOT_NONE;
+
+    game_set_cell(&game, 1, y, x, m.field[3] == SHOT_MISS ? CELL_SHOT : CELL_DAMAGED);
+
+    return m.field[3];
+}
+
+// places a ship on y, x with height and width on a specific arena
+bool placeShip(int player, int y, int x, int height, int width)
+{
+    if (serverSocket < 0)
+        return game_place_ship(&game, player, y, x, height, width); // the rendering adapter draws the ship
+
+    // the server checks the placement, the accepted ship is mirrored
+    Message m;
+    sendMessage(MSG_PLACE, y, x, height, width);
+    if (!awaitAnswer(&m) || m.type != MSG_PLACED)
+        return false;
+
+    return game_place_ship(&game, player, y, x, height, width);
+}
+
+// asks user to manually place the ships of the fleet on a specific arena (the default fleet has 1 ship with size of 4; 2 with size of 3; 3 with size of 2 and 4 with size of 1)
 void placeShips(int player)
 {
 
     int y = 0;              // starting x coordinate of new ships
     int x = 0;              // starting y coordinate of new ships
-    int height = 4;         // starting height of new ships
+    int height = game.fleet.size[0]; // starting height of new ships
     int width = 1;          // starting width of new ships
     int shipCounter = 0;    // counting placed ships
-    int cellCounter = 0;    // counts cells filled with ships around the ship
     int tmpHeight;          // to save temporary height of a ship before rotating
     int tmpWidth;           // to save temporary width of a ship before rotating
     int rotationArgument = 0; // saves the rotation aspect of a ship (even -> vertical; odd -> horizontal)
+    bool changed = true;    // decides if the ship needs to be redrawn
 
-    while (shipCounter < 10)
+    while (shipCounter < game.fleet.count && !gameOver())
     {
-        draw_ship(y, x, height, width, player, 1);
-        refresh();
+        if (changed)
+        {
+            draw_ship(y, x, height, width, player, 1);
+            focusY[player] = y;
+            focusX[player] = x;
+            present();
+        }
+        changed = true;
 
-        // asks for key input
-        switch (getch())
+        // waits for key input
+        switch (wait_keycode())
         {
         case 'w':
         case 'W':
@@ -320,14 +806,14 @@ void placeShips(int player)
         case 'S':
         case KEY_DOWN: // down
             clear_ship(y, x, player, height, width);
-            if (y + height < 10)
+            if (y + height < arenaSize)
                 y += 1;
             break;
         case 'd':
         case 'D':
         case KEY_RIGHT: // right
             clear_ship(y, x, player, height, width);
-            if (x + width < 10)
+            if (x + width < arenaSize)
                 x += 1;
             break;
         case 'r': // rotates the ship
@@ -343,94 +829,42 @@ void placeShips(int player)
             rotationArgument++;
 
             // check if rotation is possible without leaving arena
-            if ((y + height - 1) > 9)
+            if ((y + height - 1) > arenaSize - 1)
             {
                 y -= height - 1;
             }
-            if ((x + width - 1) > 9)
+            if ((x + width - 1) > arenaSize - 1)
             {
                 x -= width - 1;
             }
 
             break;
         case ' ': // places the ship
-            // check if there is already a ship
-            for (int i = 0; i < height + 2; i++)
+            // save the ship if there is no other ship around (the rendering adapter draws the ship)
+            if (placeShip(player, y, x, height, width))
             {
-                for (int j = 0; j < width + 2; j++)
-                {
-                    int cellY = (y - 1) + 1 * i;
-                    int cellX = (x - 1) + 1 * j;
-
-                    if (cells[cellY][cellX][0] == 2 && cellY >= 0 && cellX >= 0 && cellY <= 9 && cellX <= 9)
-                    {
-                        cellCounter++;
-                    }
-                }
-            }
-
-            if (cellCounter == 0) // means there are no ships
-            {
-
-                // save the ship into an array
-                for (int i = y; i < y + height; i++)
-                {
-                    for (int j = x; j < x + width; j++)
-                    {
-                        cells[i][j][player] = 2; // value 2 means there is a ship now
-                    }
-                }
-
-                // draw the ship
-                draw_ship(y, x, height, width, player, 3);
-
                 // count placed ships
                 shipCounter++;
 
                 // set size of the next ship
-                switch (shipCounter)
+                if (shipCounter < game.fleet.count)
                 {
-                // 2 ships with size 3
-                case 1:
-                case 2:
                     if (rotationArgument % 2 == 1)
                     { // horizontal
                         height = 1;
-                        width = 3;
+                        width = game.fleet.size[shipCounter];
                     }
                     else
                     { // vertical
-                        height = 3;
+                        height = game.fleet.size[shipCounter];
                         width = 1;
                     }
 
-                    break;
-                // 3 ships with size 2
-                case 3:
-                case 4:
-                case 5:
-                    if (rotationArgument % 2 == 1)
-                    { // horizontal
-                        height = 1;
-                        width = 2;
-                    }
-                    else
-                    { // vertical
-                        height = 2;
-                        width = 1;
-                    }
-                    break;
-                // 4 ships with size 1
-                case 6:
-                case 7:
-                case 8:
-                case 9:
-                    height = 1;
-                    width = 1;
-                    break;
-                default:
-                    // do nothing
-                    break;
+                    // a larger ship may not fit at the position of the previous one
+                    if (y + height > arenaSize)
+                        y = arenaSize - height;
+                    if (x + width > arenaSize)
+                        x = arenaSize - width;
                 }
             }
             else
@@ -438,9 +872,6 @@ void placeShips(int player)
                 sound_play("Sounds/error.wav"); // ship cannot be placed -> plays error sound
             }
 
-            // reset cell counter
-            cellCounter = 0;
-
             break;
         case 'q':
         case 'Q':
@@ -448,284 +879,300 @@ void placeShips(int player)
             exit_gfx();
             exit(0);
             break;
+        case KEY_RESIZE:
+            resizeArenas();
+            break;
         default:
             // do nothing
+            changed = false;
             break;
         }
     }
 
-    // update number of ships (start = 20)
-    if (player == 0)
-        firstPlayerShips = 20;
-    else if (player == 1)
-        secondPlayerShips = 20;
-
     // play the sound of placed ships
     sound_play("Sounds/correct.wav");
 }
 
-// automatically generates 10 ships on a specific arena (1 with size of 4; 2 with size of 3; 3 with size of 2 and 4 with size of 1)
+// automatically generates the ships of the fleet on a specific arena
 void generateRandomShips(int player)
 {
-    int y = 0;           // starting x coordinate of new ships
-    int x = 0;           // starting y coordinate of new ships
-    int sizeY = 4;       // starting height of new ships
-    int sizeX = 1;       // starting width of new ships
-    int shipCounter = 0; // counting placed ships
-    int cellCounter = 0; // counts cells filled with ships arround the ship
-    int tmpSizeY;        // to save temporary height of a ship before rotating
-    int tmpSizeX;        // to save temporary width of a ship before rotating
-    int rotationArgument;
-
-    while (shipCounter < 10)
+    // the server generates the fleet, the placed ships are mirrored
+    if (serverSocket >= 0)
     {
+        sendMessage(MSG_RANDOM);
 
-        // generate rotation argument of a ship (0 - vertical; 1 - horizontal)
-        rotationArgument = (rand() % 2);
-        // rotation
-        if (rotationArgument == 1)
-        {
-            // swap width and height
-            tmpSizeY = sizeY;
-            tmpSizeX = sizeX;
-
-            sizeY = tmpSizeX;
-            sizeX = tmpSizeY;
-        }
+        Message m;
+        for (int k = 0; k < game.fleet.count && awaitAnswer(&m) && m.type == MSG_PLACED; k++)
+            game_place_ship(&game, player, m.field[0], m.field[1], m.field[2], m.field[3]);
 
-        // generate random y coordinate of a ship
-        y = (rand() % (10 - (sizeY - 1)));
+        return;
+    }
 
-        // generate random x coordinate of a ship
-        x = (rand() % (10 - (sizeX - 1)));
+    if (!game_random_ships(&game, player)) // the rendering adapter draws the ships of the first player
+    {
+        exit_gfx();
+        fprintf(stderr, "The fleet does not fit into the arena.\n");
+        exit(1);
+    }
+}
 
-        // check if there is already a ship
-        for (int i = 0; i < sizeY + 2; i++)
-        {
-            for (int j = 0; j < sizeX + 2; j++)
-            {
-                int cellY = (y - 1) + i;
-                int cellX = (x - 1) + j;
+// clears the pointer on y, x position. used in turn() method
+void clearPointer(int y, int x)
+{
+    drawCell(y, x, 1, game_get_cell(&game, 1, y, x));
+}
 
-                if (cellY >= 0 && cellX >= 0 && cellY <= 9 && cellX <= 9)
-                {
-                    if (cells[cellY][cellX][player] == 2)
-                    {
-                        cellCounter++;
-                    }
-                }
-            }
-        }
+// updates the heat map with the result of a shot at the computer's arena
+// * only the cells whose shading changed are redrawn
+void updateHeat(int y, int x, int result)
+{
+    ai_update(&observer, y, x, result);
 
-        if (cellCounter == 0) // means there are no ships
-        {
-            // save the ship into an array
-            for (int i = y; i < y + sizeY; i++)
-            {
-                for (int j = x; j < x + sizeX; j++)
-                {
-                    cells[i][j][player] = 2; // value 2 means there is a ship now
-                }
-            }
+    int changes = heatmap_update(&heatmap);
+    if (!showHeat)
+        return;
 
-            if (!manualShipPlacement && player == 0)
-                draw_ship(y, x, sizeY, sizeX, player, 3);
+    for (int i = 0; i < changes; i++)
+    {
+        int cy, cx;
+        heatmap_get_changed(&heatmap, i, &cy, &cx);
+        drawCell(cy, cx, 1, game_get_cell(&game, 1, cy, cx));
+    }
+}
 
-            // count placed ships
-            shipCounter++;
+// shows or hides the heat map of the computer's arena
+void toggleHeat()
+{
+    showHeat = !showHeat;
 
-            // set size of the next ship
-            switch (shipCounter)
-            {
-            // 2 ships with size 3
-            case 1:
-            case 2:
-                sizeY = 3;
-                sizeX = 1;
-                break;
-            // 3 ships with size 2
-            case 3:
-            case 4:
-            case 5:
-                sizeY = 2;
-                sizeX = 1;
-                break;
-            // 4 ships with size 1
-            case 6:
-            case 7:
-            case 8:
-            case 9:
-                sizeY = 1;
-                sizeX = 1;
-                break;
-            default:
-                // do nothing
-                break;
-            }
-        }
+    for (int y = 0; y < arenaSize; y++)
+        for (int x = 0; x < arenaSize; x++)
+            if (heatmap_get_bucket(&heatmap, y, x) != 0)
+                drawCell(y, x, 1, game_get_cell(&game, 1, y, x));
+}
 
-        // reset cell counter
-        cellCounter = 0;
-    }
+// redraws the pointer, e.g. after the effect of a shot has been played
+void showPointer(void *data)
+{
+    fillOneCell(yPointer, xPointer, 1, interfaceColor, pointerChar);
+    focusY[1] = yPointer;
+    focusX[1] = xPointer;
+    present();
+}
 
-    // update number of ships (start = 20)
-    if (player == 0)
-        firstPlayerShips = 20;
-    else if (player == 1)
-        secondPlayerShips = 20;
+// starts the turn of the first player
+void startTurn(void *data)
+{
+    playersTurn = true;
+    showPointer(data);
 }
 
-// clears the pointer on y, x position. used in turn() method
-void clearPointer(int y, int x)
+// generates a shot of the computer, the computer shoots again after a hit
+void computerTurn(void *data)
 {
-    switch (cells[y][x][1])
+    int y = 0;
+    int x = 0;
+
+    if (game_over(&game) || !ai_choose(&ai, &y, &x)) // choose the cell that is most likely to contain a ship
     {
-    case 0:
-    case 2:
-        fillOneCell(y, x, 1, aliveShipColor, emptyCellChar); // the cell is not yet shot
-        break;
-    case 1:
-        fillOneCell(y, x, 1, aliveShipColor, shotCellChar); // the cell is shot and there is no ship
+        startTurn(NULL);
+        return;
+    }
+
+    int result = shoot(y, x, 0);  // make a shot
+    ai_update(&ai, y, x, result); // update the remaining ship placements
+    focusY[0] = y;                // follow the shot on large arenas
+    focusX[0] = x;
+    present();                    // draw the changed cells and refresh the screen
+
+    switch (result)
+    {
+    case 1:                                                   // computer missed
+        sound_play("Sounds/splash.wav");                      // playing sound of a splash
+        timeline_schedule(&timeline, effectDelay, startTurn); // the player's turn starts after the splash
         break;
-    case 3:
-        fillOneCell(y, x, 1, damagedShipColor, damagedShipChar); // the cell is shot and there is a ship
+    case 2:
+    case 3:                                                      // computer hit a ship
+        sound_play("Sounds/explosion.wav");                      // playing sound of an explosion
+        timeline_schedule(&timeline, effectDelay, computerTurn); // the computer shoots again after the explosion
         break;
     default:
+        startTurn(NULL);
         break;
     }
 }
 
-// lets first player to make a turn
-void turn()
+// handles the received messages of the game server, the opponent's shots are played one by one
+// * stops at the first message that starts an effect, the next message is handled after the effect
+void networkTurn(void *data)
 {
+    Message m;
 
-    bool missed = false;
-    int result;
-    while (!missed && secondPlayerShips != 0 && secondPlayerShips != 0)
+    while (!timeline_pending(&timeline) && !gameOver() && inbox_next(&inbox, &m) > 0)
     {
-        fillOneCell(yPointer, xPointer, 1, interfaceColor, pointerChar);
-        refresh();
-
-        // asks for key input
-        switch (getch())
+        switch (m.type)
         {
-        case 'w':
-        case 'W':
-        case KEY_UP: // up
-            clearPointer(yPointer, xPointer);
-            if (yPointer > 0)
-                yPointer -= 1;
+        case MSG_START:
+            if (m.field[0])
+                startTurn(NULL);
             break;
-        case 'a':
-        case 'A':
-        case KEY_LEFT: // left
-            clearPointer(yPointer, xPointer);
-            if (xPointer > 0)
-                xPointer -= 1;
+        case MSG_SHOT:
+            // the results of the own shots are answers, see shoot()
+            if (m.field[0] != 0)
+                break;
+
+            game_shoot(&game, 0, m.field[1], m.field[2]); // the rendering adapter draws the changed cell
+            focusY[0] = m.field[1];                       // follow the shot on large arenas
+            focusX[0] = m.field[2];
+            present();
+
+            sound_play(m.field[3] == SHOT_MISS ? "Sounds/splash.wav" : "Sounds/explosion.wav");
+            timeline_schedule(&timeline, effectDelay, m.field[4] ? startTurn : networkTurn); // the next shot follows after the effect
             break;
-        case 's':
-        case 'S':
-        case KEY_DOWN: // down
-            clearPointer(yPointer, xPointer);
-            if (yPointer < 9)
-                yPointer += 1;
+        case MSG_OVER:
+            remoteWinner = m.field[0] ? 0 : 1;
             break;
-        case 'd':
-        case 'D':
-        case KEY_RIGHT: // right
-            clearPointer(yPointer, xPointer);
-            if (xPointer < 9)
-                xPointer += 1;
+        default:
             break;
-        case ' ': // shot
-            clearPointer(yPointer, xPointer);
+        }
+    }
+}
 
-            // refresh the screen
-            refresh();
-            // check the cell at y, x
+// handles a key of the first player during their turn
+void turn(int key)
+{
+    bool changed = true; // decides if the pointer needs to be redrawn
+    int result;
 
-            result = shoot(yPointer, xPointer, 1);
-            // refresh the screen
-            refresh();
+    switch (key)
+    {
+    case 'w':
+    case 'W':
+    case KEY_UP: // up
+        clearPointer(yPointer, xPointer);
+        if (yPointer > 0)
+            yPointer -= 1;
+        break;
+    case 'a':
+    case 'A':
+    case KEY_LEFT: // left
+        clearPointer(yPointer, xPointer);
+        if (xPointer > 0)
+            xPointer -= 1;
+        break;
+    case 's':
+    case 'S':
+    case KEY_DOWN: // down
+        clearPointer(yPointer, xPointer);
+        if (yPointer < arenaSize - 1)
+            yPointer += 1;
+        break;
+    case 'd':
+    case 'D':
+    case KEY_RIGHT: // right
+        clearPointer(yPointer, xPointer);
+        if (xPointer < arenaSize - 1)
+            xPointer += 1;
+        break;
+    case ' ': // shot
+        clearPointer(yPointer, xPointer);
 
-            switch (result)
-            {
-            case 0: // no shot by player was made
-                missed = false;
-                sound_play("Sounds/error.wav"); // shot cannot be made -> plays error sound
-                break;
-            case 1: // player missed
-                missed = true;
-                sound_play("Sounds/splash.wav"); // playing sound of a splash
-                msleep(2000);
-                break;
-            case 2:
-                missed = false;                     // player hit a ship
-                sound_play("Sounds/explosion.wav"); // playing sound of an explosion
-                msleep(2000);                       // pause before drawing pointer again so player sees the damaged ship
-                break;
-            default:
-                break;
-            }
-            break;
-        case 'q':
-        case 'Q':
-            exit_gfx();
-            exit(0);
+        // check the cell at y, x
+        result = shoot(yPointer, xPointer, 1);
+        if (result != SHOT_NONE)
+            updateHeat(yPointer, xPointer, result);
 
+        // draw the changed cells and refresh the screen
+        present();
+
+        switch (result)
+        {
+        case 0:                             // no shot by player was made
+            sound_play("Sounds/error.wav"); // shot cannot be made -> plays error sound
+            break;
+        case 1: // player missed
+            playersTurn = false;
+            changed = false;
+            sound_play("Sounds/splash.wav");                          // playing sound of a splash
+            timeline_schedule(&timeline, effectDelay, serverSocket < 0 ? computerTurn : networkTurn); // the opponent's turn starts after the splash
+            break;
+        case 2:
+        case 3: // player hit a ship
+            changed = false;
+            sound_play("Sounds/explosion.wav");                     // playing sound of an explosion
+            timeline_schedule(&timeline, effectDelay, showPointer); // pause before drawing pointer again so player sees the damaged ship
             break;
         default:
             break;
         }
+        break;
+    case 'h': // shows or hides the heat map
+    case 'H':
+        toggleHeat();
+        break;
+    default:
+        changed = false;
+        break;
     }
+
+    if (changed)
+        showPointer(NULL);
 }
 
-// generates a computers turn
-void computerTurn()
+// replays the next move of the replay log, the following move is replayed after a delay
+void replayMove(void *data)
 {
-    int y = 0;
-    int x = 0;
-    bool missed = false;
-    int result;
+    ReplayMove m;
+    int result = SHOT_NONE;
 
-    if (tolower(getch()) == 'q')
-    {
-        exit_gfx();
-        exit(0);
-    }
+    // the replay stops at the end of the log or at an illegal move
+    if (!replay_next(&replay, &m) || !replay_apply(&game, &m, &result)) // the rendering adapter draws the changed cells
+        return;
 
-    while (!missed && firstPlayerShips != 0 && secondPlayerShips != 0)
-    {
-        y = rand() % 10; // generate y coordinate of a shot
-        x = rand() % 10; // generate x coordinate of a shot
+    // follow the move on large arenas
+    focusY[m.player] = m.y;
+    focusX[m.player] = m.x;
+    present();
+
+    if (m.type == REPLAY_SHOT)
+        sound_play(result == SHOT_MISS ? "Sounds/splash.wav" : "Sounds/explosion.wav");
 
-        result = shoot(y, x, 0); // make a shot
-        refresh();               // refresh the screen
+    timeline_schedule(&timeline, 1000 / replaySpeed, replayMove);
+}
 
-        if (tolower(getch()) == 'q')
+// replays a recorded game, keys change the speed
+void replayGame()
+{
+    timeline_schedule(&timeline, 0, replayMove);
+
+    // replay loop, waits for input until the next move is due
+    while (timeline_pending(&timeline))
+    {
+        int key = wait_keycode(timeline_timeout(&timeline));
+
+        switch (key)
         {
+        case 'q':
+        case 'Q':
             exit_gfx();
             exit(0);
-        }
-
-        switch (result)
-        {
-        case 0: // no shot by computer was made
-            missed = false;
             break;
-        case 1: // computer missed
-            missed = true;
-            sound_play("Sounds/splash.wav"); // playing sound of a splash
-            msleep(2000);
+        case '+': // doubles the speed
+            if (replaySpeed < 1000)
+                replaySpeed *= 2;
             break;
-        case 2:
-            missed = false;                     // computer hit a ship
-            sound_play("Sounds/explosion.wav"); // playing sound of an explosion
-            msleep(2000);
+        case '-': // halves the speed
+            if (replaySpeed > 0.25)
+                replaySpeed /= 2;
+            break;
+        case KEY_RESIZE:
+            resizeArenas();
             break;
         default:
             break;
         }
+
+        timeline_run(&timeline);
     }
 }
 
@@ -735,7 +1182,7 @@ void playerWon()
     // gray
     use_color(1);
 
-    if (secondPlayerShips == 0)
+    if (gameWinner() == 0)
     {
         const char text[] = "YOU WON!";
         int tx = max_x / 2;
@@ -745,9 +1192,9 @@ void playerWon()
 
         sound_play("Sounds/win.wav"); // play a win sound
     }
-    if (firstPlayerShips == 0)
+    if (gameWinner() == 1)
     {
-        const char text[] = "COMPUTER WON!";
+        const char *text = versusMode ? "YOU LOST!" : "COMPUTER WON!";
         int tx = max_x / 2;
         int ty = (max_y - 4) / 2 + 1;
         init_grid_font();
@@ -795,7 +1242,7 @@ void chooseGameMode()
 
     while (menuChoiceMade == false)
     {
-        switch (getch())
+        switch (wait_keycode())
         {
         case 'd':
         case 'D':
@@ -845,9 +1292,269 @@ void chooseGameMode()
     clear();
 }
 
+// plays a game against the computer
+void playGame()
+{
+    // draws the intro, including game's name and hint to start the game
+    intro();
+
+    // lets the player decide how they want to place their ships (manual or automatically)
+    chooseGameMode();
+
+    // draws two arenas for two players
+    setup();
+
+    // lets the first player to place their ships or generates them
+    if (manualShipPlacement)
+        placeShips(0);
+    else
+        generateRandomShips(0);
+
+    // generate random ships on the second arena, the server hides the opponent's ships
+    if (serverSocket < 0)
+        generateRandomShips(1);
+
+    // the first player starts, the server decides who starts a network game
+    if (serverSocket < 0)
+        startTurn(NULL);
+    else
+        playersTurn = false;
+
+    // the messages of the server wake up the game loop
+    if (serverSocket >= 0)
+    {
+        watch_input(serverSocket);
+        present();
+    }
+
+    // game loop, waits for input until the next effect is due
+    while (!gameOver() || timeline_pending(&timeline))
+    {
+        // the messages of the server are handled while no effect is playing
+        if (serverSocket >= 0)
+        {
+            receiveMessages();
+            networkTurn(NULL);
+
+            if (gameOver() && !timeline_pending(&timeline))
+                break;
+        }
+
+        int key = wait_keycode(timeline_timeout(&timeline));
+
+        if (tolower(key) == 'q')
+        {
+            exit_gfx();
+            if (spectating)
+                spectate_stop(&spectators);
+            exit(0);
+        }
+
+        if (key == KEY_RESIZE)
+            resizeArenas();
+
+        // players turn, keys are ignored while an effect is playing
+        if (key != ERR && playersTurn && !timeline_pending(&timeline))
+            turn(key);
+
+        // effects and computers turn
+        timeline_run(&timeline);
+    }
+
+    watch_input(-1);
+}
+
+// exports the frame profile when the game exits, however it is quit
+void exportProfile()
+{
+    if (!profile_export_trace(profilePath))
+        fprintf(stderr, "Cannot write the frame profile %s.\n", profilePath);
+}
+
+// parses the value of an option like -size=n
+// * returns false if the option has no value or the value is not a number
+bool getValue(const char *opt, double *value)
+{
+    const char *del = strchr(opt, '=');
+    if (!del || !del[1])
+        return false;
+
+    char *end;
+    *value = strtod(del + 1, &end);
+
+    return *end == 0;
+}
+
 // main method
-int main()
+int main(int argc, char *argv[])
 {
+    fleet_default(&fleet);
+
+    // parse launch parameters
+    for (int i = 1; get_opt(i, argc, argv) != NULL; i++)
+    {
+        double value;
+        const char *opt = get_opt(i, argc, argv);
+
+        // options with a numeric value
+        bool numeric = strpre("budget", opt) == 0 || strpre("endgame", opt) == 0 || strpre("seed", opt) == 0 ||
+                       strpre("size", opt) == 0 || strpre("speed", opt) == 0;
+        if (numeric && !getValue(opt, &value))
+        {
+            fprintf(stderr, "Invalid value: %s\n", opt);
+            return (1);
+        }
+
+        if (strpre("hard", opt) == 0)
+            hardOpponent = true;
+        else if (strpre("exact", opt) == 0)
+            exactHeat = true;
+        else if (strpre("budget", opt) == 0)
+            moveBudget = value;
+        else if (strpre("endgame", opt) == 0)
+            endgameBudget = value;
+        else if (strpre("seed", opt) == 0)
+            randomSeed = value;
+        else if (strpre("fast", opt) == 0)
+            fastMode = true;
+        else if (strpre("size", opt) == 0)
+            arenaSize = value;
+        else if (strpre("fleet", opt) == 0)
+        {
+            if (!strchr(opt, '=') || !fleet_parse(&fleet, strchr(opt, '=') + 1))
+            {
+                fprintf(stderr, "Invalid fleet: %s\n", opt);
+                return (1);
+            }
+        }
+        else if (strpre("record", opt) == 0)
+            recordPath = strchr(opt, '=') ? strchr(opt, '=') + 1 : replay_default_file;
+        else if (strpre("replay", opt) == 0 && strchr(opt, '='))
+            replayPath = strchr(opt, '=') + 1;
+        else if (strpre("speed", opt) == 0)
+        {
+            if (value <= 0)
+            {
+                fprintf(stderr, "Invalid value: %s\n", opt);
+                return (1);
+            }
+
+            replaySpeed = value;
+        }
+        else if (strpre("connect", opt) == 0)
+            connectPath = strchr(opt, '=') ? strchr(opt, '=') + 1 : protocol_default_socket;
+        else if (strpre("versus", opt) == 0)
+            versusMode = true;
+        else if (strpre("spectate", opt) == 0)
+            spectatePath = strchr(opt, '=') ? strchr(opt, '=') + 1 : spectate_default_socket;
+        else if (strpre("profile", opt) == 0)
+            profilePath = strchr(opt, '=') ? strchr(opt, '=') + 1 : "sinkships.trace.json";
+    }
+
+    // a network game is played with the arena size and fleet of the server
+    if (connectPath && !replayPath)
+    {
+        serverSocket = protocol_connect(connectPath);
+        if (serverSocket < 0)
+        {
+            fprintf(stderr, "Cannot connect to the server %s.\n", connectPath);
+            return (1);
+        }
+
+        Message m;
+        message_make(&m, MSG_JOIN, versusMode ? MATCH_VERSUS : MATCH_COMPUTER);
+        inbox_init(&inbox);
+
+        bool joined = protocol_send(serverSocket, &m);
+        while (joined && inbox_next(&inbox, &m) <= 0)
+            joined = inbox_read(&inbox, serverSocket);
+
+        if (!joined || m.type != MSG_WELCOME || m.count < 2 || m.field[1] != m.count - 2)
+        {
+            fprintf(stderr, "The server %s did not accept the game.\n", connectPath);
+            return (1);
+        }
+
+        arenaSize = m.field[0];
+        if (arenaSize < 1 || arenaSize > board_max_size)
+        {
+            fprintf(stderr, "The server %s sent an invalid arena.\n", connectPath);
+            return (1);
+        }
+
+        // the fleet of a malformed welcome must not overflow the fleet sizes
+        fleet.count = m.field[1];
+        if (fleet.count > fleet_max_ships)
+            fleet.count = 0;
+        for (int i = 0; i < fleet.count; i++)
+            fleet.size[i] = m.field[2 + i];
+
+        if (!fleet_valid(&fleet, arenaSize))
+        {
+            fprintf(stderr, "The server %s sent an invalid fleet.\n", connectPath);
+            return (1);
+        }
+    }
+
+    // a replayed game brings its own seed, arena size and fleet
+    if (replayPath)
+    {
+        if (!replay_load(&replay, replayPath))
+        {
+            fprintf(stderr, "Cannot read the replay log %s.\n", replayPath);
+            return (1);
+        }
+
+        randomSeed = replay.seed;
+        arenaSize = replay.size;
+        fleet = replay.fleet;
+    }
+
+    if (arenaSize < 1 || arenaSize > board_max_size)
+    {
+        fprintf(stderr, "The arena size must be between 1 and %d.\n", board_max_size);
+        return (1);
+    }
+
+    // the fleet must fit into the arena before the screen is taken over
+    // * a fleet may pass the size check and still have no legal layout, so one fleet is generated
+    fleetgen_init(&generator, &fleet, arenaSize);
+    bool fits = fleet_valid(&fleet, arenaSize);
+    if (fits)
+    {
+        Board board;
+        Random random;
+        board_init(&board, arenaSize);
+        rnd_seed(&random, randomSeed);
+        fits = fleetgen_generate(&generator, &board, &random);
+        board_free(&board);
+    }
+
+    if (!fits)
+    {
+        fprintf(stderr, "The fleet does not fit into the arena.\n");
+        fleetgen_free(&generator);
+        return (1);
+    }
+
+    // the layout of the arenas depends on their size
+    largeArenas = arenaSize > maxClassicSize;
+    secondPlayersArenaX = firstPlayersArenaX + cellWidth * arenaSize + offsetBetweenArenas;
+    frameHeight = (cellHeight - 1) * arenaSize + 2;
+    frameWidth = (cellWidth - 1) * arenaSize + 3;
+
+    // spectators connect to their own socket
+    if (spectatePath)
+    {
+        if (!spectate_start(&spectators, spectatePath))
+        {
+            fprintf(stderr, "Cannot open the spectator socket %s.\n", spectatePath);
+            return (1);
+        }
+
+        spectating = true;
+    }
+
     // initialize frameworks
     init_gfx();
     init_color();
@@ -856,30 +1563,57 @@ int main()
     // get screen size
     getmaxyx(stdscr, max_y, max_x);
 
-    // generates new seed for random numbers
-    srand(time(NULL));
+    // initializes the game state and the computer with separate streams of the same seed
+    rnd_seed(randomSeed);
+    game_init(&game, &fleet, randomSeed, 0, arenaSize);
+    game_set_generator(&game, &generator);
+    game_set_observer(&game, cellChanged);
+    ai_init(&ai, &generator, hardOpponent ? AI_MONTECARLO : AI_DENSITY, randomSeed, 1);
+    ai_init(&observer, &generator, AI_DENSITY, randomSeed, 2);
+    heatmap_init(&heatmap, &observer, exactHeat);
+    if (hardOpponent)
+    {
+        sampler = pool_create();
+        ai_set_sampler(&ai, sampler, moveBudget);
+    }
+    if (endgameBudget > 0)
+    {
+        solver_init(&solver, endgameBudget);
+        ai_set_solver(&ai, &solver);
+    }
+    timeline_init(&timeline, fastMode ? 0 : 1);
+    profile_enable(profilePath != NULL);
+    if (profilePath)
+        atexit(exportProfile);
+
+    // records all placements and shots of a played game
+    if (!replayPath && serverSocket < 0 && recordPath)
+        if (replay_create(&replay, recordPath, randomSeed, arenaSize, &game.fleet))
+            game_set_replay(&game, &replay);
 
     // makes all chars bold
     use_attr_bold();
 
-    // check resolution of the terminal window
-    if (COLS < 189 || LINES < 44) // smaller than required
+    // check resolution of the terminal window, large arenas are scrolled
+    int requiredCols = largeArenas ? 80 : secondPlayersArenaX + (cellWidth - 1) * arenaSize + 4;
+    int requiredLines = largeArenas ? 24 : firstPlayersArenaY + (cellHeight - 1) * arenaSize + 1;
+    if (COLS < requiredCols || LINES < requiredLines) // smaller than required
     {
         // prints out that the terminal window is too small
         move(1, 1);
-        printw("Your current terminal resolution is %d x %d, which is too small. The minimum required resolution is 190 x 45.", COLS, LINES);
+        printw("Your current terminal resolution is %d x %d, which is too small. The minimum required resolution is %d x %d.", COLS, LINES, requiredCols + 1, requiredLines + 1);
 
         move(2, 1);
         printw("Please, check your terminal settings and try again.");
 
         move(3, 1);
-        printw("Press 'q' to quit.", COLS, LINES);
+        printw("Press 'q' to quit.");
 
         refresh();
 
         // wait for pressing 'q' to quit the game
-        while (tolower(getch()) != 'q')
-            msleep(1);
+        while (tolower(wait_keycode()) != 'q')
+            ;
 
         // exit gfx framework
         exit_gfx();
@@ -887,38 +1621,15 @@ int main()
         return (0);
     }
 
-    // draws the intro, including game's name and hint to start the game
-    intro();
-
-    // lets the player decide how they want to place their ships (manual or automatically)
-    chooseGameMode();
-
-    // draws two arenas for two players
-    setup();
-
-    // lets the first player to place their ships or generates them
-    if (manualShipPlacement)
-        placeShips(0);
+    // replays a recorded game instead of playing
+    if (replayPath)
+    {
+        setup();
+        replayGame();
+    }
     else
-        generateRandomShips(0);
-
-    // generate random ships on the second arena
-    generateRandomShips(1);
-
-    // game loop
-    while (firstPlayerShips != 0 && secondPlayerShips != 0)
     {
-        // players turn
-        turn();
-
-        // refresh the window
-        refresh();
-
-        // computers turn
-        computerTurn();
-
-        // refresh the window
-        refresh();
+        playGame();
     }
 
     // clear the screen
@@ -928,11 +1639,28 @@ int main()
     playerWon();
 
     // wait for pressing 'q' to quit the game
-    while (tolower(getch()) != 'q')
-        msleep(1);
+    while (tolower(wait_keycode()) != 'q')
+        ;
 
     // exit gfx framework
     exit_gfx();
 
+    if (largeArenas || spectating)
+        release_area();
+    if (spectating)
+        spectate_stop(&spectators);
+    if (serverSocket >= 0)
+        close(serverSocket);
+    replay_close(&replay);
+    if (endgameBudget > 0)
+        solver_free(&solver);
+    if (sampler)
+        pool_destroy(sampler);
+    heatmap_free(&heatmap);
+    ai_free(&observer);
+    ai_free(&ai);
+    fleetgen_free(&generator);
+    game_free(&game);
+
     return (0);
 }
@@ -0,0 +1,64 @@
+// Sink Ships placement index
+
+#include "placement.h"
+
+// create the index of all placements of a ship length on a board with size x size cells
+void placement_list_init(PlacementList *l, int size, int length)
+{
+    l->length = length;
+    l->count = 0;
+
+    pset_clear(&l->all);
+    for (int i = 0; i < bitboard_size * bitboard_size; i++)
+        pset_clear(&l->cover[i]);
+
+    if (length < 1 || length > size)
+        return;
+
+    // vertical and horizontal orientation, a single cell only once
+    for (int o = 0; o < (length > 1 ? 2 : 1); o++)
+    {
+        int height = o ? 1 : length;
+        int width = o ? length : 1;
+
+        for (int y = 0; y + height <= size; y++)
+            for (int x = 0; x + width <= size; x++)
+            {
+                int p = l->count++;
+
+                PlacementRef r = {(signed char)y, (signed char)x,
+                                  (signed char)height, (signed char)width,
+                                  get_placement(length, o == 1, y, x)};
+                l->ref[p] = r;
+
+                pset_add(&l->all, p);
+
+                for (int i = y; i < y + height; i++)
+                    for (int j = x; j < x + width; j++)
+                        pset_add(&l->cover[bits_index(i, j)], p);
+            }
+    }
+}
+
+// select the n-th placement of a placement set
+int pset_select(const PlacementSet *s, int n)
+{
+    for (int i = 0; i < placement_words; i++)
+    {
+        uint64_t w = s->w[i];
+        int c = __builtin_popcountll(w);
+
+        if (n < c)
+        {
+            // drop the lowest n set bits
+            while (n-- > 0)
+                w &= w - 1;
+
+            return (i << 6) + __builtin_ctzll(w);
+        }
+
+        n -= c;
+    }
+
+    return -1;
+}
@@ -0,0 +1,84 @@
+// Sink Ships placement index
+// * enumerates all placements of a ship length that lie inside the board
+// * sets of placements are represented by bitsets over the placement numbers
+// * only arenas within the bitboard size are indexed
+
+#pragma once
+
+#include "bitboard.h"
+
+//! maximum number of placements per ship length
+const int placement_max = 2 * bitboard_size * bitboard_size;
+
+//! number of 64-bit words of a placement set
+const int placement_words = (placement_max + 63) / 64;
+
+//! placement set type
+struct PlacementSet
+{
+    uint64_t w[placement_words];
+};
+
+//! placement reference
+struct PlacementRef
+{
+    signed char y, x;      // top-left position
+    signed char height;    // extent in y-direction
+    signed char width;     // extent in x-direction
+    const Placement *mask; // the precomputed placement masks
+};
+
+//! index of all placements of a ship length
+struct PlacementList
+{
+    int length;                      // the ship length
+    int count;                       // the number of placements
+    PlacementRef ref[placement_max]; // the placements
+    PlacementSet all;                // the set of all placements
+
+    // the placements covering a cell, indexed by the bit index of the cell
+    PlacementSet cover[bitboard_size * bitboard_size];
+};
+
+//! create the index of all placements of a ship length on a board with size x size cells
+//! * ships of length 1 are enumerated only once
+void placement_list_init(PlacementList *l, int size, int length);
+
+//! clear a placement set
+inline void pset_clear(PlacementSet *s)
+{
+    for (int i = 0; i < placement_words; i++)
+        s->w[i] = 0;
+}
+
+//! add placement number p to a placement set
+inline void pset_add(PlacementSet *s, int p)
+{
+    s->w[p >> 6] |= (uint64_t)1 << (p & 63);
+}
+
+//! check whether placement number p is contained in a placement set
+inline bool pset_test(const PlacementSet *s, int p)
+{
+    return (s->w[p >> 6] >> (p & 63)) & 1;
+}
+
+//! remove the placements of another set from a placement set
+inline void pset_remove(PlacementSet *s, const PlacementSet *r)
+{
+    for (int i = 0; i < placement_words; i++)
+        s->w[i] &= ~r->w[i];
+}
+
+//! count the placements of a placement set
+inline int pset_count(const PlacementSet *s)
+{
+    int c = 0;
+    for (int i = 0; i < placement_words; i++)
+        c += __builtin_popcountll(s->w[i]);
+    return c;
+}
+
+//! select the n-th placement of a placement set
+//! * returns -1 if the set contains less than n+1 placements
+int pset_select(const PlacementSet *s, int n);
@@ -0,0 +1,183 @@
+// Sink Ships network protocol
+
+#include "protocol.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// helper for writing a 16 bit integer in little endian order
+static void put_u16(unsigned char *buf, int v)
+{
+    buf[0] = v & 0xFF;
+    buf[1] = (v >> 8) & 0xFF;
+}
+
+// helper for reading a 16 bit integer in little endian order
+static int get_u16(const unsigned char *buf)
+{
+    return buf[0] | (buf[1] << 8);
+}
+
+// build a message from up to five fields
+void message_make(Message *m, int type, int a, int b, int c, int d, int e)
+{
+    int fields[5] = {a, b, c, d, e};
+
+    m->type = type;
+    m->count = 0;
+
+    while (m->count < 5 && fields[m->count] >= 0)
+    {
+        m->field[m->count] = fields[m->count];
+        m->count++;
+    }
+}
+
+// encode a message into a buffer of message_max_bytes bytes
+int message_encode(const Message *m, unsigned char *buf)
+{
+    int n = 3;
+
+    buf[2] = m->type;
+
+    for (int i = 0; i < m->count; i++, n += 2)
+        put_u16(buf + n, m->field[i]);
+
+    // the length does not include the length itself
+    put_u16(buf, n - 2);
+
+    return n;
+}
+
+// decode the first message of a buffer
+int message_decode(const unsigned char *buf, int bytes, Message *m, int max_bytes)
+{
+    if (bytes < 2)
+        return 0;
+
+    int length = get_u16(buf);
+
+    // a message consists of its type and complete fields
+    if (length < 1 || length % 2 != 1 || length + 2 > max_bytes)
+        return -1;
+    if (bytes < length + 2)
+        return 0;
+
+    m->type = buf[2];
+    m->count = (length - 1) / 2;
+
+    for (int i = 0; i < m->count; i++)
+        m->field[i] = get_u16(buf + 3 + 2 * i);
+
+    return length + 2;
+}
+
+// connect to a server socket
+int protocol_connect(const char *path)
+{
+    struct sockaddr_un addr;
+
+    if (strlen(path) >= sizeof(addr.sun_path))
+        return -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+// send a message over a blocking socket
+bool protocol_send(int fd, const Message *m)
+{
+    unsigned char buf[message_max_bytes];
+    int bytes = message_encode(m, buf);
+
+    for (int n = 0; n < bytes;)
+    {
+        ssize_t sent = send(fd, buf + n, bytes - n, MSG_NOSIGNAL);
+
+        if (sent < 0 && errno == EINTR)
+            continue;
+        if (sent <= 0)
+            return false;
+
+        n += sent;
+    }
+
+    return true;
+}
+
+// initialize an empty receive buffer
+void inbox_init(Inbox *in)
+{
+    in->bytes = 0;
+}
+
+// read the available bytes of a socket into a receive buffer
+bool inbox_read(Inbox *in, int fd)
+{
+    ssize_t received;
+
+    do
+        received = recv(fd, in->data + in->bytes, sizeof(in->data) - in->bytes, 0);
+    while (received < 0 && errno == EINTR);
+
+    if (received < 0)
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    if (received == 0)
+        return in->bytes == (int)sizeof(in->data); // a full buffer reads nothing
+
+    in->bytes += received;
+
+    return true;
+}
+
+// take the next complete message out of a receive buffer
+int inbox_next(Inbox *in, Message *m, int max_bytes)
+{
+    int n = message_decode(in->data, in->bytes, m, max_bytes);
+
+    if (n <= 0)
+        return n;
+
+    in->bytes -= n;
+    memmove(in->data, in->data + n, in->bytes);
+
+    return 1;
+}
+
+// raise the limit of open file descriptors of the process
+bool protocol_reserve_fds(int fds)
+{
+    struct rlimit limit;
+
+    if (getrlimit(RLIMIT_NOFILE, &limit) < 0)
+        return false;
+
+    if (limit.rlim_cur < (rlim_t)fds)
+    {
+        limit.rlim_cur = limit.rlim_max;
+        if (limit.rlim_max != RLIM_INFINITY && limit.rlim_max > (rlim_t)fds)
+            limit.rlim_cur = fds;
+
+        if (setrlimit(RLIMIT_NOFILE, &limit) < 0)
+            return false;
+    }
+
+    return limit.rlim_cur >= (rlim_t)fds;
+}
@@ -0,0 +1,116 @@
+// Sink Ships network protocol
+// * binary protocol between the game server and its thin clients over Unix domain sockets
+// * each message is framed by its length as 16 bit integer, followed by the message type
+//   and the message fields, all fields are unsigned 16 bit integers in little endian order
+// * a shot takes 7 bytes from the client and 13 bytes from the server
+// * the arenas are reported relative to the receiver, arena 0 is always the own arena
+
+#pragma once
+
+#include "board.h"
+
+//! path of the default server socket
+const char *const protocol_default_socket = "sinkships.sock";
+
+//! maximum number of fields of a message (a welcome message lists the fleet)
+const int message_max_fields = 4 + fleet_max_ships;
+
+//! maximum number of bytes of an encoded message
+const int message_max_bytes = 3 + 2 * message_max_fields;
+
+//! maximum number of bytes of an encoded client message
+const int message_max_client_bytes = 3 + 2 * 4;
+
+//! message types
+enum MessageType
+{
+    // client messages
+    MSG_JOIN = 1,   // join a match: mode (0 against the computer, 1 against another client)
+    MSG_PLACE = 2,  // place the next ship of the fleet: y, x, height, width
+    MSG_RANDOM = 3, // place the whole fleet randomly
+    MSG_SHOOT = 4,  // shoot at the opponent's arena: y, x
+
+    // server messages
+    MSG_WELCOME = 16, // the match was joined: size, fleet count, fleet sizes...
+    MSG_PLACED = 17,  // a ship was placed on the own arena: y, x, height, width
+    MSG_START = 18,   // both fleets are placed: turn (1 if the receiver shoots first)
+    MSG_SHOT = 19,    // a shot was made: arena, y, x, result, turn (1 if the receiver shoots next)
+    MSG_OVER = 20,    // the match is over: won (1 if the receiver won), reason
+    MSG_ERROR = 21    // a client message was rejected: error code
+};
+
+//! match modes
+enum MatchMode
+{
+    MATCH_COMPUTER = 0, // play against the computer opponent of the server
+    MATCH_VERSUS = 1    // play against the next client that joins
+};
+
+//! reasons for the end of a match
+enum OverReason
+{
+    OVER_SUNK = 0, // all ships of a fleet were sunk
+    OVER_LEFT = 1  // the opponent left the match
+};
+
+//! error codes
+enum ErrorCode
+{
+    ERROR_MALFORMED = 1, // the message cannot be decoded
+    ERROR_STATE = 2,     // the message is not allowed in the current state of the match
+    ERROR_ILLEGAL = 3    // the placement or shot is illegal
+};
+
+//! decoded message
+struct Message
+{
+    int type;                      // the message type
+    int count;                     // the number of fields
+    int field[message_max_fields]; // the fields
+};
+
+//! build a message from up to five fields
+//! * unused fields are passed as -1
+void message_make(Message *m, int type, int a = -1, int b = -1, int c = -1, int d = -1, int e = -1);
+
+//! encode a message into a buffer of message_max_bytes bytes
+//! * returns the number of encoded bytes
+int message_encode(const Message *m, unsigned char *buf);
+
+//! decode the first message of a buffer
+//! * returns the number of consumed bytes, 0 if the message is incomplete
+//!   and -1 if the message is malformed or longer than "max_bytes"
+int message_decode(const unsigned char *buf, int bytes, Message *m, int max_bytes = message_max_bytes);
+
+//! connect to a server socket
+//! * returns the socket or -1 if the server cannot be reached
+int protocol_connect(const char *path);
+
+//! send a message over a blocking socket
+//! * returns false if the connection is broken
+bool protocol_send(int fd, const Message *m);
+
+//! receive buffer of a client connection
+struct Inbox
+{
+    unsigned char data[2 * message_max_bytes]; // the received bytes
+    int bytes;                                 // the number of received bytes
+};
+
+//! initialize an empty receive buffer
+void inbox_init(Inbox *in);
+
+//! read the available bytes of a socket into a receive buffer
+//! * reads once, so a blocking socket blocks until bytes arrive
+//! * returns false if the connection was closed or is broken
+bool inbox_read(Inbox *in, int fd);
+
+//! take the next complete message out of a receive buffer
+//! * returns 1 if a message was taken, 0 if no complete message is buffered
+//!   and -1 if the buffered message is malformed or longer than "max_bytes"
+int inbox_next(Inbox *in, Message *m, int max_bytes = message_max_bytes);
+
+//! raise the limit of open file descriptors of the process
+//! * the soft limit is raised up to the hard limit
+//! * returns false if fewer than "fds" descriptors can be opened
+bool protocol_reserve_fds(int fds);
@@ -0,0 +1,289 @@
+// Sink Ships replay log
+
+#include "replay.h"
+#include "game.h"
+
+#include <string.h>
+
+// the magic bytes and the version of the log format
+static const char replay_magic[4] = {'S', 'S', 'R', 'P'};
+static const int replay_version = 1;
+
+// the maximum number of bytes of a varint
+static const int varint_max = 10;
+
+// helper for encoding a varint into a buffer
+// * returns the number of encoded bytes
+static int put_varint(unsigned char *buf, uint64_t v)
+{
+    int n = 0;
+
+    while (v >= 0x80)
+    {
+        buf[n++] = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+
+    buf[n++] = (unsigned char)v;
+
+    return n;
+}
+
+// helper for decoding a varint of a loaded log
+// * returns false at the end of the log or for overlong varints
+static bool get_varint(Replay *r, uint64_t *v)
+{
+    *v = 0;
+
+    for (int shift = 0; shift < 7 * varint_max; shift += 7)
+    {
+        if (r->pos >= r->bytes)
+            return false;
+
+        unsigned char b = r->data[r->pos++];
+        *v |= (uint64_t)(b & 0x7F) << shift;
+
+        if (!(b & 0x80))
+            return true;
+    }
+
+    return false;
+}
+
+// helper for writing an encoded record to a recorded log
+// * the log is flushed after each record, so that it survives a crash
+static void write_record(Replay *r, const unsigned char *buf, int n)
+{
+    if (!r->file)
+        return;
+
+    fwrite(buf, 1, n, r->file);
+    fflush(r->file);
+}
+
+// create a replay log file and write its header
+bool replay_create(Replay *r, const char *path, uint64_t seed, int size, const Fleet *fleet)
+{
+    r->seed = seed;
+    r->size = size;
+    r->fleet = *fleet;
+    r->data = NULL;
+    r->bytes = r->start = r->pos = 0;
+
+    r->file = fopen(path, "wb");
+    if (!r->file)
+        return false;
+
+    // write the header
+    unsigned char buf[varint_max];
+
+    fwrite(replay_magic, 1, sizeof(replay_magic), r->file);
+    fwrite(buf, 1, put_varint(buf, replay_version), r->file);
+    fwrite(buf, 1, put_varint(buf, seed), r->file);
+    fwrite(buf, 1, put_varint(buf, size), r->file);
+    fwrite(buf, 1, put_varint(buf, fleet->count), r->file);
+
+    for (int i = 0; i < fleet->count; i++)
+        fwrite(buf, 1, put_varint(buf, fleet->size[i]), r->file);
+
+    fflush(r->file);
+
+    return true;
+}
+
+// record the placement of a ship with extent (height, width) at position (y, x) on a specific arena
+// * the record is the tagged cell index followed by the ship length and orientation
+void replay_place(Replay *r, int player, int y, int x, int height, int width)
+{
+    unsigned char buf[2 * varint_max];
+
+    uint64_t cell = (uint64_t)y * r->size + x;
+    int length = height > width ? height : width;
+    int horizontal = height == 1 && width > 1;
+
+    int n = put_varint(buf, (cell * 2 + player) * 2 + REPLAY_PLACE);
+    n += put_varint(buf + n, length * 2 + horizontal);
+
+    write_record(r, buf, n);
+}
+
+// record a shot at position (y, x) on a specific arena
+// * the record is the tagged cell index
+void replay_shot(Replay *r, int player, int y, int x)
+{
+    unsigned char buf[varint_max];
+
+    uint64_t cell = (uint64_t)y * r->size + x;
+
+    write_record(r, buf, put_varint(buf, (cell * 2 + player) * 2 + REPLAY_SHOT));
+}
+
+// load a replay log file
+bool replay_load(Replay *r, const char *path)
+{
+    r->file = NULL;
+    r->data = NULL;
+    r->bytes = r->start = r->pos = 0;
+
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return false;
+
+    // read the whole log at once
+    fseek(file, 0, SEEK_END);
+    long bytes = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    if (bytes < (long)sizeof(replay_magic))
+    {
+        fclose(file);
+        return false;
+    }
+
+    r->data = new unsigned char[bytes];
+    r->bytes = fread(r->data, 1, bytes, file);
+    fclose(file);
+
+    // check the header
+    uint64_t version, seed, size, count;
+    bool valid = r->bytes == (size_t)bytes &&
+                 memcmp(r->data, replay_magic, sizeof(replay_magic)) == 0;
+
+    r->pos = sizeof(replay_magic);
+
+    valid = valid && get_varint(r, &version) && version == (uint64_t)replay_version;
+    valid = valid && get_varint(r, &seed) && get_varint(r, &size) && get_varint(r, &count);
+    valid = valid && size >= 1 && size <= (uint64_t)board_max_size;
+    valid = valid && count >= 1 && count <= (uint64_t)fleet_max_ships;
+
+    if (valid)
+    {
+        r->seed = seed;
+        r->size = size;
+        r->fleet.count = count;
+
+        for (int i = 0; i < r->fleet.count && valid; i++)
+        {
+            uint64_t length;
+            valid = get_varint(r, &length) && length >= 1 && length <= size;
+            r->fleet.size[i] = length;
+        }
+    }
+
+    if (!valid)
+    {
+        replay_close(r);
+        return false;
+    }
+
+    r->start = r->pos;
+
+    return true;
+}
+
+// restart reading the moves of a loaded log
+void replay_rewind(Replay *r)
+{
+    r->pos = r->start;
+}
+
+// read the next move of a loaded log
+// * a corrupt record is not consumed, so the read position stays before the end of the log
+bool replay_next(Replay *r, ReplayMove *m)
+{
+    size_t pos = r->pos;
+
+    uint64_t tag;
+    if (!get_varint(r, &tag))
+    {
+        r->pos = pos;
+        return false;
+    }
+
+    uint64_t cell = tag >> 2;
+    if (cell >= (uint64_t)r->size * r->size)
+    {
+        r->pos = pos;
+        return false;
+    }
+
+    m->type = tag & 1;
+    m->player = (tag >> 1) & 1;
+    m->y = cell / r->size;
+    m->x = cell % r->size;
+    m->height = 1;
+    m->width = 1;
+
+    if (m->type == REPLAY_PLACE)
+    {
+        uint64_t shape;
+        if (!get_varint(r, &shape) || (shape >> 1) < 1 || (shape >> 1) > (uint64_t)r->size)
+        {
+            r->pos = pos;
+            return false;
+        }
+
+        if (shape & 1)
+            m->width = shape >> 1;
+        else
+            m->height = shape >> 1;
+    }
+
+    return true;
+}
+
+// initialize a game with the seed, arena size and fleet of a loaded log
+void replay_init_game(const Replay *r, Game *g)
+{
+    game_init(g, &r->fleet, r->seed, 0, r->size);
+}
+
+// apply a move to a game
+bool replay_apply(Game *g, const ReplayMove *m, int *result)
+{
+    if (m->type == REPLAY_PLACE)
+        return game_place_ship(g, m->player, m->y, m->x, m->height, m->width);
+
+    int shot = game_shoot(g, m->player, m->y, m->x);
+
+    if (result)
+        *result = shot;
+
+    return shot != SHOT_NONE;
+}
+
+// simulate all moves of a loaded log on a game initialized by replay_init_game
+long replay_simulate(Replay *r, Game *g)
+{
+    long moves = 0;
+    ReplayMove m;
+
+    replay_rewind(r);
+
+    while (replay_next(r, &m))
+    {
+        if (!replay_apply(g, &m))
+            return -1;
+
+        moves++;
+    }
+
+    // a corrupt log stops before its end
+    if (r->pos != r->bytes)
+        return -1;
+
+    return moves;
+}
+
+// close a replay log
+void replay_close(Replay *r)
+{
+    if (r->file)
+        fclose(r->file);
+
+    delete[] r->data;
+
+    r->file = NULL;
+    r->data = NULL;
+    r->bytes = r->start = r->pos = 0;
+}
@@ -0,0 +1,88 @@
+// Sink Ships replay log
+// * records all ship placements and shots of a game in a compact binary log
+// * the log starts with a header of the seed, the arena size and the fleet,
+//   followed by one record per move, all numbers are unsigned LEB128 varints
+// * a shot takes one or two bytes on the default arena, a placement two or three
+// * a recorded game is replayed by applying the moves to a new game,
+//   either step by step for rendering or all at once for headless simulation
+
+#pragma once
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "board.h"
+
+struct Game;
+
+//! file a game is recorded to by default
+const char *const replay_default_file = "sinkships.replay";
+
+//! replay move types
+enum ReplayMoveType
+{
+    REPLAY_PLACE = 0, // a ship was placed
+    REPLAY_SHOT = 1   // a shot was made
+};
+
+//! replayed move
+struct ReplayMove
+{
+    int type;          // the move type
+    int player;        // the owner of the arena
+    int y, x;          // the position of the shot resp. the top-left position of the ship
+    int height, width; // the extent of the ship
+};
+
+//! replay log
+//! * a log is either recorded to a file or loaded from a file
+struct Replay
+{
+    uint64_t seed;       // the seed of the recorded game
+    int size;            // the arena size of the recorded game
+    Fleet fleet;         // the fleet of the recorded game
+    FILE *file;          // the file the log is recorded to, NULL for loaded logs
+    unsigned char *data; // the loaded log
+    size_t bytes;        // the number of bytes of the loaded log
+    size_t start;        // the position of the first move of the loaded log
+    size_t pos;          // the read position of the loaded log
+};
+
+//! create a replay log file and write its header
+//! * returns false if the file cannot be written
+bool replay_create(Replay *r, const char *path, uint64_t seed, int size, const Fleet *fleet);
+
+//! record the placement of a ship with extent (height, width) at position (y, x) on a specific arena
+void replay_place(Replay *r, int player, int y, int x, int height, int width);
+
+//! record a shot at position (y, x) on a specific arena
+void replay_shot(Replay *r, int player, int y, int x);
+
+//! load a replay log file
+//! * returns false if the file cannot be read or has no valid header
+bool replay_load(Replay *r, const char *path);
+
+//! restart reading the moves of a loaded log
+void replay_rewind(Replay *r);
+
+//! read the next move of a loaded log
+//! * returns false at the end of the log or if the log is corrupt
+bool replay_next(Replay *r, ReplayMove *m);
+
+//! initialize a game with the seed, arena size and fleet of a loaded log
+//! * the game needs to be released by game_free
+void replay_init_game(const Replay *r, Game *g);
+
+//! apply a move to a game
+//! * "result" receives the shot result of a shot
+//! * returns false if the move is illegal
+bool replay_apply(Game *g, const ReplayMove *m, int *result = NULL);
+
+//! simulate all moves of a loaded log on a game initialized by replay_init_game
+//! * returns the number of moves or -1 if an illegal move was found
+long replay_simulate(Replay *r, Game *g);
+
+//! close a replay log
+//! * flushes a recorded log and releases a loaded log
+void replay_close(Replay *r);
@@ -0,0 +1,238 @@
+// Sink Ships Monte Carlo sampler
+
+#include "sampler.h"
+
+#include <time.h>
+
+// the number of fleets sampled per task
+static const int sample_batch = 64;
+
+// the maximum number of candidate placements through a damaged cell
+static const int max_candidates = 4 * bitboard_size * bitboard_size;
+
+// helper for getting the wall-clock time in seconds
+static double get_seconds()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1E-9;
+}
+
+// sampling state of a single fleet
+struct SampleState
+{
+    PlacementSet available[bitboard_size]; // the placements that do not conflict with sampled ships
+    int left[bitboard_size];               // the number of ships left to place per placement list
+    Bits128 blocked;                       // the sampled ships plus their surrounding cells
+    Bits128 ships;                         // the sampled ship cells
+};
+
+// helper for placing a sampled ship
+static void place(const FleetGen *g, SampleState *s, int k, const Placement *m)
+{
+    s->left[k]--;
+    s->ships = bits_or(s->ships, m->ship);
+
+    // mask out all placements that cover a newly blocked cell
+    Bits128 cells = bits_andnot(m->halo, s->blocked);
+    s->blocked = bits_or(s->blocked, m->halo);
+
+    while (!bits_empty(cells))
+    {
+        int c = bits_pop(&cells);
+
+        for (int j = 0; j < g->lists; j++)
+            pset_remove(&s->available[j], &g->placements[j].cover[c]);
+    }
+}
+
+// sample a single fleet that is consistent with the observations of an opponent
+bool sample_fleet(const Ai *a, Random *random, int *hits)
+{
+    const FleetGen *g = a->gen;
+
+    SampleState s;
+    for (int k = 0; k < g->lists; k++)
+    {
+        s.available[k] = a->valid[k];
+        s.left[k] = a->remaining[k];
+    }
+    s.blocked = bits128();
+    s.ships = bits128();
+
+    // place ships through the damaged cells first
+    Bits128 uncovered = a->hit_bits;
+    while (!bits_empty(uncovered))
+    {
+        int c = bits_first(uncovered);
+
+        int candidates = 0;
+        int total = 0;
+        int list[max_candidates];
+        const Placement *mask[max_candidates];
+
+        for (int k = 0; k < g->lists; k++)
+        {
+            if (s.left[k] == 0)
+                continue;
+
+            const PlacementList *l = &g->placements[k];
+
+            for (int w = 0; w < placement_words; w++)
+                for (uint64_t bits = s.available[k].w[w] & l->cover[c].w[w]; bits; bits &= bits - 1)
+                {
+                    const Placement *m = l->ref[(w << 6) + __builtin_ctzll(bits)].mask;
+
+                    // a ship cannot touch damaged cells of another ship
+                    if (!bits_empty(bits_andnot(bits_and(m->halo, uncovered), m->ship)))
+                        continue;
+
+                    // each of the remaining ships of the list may be the one
+                    list[candidates] = k;
+                    mask[candidates] = m;
+                    candidates++;
+                    total += s.left[k];
+                }
+        }
+
+        if (total == 0)
+            return false;
+
+        int r = rnd_int(random, total);
+        int i = 0;
+        while (r >= s.left[list[i]])
+            r -= s.left[list[i++]];
+
+        place(g, &s, list[i], mask[i]);
+        uncovered = bits_andnot(uncovered, mask[i]->ship);
+    }
+
+    // place the other ships, largest first
+    for (int k = 0; k < g->lists; k++)
+        while (s.left[k] > 0)
+        {
+            const PlacementList *l = &g->placements[k];
+
+            int count = pset_count(&s.available[k]);
+            if (count == 0)
+                return false;
+
+            place(g, &s, k, l->ref[pset_select(&s.available[k], rnd_int(random, count))].mask);
+        }
+
+    // count the unshot ship cells
+    Bits128 cells = bits_andnot(s.ships, a->shot_bits);
+    while (!bits_empty(cells))
+        hits[bits_pop(&cells)]++;
+
+    return true;
+}
+
+// sampling state of a worker
+struct SampleWorker
+{
+    Random random;                           // the random number generator of the worker
+    int samples;                             // the number of accepted samples
+    int hits[bitboard_size * bitboard_size]; // the sampled ship cells
+    char padding[64];                        // avoid false sharing between workers
+};
+
+// sampling job of a move
+struct SampleJob
+{
+    const Ai *a;          // the observing opponent
+    double deadline;      // the wall-clock deadline
+    SampleWorker *worker; // the sampling state per worker
+};
+
+// helper for sampling a batch of fleets
+static void sample_batch_of_fleets(const Ai *a, SampleWorker *w)
+{
+    for (int i = 0; i < sample_batch; i++)
+        if (sample_fleet(a, &w->random, w->hits))
+            w->samples++;
+}
+
+// sampling task, respawns itself until the deadline is reached
+static void sample_task(ThreadPool *pool, int worker, void *data)
+{
+    SampleJob *job = (SampleJob *)data;
+
+    sample_batch_of_fleets(job->a, &job->worker[worker]);
+
+    if (get_seconds() < job->deadline)
+        pool_spawn(pool, worker, sample_task, data);
+}
+
+// sample fleets within a wall-clock budget and choose the next shot
+bool sample_choose(Ai *a, ThreadPool *pool, float budget, int *y, int *x)
+{
+    // large boards are not indexed
+    if (!a->gen->placements)
+        return false;
+
+    int workers = pool ? pool_threads(pool) : 1;
+
+    SampleJob job;
+    job.a = a;
+    job.deadline = get_seconds() + budget / 1000;
+    job.worker = new SampleWorker[workers];
+
+    for (int i = 0; i < workers; i++)
+    {
+        SampleWorker *w = &job.worker[i];
+        rnd_seed(&w->random, rnd_next(&a->random), i); // one stream per worker
+        w->samples = 0;
+        for (int c = 0; c < bitboard_size * bitboard_size; c++)
+            w->hits[c] = 0;
+    }
+
+    if (pool)
+    {
+        for (int i = 0; i < workers; i++)
+            pool_submit(pool, sample_task, &job);
+
+        pool_wait(pool);
+    }
+    else
+    {
+        do
+            sample_batch_of_fleets(a, &job.worker[0]);
+        while (get_seconds() < job.deadline);
+    }
+
+    // aggregate the sampled ship cells of all workers
+    int samples = 0;
+    int hits[bitboard_size * bitboard_size] = {0};
+    for (int i = 0; i < workers; i++)
+    {
+        samples += job.worker[i].samples;
+        for (int c = 0; c < bitboard_size * bitboard_size; c++)
+            hits[c] += job.worker[i].hits[c];
+    }
+
+    delete[] job.worker;
+
+    if (samples == 0)
+        return false;
+
+    // choose the most frequently covered unshot cell
+    int size = a->gen->size;
+    int best = -1;
+    for (int i = 0; i < size; i++)
+        for (int j = 0; j < size; j++)
+        {
+            int c = bits_index(i, j);
+            if (bits_test(a->shot_bits, c))
+                continue;
+
+            if (hits[c] > best)
+            {
+                best = hits[c];
+                *y = i;
+                *x = j;
+            }
+        }
+
+    return best >= 0;
+}
@@ -0,0 +1,21 @@
+// Sink Ships Monte Carlo sampler
+// * samples random fleets that are consistent with the observed shots of an opponent
+// * the ship cells of the sampled fleets are counted per cell,
+//   the most frequently covered unshot cell is the next shot
+// * sampling runs in parallel on a work-stealing thread pool within a wall-clock budget
+
+#pragma once
+
+#include "ai.h"
+#include "threadpool.h"
+
+//! sample a single fleet that is consistent with the observations of an opponent
+//! * the ship cells of an accepted fleet are added to the "hits" array (by bit index)
+//! * returns false if the sample was rejected
+bool sample_fleet(const Ai *a, Random *random, int *hits);
+
+//! sample fleets within a wall-clock budget and choose the next shot
+//! * "pool" is the thread pool to sample on, sampling runs on the calling thread for NULL
+//! * "budget" is the wall-clock budget in milli seconds
+//! * returns false if no consistent fleet was found or the board is too large to be indexed
+bool sample_choose(Ai *a, ThreadPool *pool, float budget, int *y, int *x);
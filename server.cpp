@@ -0,0 +1,740 @@
+// Sink Ships game server
+
+#include "server.h"
+#include "protocol.h"
+#include "game.h"
+#include "ai.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// maximum number of events per wakeup of an event loop
+static const int max_events = 64;
+
+// match phases
+enum MatchPhase
+{
+    PHASE_PLACING = 0, // the fleets are placed
+    PHASE_PLAYING = 1, // the players take turns
+    PHASE_OVER = 2     // the match is over
+};
+
+// client connection
+struct Connection
+{
+    int fd;                // the client socket
+    ServerWorker *worker;  // the worker that accepted the client
+    Connection *prev;      // the previous client of the worker
+    Connection *next;      // the next client of the worker
+    Inbox in;              // the receive buffer
+    pthread_mutex_t lock;  // the lock of the send buffer
+    unsigned char *out;    // the bytes that could not be sent yet
+    int out_bytes;         // the number of pending bytes
+    int out_capacity;      // the size of the send buffer
+    bool writing;          // the event loop waits for the socket to become writable
+    Match *match;          // the joined match, NULL if none
+    int seat;              // the arena of the client within the match
+};
+
+// match of two players
+// * seat 1 is taken by the computer opponent in computer matches
+struct Match
+{
+    pthread_mutex_t lock; // the lock of the match state
+    Game game;            // the game state
+    Ai *ai;               // the computer opponent, NULL for matches between two clients
+    Connection *seat[2];  // the clients of both arenas, NULL if a seat is empty
+    int placed[2];        // the number of placed ships per arena
+    int phase;            // the match phase
+    int turn;             // the arena of the player that shoots next
+};
+
+// helper for changing the events a client socket is watched for
+static void watch(Connection *c, bool writable)
+{
+    struct epoll_event ev;
+
+    ev.events = EPOLLIN | EPOLLRDHUP | (writable ? EPOLLOUT : 0);
+    ev.data.ptr = c;
+
+    epoll_ctl(c->worker->epoll, EPOLL_CTL_MOD, c->fd, &ev);
+}
+
+// helper for sending the pending bytes of a client
+// * the send buffer must be locked
+static void flush(Connection *c)
+{
+    int n = 0;
+
+    while (n < c->out_bytes)
+    {
+        ssize_t sent = send(c->fd, c->out + n, c->out_bytes - n, MSG_NOSIGNAL);
+
+        if (sent < 0 && errno == EINTR)
+            continue;
+        if (sent <= 0)
+            break;
+
+        n += sent;
+    }
+
+    // a broken connection is closed by the event loop of its worker
+    if (n < c->out_bytes && errno != EAGAIN && errno != EWOULDBLOCK)
+        n = c->out_bytes;
+
+    c->out_bytes -= n;
+    memmove(c->out, c->out + n, c->out_bytes);
+
+    if ((c->out_bytes > 0) != c->writing)
+    {
+        c->writing = c->out_bytes > 0;
+        watch(c, c->writing);
+    }
+}
+
+// helper for sending a message to a client
+// * may be called from any worker, the client must not be closed concurrently
+static void post(Connection *c, const Message *m)
+{
+    unsigned char buf[message_max_bytes];
+    int bytes = message_encode(m, buf);
+
+    pthread_mutex_lock(&c->lock);
+
+    if (c->out_bytes + bytes > c->out_capacity)
+    {
+        int capacity = 2 * (c->out_bytes + bytes);
+        unsigned char *out = new unsigned char[capacity];
+        memcpy(out, c->out, c->out_bytes);
+
+        delete[] c->out;
+        c->out = out;
+        c->out_capacity = capacity;
+    }
+
+    memcpy(c->out + c->out_bytes, buf, bytes);
+    c->out_bytes += bytes;
+
+    // messages are queued behind bytes that are still pending
+    if (!c->writing)
+        flush(c);
+
+    pthread_mutex_unlock(&c->lock);
+}
+
+// helper for sending a message with up to five fields to a client
+static void reply(Connection *c, int type, int a = -1, int b = -1, int c1 = -1, int d = -1, int e = -1)
+{
+    Message m;
+    message_make(&m, type, a, b, c1, d, e);
+    post(c, &m);
+}
+
+// helper for sending an error to a client
+static void reject(Connection *c, int code)
+{
+    reply(c, MSG_ERROR, code);
+}
+
+// helper for creating a match
+static Match *create_match(Server *s, bool computer)
+{
+    Match *m = new Match;
+    uint64_t stream = __sync_fetch_and_add(&s->streams, 1);
+
+    pthread_mutex_init(&m->lock, NULL);
+
+    // the game and the computer use separate streams of the match
+    game_init(&m->game, &s->fleet, s->seed, 2 * stream, s->size);
+    game_set_generator(&m->game, &s->generator);
+
+    m->ai = NULL;
+    m->seat[0] = m->seat[1] = NULL;
+    m->placed[0] = m->placed[1] = 0;
+    m->phase = PHASE_PLACING;
+    m->turn = 0;
+
+    if (computer)
+    {
+        m->ai = new Ai;
+        ai_init(m->ai, &s->generator, AI_DENSITY, s->seed, 2 * stream + 1);
+
+        game_random_ships(&m->game, 1);
+        m->placed[1] = s->fleet.count;
+    }
+
+    __sync_add_and_fetch(&s->stats.matches, 1);
+
+    return m;
+}
+
+// helper for releasing a match
+static void free_match(Server *s, Match *m)
+{
+    if (m->ai)
+    {
+        ai_free(m->ai);
+        delete m->ai;
+    }
+
+    game_free(&m->game);
+    pthread_mutex_destroy(&m->lock);
+    delete m;
+
+    __sync_sub_and_fetch(&s->stats.matches, 1);
+}
+
+// helper for sending the welcome message with the arena size and the fleet
+static void welcome(Server *s, Connection *c)
+{
+    Message m;
+
+    m.type = MSG_WELCOME;
+    m.count = 2 + s->fleet.count;
+    m.field[0] = s->size;
+    m.field[1] = s->fleet.count;
+
+    for (int i = 0; i < s->fleet.count; i++)
+        m.field[2 + i] = s->fleet.size[i];
+
+    post(c, &m);
+}
+
+// helper for starting a match once both fleets are placed
+// * the match must be locked
+static void start_match(Server *s, Match *m)
+{
+    if (m->placed[0] < s->fleet.count || m->placed[1] < s->fleet.count)
+        return;
+
+    m->phase = PHASE_PLAYING;
+
+    for (int p = 0; p < 2; p++)
+        if (m->seat[p])
+            reply(m->seat[p], MSG_START, m->turn == p);
+}
+
+// helper for ending a match
+// * the match must be locked
+static void end_match(Match *m, int winner, int reason)
+{
+    m->phase = PHASE_OVER;
+
+    for (int p = 0; p < 2; p++)
+        if (m->seat[p])
+            reply(m->seat[p], MSG_OVER, winner == p, reason);
+}
+
+// helper for reporting a shot to both players
+// * the match must be locked
+static void report_shot(Match *m, int shooter, int y, int x, int result)
+{
+    for (int p = 0; p < 2; p++)
+        if (m->seat[p])
+            reply(m->seat[p], MSG_SHOT, p == shooter ? 1 : 0, y, x, result, m->turn == p);
+}
+
+// helper for making a shot at the arena of the opponent of "shooter"
+// * the match must be locked
+// * returns the shot result
+static int make_shot(Server *s, Match *m, int shooter, int y, int x)
+{
+    int result = game_shoot(&m->game, 1 - shooter, y, x);
+
+    if (result == SHOT_NONE)
+        return result;
+
+    __sync_add_and_fetch(&s->stats.moves, 1);
+
+    if (result == SHOT_MISS)
+        m->turn = 1 - shooter;
+
+    report_shot(m, shooter, y, x, result);
+
+    if (game_over(&m->game))
+        end_match(m, game_winner(&m->game), OVER_SUNK);
+
+    return result;
+}
+
+// helper for playing the shots of the computer until it misses
+// * the match must be locked
+static void computer_turn(Server *s, Match *m)
+{
+    while (m->phase == PHASE_PLAYING && m->turn == 1)
+    {
+        int y, x;
+
+        if (!ai_choose(m->ai, &y, &x))
+            break;
+
+        int result = make_shot(s, m, 1, y, x);
+        ai_update(m->ai, y, x, result);
+    }
+}
+
+// helper for leaving the match of a client
+// * the opponent of a running match wins
+static void leave_match(Server *s, Connection *c)
+{
+    Match *m = c->match;
+
+    if (!m)
+        return;
+
+    // the lobby is locked first, so that no client can join the match while it is left
+    pthread_mutex_lock(&s->lobby);
+
+    if (s->waiting == m)
+        s->waiting = NULL;
+
+    pthread_mutex_lock(&m->lock);
+
+    m->seat[c->seat] = NULL;
+
+    if (m->phase != PHASE_OVER)
+        end_match(m, 1 - c->seat, OVER_LEFT);
+
+    bool empty = !m->seat[0] && !m->seat[1];
+
+    pthread_mutex_unlock(&m->lock);
+    pthread_mutex_unlock(&s->lobby);
+
+    if (empty)
+        free_match(s, m);
+
+    c->match = NULL;
+}
+
+// helper for joining a match
+static void join_match(Server *s, Connection *c, int mode)
+{
+    if (mode != MATCH_COMPUTER && mode != MATCH_VERSUS)
+    {
+        reject(c, ERROR_MALFORMED);
+        return;
+    }
+
+    // a finished match is left for the next one
+    if (c->match)
+    {
+        pthread_mutex_lock(&c->match->lock);
+        bool over = c->match->phase == PHASE_OVER;
+        pthread_mutex_unlock(&c->match->lock);
+
+        if (!over)
+        {
+            reject(c, ERROR_STATE);
+            return;
+        }
+
+        leave_match(s, c);
+    }
+
+    if (mode == MATCH_COMPUTER)
+    {
+        Match *m = create_match(s, true);
+
+        pthread_mutex_lock(&m->lock);
+        c->match = m;
+        c->seat = 0;
+        m->seat[0] = c;
+        welcome(s, c);
+        pthread_mutex_unlock(&m->lock);
+
+        return;
+    }
+
+    pthread_mutex_lock(&s->lobby);
+
+    Match *m = s->waiting;
+
+    if (m)
+        s->waiting = NULL;
+    else
+        m = s->waiting = create_match(s, false);
+
+    pthread_mutex_lock(&m->lock);
+
+    // the first client of a match shoots first
+    c->match = m;
+    c->seat = m->seat[0] ? 1 : 0;
+    m->seat[c->seat] = c;
+    welcome(s, c);
+
+    pthread_mutex_unlock(&m->lock);
+    pthread_mutex_unlock(&s->lobby);
+}
+
+// helper for handling a move of a client within its match
+// * the match must be locked
+static void handle_move(Server *s, Connection *c, const Message *msg)
+{
+    Match *m = c->match;
+    int seat = c->seat;
+    const int *f = msg->field;
+
+    switch (msg->type)
+    {
+    case MSG_PLACE:
+    {
+        if (msg->count != 4)
+        {
+            reject(c, ERROR_MALFORMED);
+            break;
+        }
+
+        if (m->phase != PHASE_PLACING || m->placed[seat] >= s->fleet.count)
+        {
+            reject(c, ERROR_STATE);
+            break;
+        }
+
+        // the ships are placed in the order of the fleet
+        int length = s->fleet.size[m->placed[seat]];
+        bool shaped = (f[2] == length && f[3] == 1) || (f[2] == 1 && f[3] == length);
+
+        if (!shaped || !game_place_ship(&m->game, seat, f[0], f[1], f[2], f[3]))
+        {
+            reject(c, ERROR_ILLEGAL);
+            break;
+        }
+
+        m->placed[seat]++;
+        reply(c, MSG_PLACED, f[0], f[1], f[2], f[3]);
+        start_match(s, m);
+        break;
+    }
+    case MSG_RANDOM:
+    {
+        if (m->phase != PHASE_PLACING || m->placed[seat] != 0)
+        {
+            reject(c, ERROR_STATE);
+            break;
+        }
+
+        if (!game_random_ships(&m->game, seat))
+        {
+            board_clear(&m->game.board[seat]);
+            reject(c, ERROR_ILLEGAL);
+            break;
+        }
+
+        const Board *b = &m->game.board[seat];
+        for (int k = 0; k < b->ships; k++)
+            reply(c, MSG_PLACED, b->ship[k].y, b->ship[k].x, b->ship[k].height, b->ship[k].width);
+
+        m->placed[seat] = s->fleet.count;
+        start_match(s, m);
+        break;
+    }
+    case MSG_SHOOT:
+    {
+        if (msg->count != 2)
+        {
+            reject(c, ERROR_MALFORMED);
+            break;
+        }
+
+        if (m->phase != PHASE_PLAYING || m->turn != seat)
+        {
+            reject(c, ERROR_STATE);
+            break;
+        }
+
+        if (make_shot(s, m, seat, f[0], f[1]) == SHOT_NONE)
+        {
+            reject(c, ERROR_ILLEGAL);
+            break;
+        }
+
+        // the computer answers a miss right away
+        if (m->ai)
+            computer_turn(s, m);
+
+        break;
+    }
+    default:
+        reject(c, ERROR_MALFORMED);
+        break;
+    }
+}
+
+// helper for handling a message of a client
+static void handle_message(Server *s, Connection *c, const Message *msg)
+{
+    if (msg->type == MSG_JOIN)
+    {
+        if (msg->count != 1)
+            reject(c, ERROR_MALFORMED);
+        else
+            join_match(s, c, msg->field[0]);
+
+        return;
+    }
+
+    if (!c->match)
+    {
+        reject(c, msg->type == MSG_PLACE || msg->type == MSG_RANDOM || msg->type == MSG_SHOOT ? ERROR_STATE : ERROR_MALFORMED);
+        return;
+    }
+
+    pthread_mutex_lock(&c->match->lock);
+    handle_move(s, c, msg);
+    pthread_mutex_unlock(&c->match->lock);
+}
+
+// helper for accepting the pending clients of the listening socket
+static void accept_clients(ServerWorker *w)
+{
+    Server *s = w->server;
+
+    for (int i = 0; i < max_events; i++)
+    {
+        int fd = accept4(s->listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+        if (fd < 0)
+            break;
+
+        Connection *c = new Connection;
+
+        c->fd = fd;
+        c->worker = w;
+        c->prev = NULL;
+        c->next = w->first;
+        inbox_init(&c->in);
+        pthread_mutex_init(&c->lock, NULL);
+        c->out = NULL;
+        c->out_bytes = 0;
+        c->out_capacity = 0;
+        c->writing = false;
+        c->match = NULL;
+        c->seat = 0;
+
+        if (w->first)
+            w->first->prev = c;
+        w->first = c;
+
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.ptr = c;
+
+        epoll_ctl(w->epoll, EPOLL_CTL_ADD, fd, &ev);
+
+        __sync_add_and_fetch(&s->stats.clients, 1);
+    }
+}
+
+// helper for closing a client
+static void close_client(ServerWorker *w, Connection *c)
+{
+    Server *s = w->server;
+
+    leave_match(s, c);
+
+    epoll_ctl(w->epoll, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+
+    if (c->prev)
+        c->prev->next = c->next;
+    else
+        w->first = c->next;
+    if (c->next)
+        c->next->prev = c->prev;
+
+    pthread_mutex_destroy(&c->lock);
+    delete[] c->out;
+    delete c;
+
+    __sync_sub_and_fetch(&s->stats.clients, 1);
+}
+
+// helper for handling the received bytes of a client
+// * returns false if the client needs to be closed
+static bool receive(ServerWorker *w, Connection *c)
+{
+    if (!inbox_read(&c->in, c->fd))
+        return false;
+
+    Message m;
+    int taken;
+
+    while ((taken = inbox_next(&c->in, &m, message_max_client_bytes)) > 0)
+        handle_message(w->server, c, &m);
+
+    // a malformed message cannot be skipped
+    if (taken < 0)
+    {
+        reject(c, ERROR_MALFORMED);
+        return false;
+    }
+
+    return true;
+}
+
+// event loop of a worker
+static void *run_worker(void *data)
+{
+    ServerWorker *w = (ServerWorker *)data;
+    Server *s = w->server;
+    struct epoll_event events[max_events];
+
+    for (;;)
+    {
+        int n = epoll_wait(w->epoll, events, max_events, -1);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            break;
+
+        for (int i = 0; i < n; i++)
+        {
+            void *ptr = events[i].data.ptr;
+
+            // the wakeup event is never reset, so that it stops all workers
+            if (ptr == &s->wakeup)
+                return NULL;
+
+            if (ptr == &s->listener)
+            {
+                accept_clients(w);
+                continue;
+            }
+
+            Connection *c = (Connection *)ptr;
+            bool open = !(events[i].events & EPOLLERR);
+
+            if (open && (events[i].events & EPOLLOUT))
+            {
+                pthread_mutex_lock(&c->lock);
+                flush(c);
+                pthread_mutex_unlock(&c->lock);
+            }
+
+            // the buffered messages of a client that hung up are handled first
+            if (open && (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)))
+                open = receive(w, c) && !(events[i].events & EPOLLHUP);
+
+            if (!open)
+                close_client(w, c);
+        }
+    }
+
+    return NULL;
+}
+
+// start a server listening on a Unix domain socket
+bool server_start(Server *s, const char *path, int workers, int size, const Fleet *fleet, uint64_t seed)
+{
+    struct sockaddr_un addr;
+
+    if (strlen(path) >= sizeof(addr.sun_path) || strlen(path) >= sizeof(s->path))
+        return false;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    strcpy(s->path, path);
+
+    s->listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (s->listener < 0)
+        return false;
+
+    unlink(path);
+
+    if (bind(s->listener, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(s->listener, SOMAXCONN) < 0)
+    {
+        close(s->listener);
+        return false;
+    }
+
+    s->wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (workers < 1)
+        workers = 1;
+
+    s->workers = workers;
+    s->worker = new ServerWorker[workers];
+    s->size = size;
+    s->fleet = *fleet;
+    fleetgen_init(&s->generator, fleet, size);
+    s->seed = seed;
+    s->streams = 0;
+    pthread_mutex_init(&s->lobby, NULL);
+    s->waiting = NULL;
+    s->stats.clients = 0;
+    s->stats.matches = 0;
+    s->stats.moves = 0;
+
+    for (int i = 0; i < workers; i++)
+    {
+        ServerWorker *w = &s->worker[i];
+
+        w->server = s;
+        w->epoll = epoll_create1(EPOLL_CLOEXEC);
+        w->first = NULL;
+
+        // only one of the waiting workers is woken up per new client
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+#ifdef EPOLLEXCLUSIVE
+        ev.events |= EPOLLEXCLUSIVE;
+#endif
+        ev.data.ptr = &s->listener;
+        epoll_ctl(w->epoll, EPOLL_CTL_ADD, s->listener, &ev);
+
+        ev.events = EPOLLIN;
+        ev.data.ptr = &s->wakeup;
+        epoll_ctl(w->epoll, EPOLL_CTL_ADD, s->wakeup, &ev);
+
+        pthread_create(&w->thread, NULL, run_worker, w);
+    }
+
+    return true;
+}
+
+// get a snapshot of the server statistics
+void server_stats(Server *s, ServerStats *stats)
+{
+    stats->clients = __sync_add_and_fetch(&s->stats.clients, 0);
+    stats->matches = __sync_add_and_fetch(&s->stats.matches, 0);
+    stats->moves = __sync_add_and_fetch(&s->stats.moves, 0);
+}
+
+// stop a server
+void server_stop(Server *s)
+{
+    uint64_t one = 1;
+    ssize_t written = write(s->wakeup, &one, sizeof(one));
+    (void)written;
+
+    for (int i = 0; i < s->workers; i++)
+        pthread_join(s->worker[i].thread, NULL);
+
+    // the clients are closed after all workers have stopped
+    for (int i = 0; i < s->workers; i++)
+    {
+        ServerWorker *w = &s->worker[i];
+
+        while (w->first)
+            close_client(w, w->first);
+
+        close(w->epoll);
+    }
+
+    close(s->wakeup);
+    close(s->listener);
+    unlink(s->path);
+
+    pthread_mutex_destroy(&s->lobby);
+    fleetgen_free(&s->generator);
+    delete[] s->worker;
+}
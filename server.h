@@ -0,0 +1,71 @@
+// Sink Ships game server
+// * hosts many independent matches in one process, each match owns its own game state
+// * thin clients connect over a Unix domain socket and speak the protocol of protocol.h
+// * a small pool of worker threads runs one epoll event loop each,
+//   the listening socket is shared by all event loops and each accepted client stays
+//   with the worker that accepted it, so a client is only ever read by one thread
+// * the two clients of a match may live on different workers,
+//   the match state is guarded by a lock per match and the send buffer by a lock per client
+// * moves are answered directly by the worker that read them, including all shots of the
+//   computer opponent, so a move costs one wakeup and a few non-blocking sends
+
+#pragma once
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include "board.h"
+#include "fleetgen.h"
+
+struct Server;
+struct Connection;
+struct Match;
+
+//! worker of the server
+struct ServerWorker
+{
+    Server *server;    // the server the worker belongs to
+    int epoll;         // the epoll instance of the event loop
+    pthread_t thread;  // the worker thread
+    Connection *first; // the clients accepted by the worker
+};
+
+//! server statistics
+struct ServerStats
+{
+    long clients; // the number of connected clients
+    long matches; // the number of running matches
+    long moves;   // the number of shots made since the start
+};
+
+//! game server
+struct Server
+{
+    int listener;          // the listening socket
+    int wakeup;            // the event that stops the workers
+    int workers;           // the number of workers
+    ServerWorker *worker;  // the workers
+    int size;              // the arena size of all matches
+    Fleet fleet;           // the fleet of all matches
+    FleetGen generator;    // the shared fleet generator
+    uint64_t seed;         // the seed of all matches, each match uses its own stream
+    uint64_t streams;      // the number of started matches
+    pthread_mutex_t lobby; // the lock of the waiting match
+    Match *waiting;        // the match waiting for a second client
+    ServerStats stats;     // the statistics, updated atomically
+    char path[108];        // the path of the listening socket
+};
+
+//! start a server listening on a Unix domain socket
+//! * "workers" is the number of worker threads
+//! * all matches are played with the same arena size and fleet
+//! * a stale socket file at "path" is replaced
+//! * returns false if the socket cannot be created
+bool server_start(Server *s, const char *path, int workers, int size, const Fleet *fleet, uint64_t seed);
+
+//! get a snapshot of the server statistics
+void server_stats(Server *s, ServerStats *stats);
+
+//! stop a server
+//! * disconnects all clients, releases all matches and removes the socket file
+void server_stop(Server *s);
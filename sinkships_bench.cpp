@@ -0,0 +1,331 @@
+// Sink Ships self-play tournament benchmark
+// * plays computer opponents against each other without a terminal
+// * reports throughput and playing strength as CSV or JSON
+//
+// usage: sinkships_bench [strategy [strategy]] [-games=n] [-seed=n] [-threads=n] [-budget=ms]
+//                        [-size=n] [-fleet=list] [-endgame=ms] [-json]
+// * strategies are random, density and montecarlo
+// * "endgame" lets the density and Monte Carlo strategies solve the endgame within a budget per move
+// * the fleet is a comma separated list of ship sizes, e.g. -fleet=5,4,3,3,2
+// * without strategies a round robin tournament of all strategies is played
+
+#include "game.h"
+#include "ai.h"
+#include "solver.h"
+#include "threadpool.h"
+#include "util.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// strategy names, indexed by opponent mode
+static const char *strategyNames[] = {"random", "density", "montecarlo"};
+static const int strategies = sizeof(strategyNames) / sizeof(strategyNames[0]);
+
+// launch parameters
+int games = 1000;               // number of games per match (option -games=n)
+unsigned int seed = 1;          // seed of all games (option -seed=n)
+int threads = 0;                // number of threads, 0 means one per core (option -threads=n)
+float budget = 1;               // time budget of a Monte Carlo move in milliseconds (option -budget=ms)
+int size = board_default_size;  // arena size (option -size=n)
+Fleet fleet;                    // fleet composition (option -fleet=list)
+float endgame = 0;              // time budget of an endgame move in milliseconds, 0 disables the solver (option -endgame=ms)
+bool json = false;              // print JSON instead of CSV (option -json)
+
+// the shared fleet generator
+FleetGen generator;
+
+// the endgame solvers, one per worker thread
+Solver *solvers = NULL;
+
+// number of games per task
+const int chunkSize = 64;
+
+// match of two strategies
+struct Match
+{
+    int mode[2];    // the opponent modes of both players
+    int wins[2];    // the number of won games per player
+    long shots[2];  // the number of shots per player
+    double seconds; // the wall-clock time of the match
+};
+
+// chunk of games of a match
+struct Chunk
+{
+    Match *match;  // the match the games belong to
+    int first;     // the number of the first game
+    int count;     // the number of games
+    int wins[2];   // the number of won games per player
+    long shots[2]; // the number of shots per player
+};
+
+// gets the wall-clock time in seconds
+double getSeconds()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1E-9;
+}
+
+// plays a single game, game number n determines the random streams and the starting player
+// * "solver" is the endgame solver of the worker thread, NULL if the endgame is not solved
+void playGame(const Match *m, int n, int wins[2], long shots[2], Solver *solver)
+{
+    Game game;
+    game_init(&game, &generator.fleet, seed, 3 * (uint64_t)n, size);
+    game_set_generator(&game, &generator);
+
+    for (int p = 0; p < 2; p++)
+        game_random_ships(&game, p);
+
+    // each player aims at the arena of the other player
+    Ai ai[2];
+    for (int p = 0; p < 2; p++)
+    {
+        ai_init(&ai[p], &generator, m->mode[p], seed, 3 * (uint64_t)n + 1 + p);
+        ai_set_sampler(&ai[p], NULL, budget); // games already run in parallel
+        ai_set_solver(&ai[p], solver);
+    }
+
+    int player = n % 2; // alternate the starting player
+    while (!game_over(&game))
+    {
+        int y, x;
+        if (!ai_choose(&ai[player], &y, &x))
+            break;
+
+        int result = game_shoot(&game, 1 - player, y, x);
+        ai_update(&ai[player], y, x, result);
+        shots[player]++;
+
+        if (result == SHOT_MISS)
+            player = 1 - player;
+    }
+
+    int winner = game_winner(&game);
+    if (winner >= 0)
+        wins[winner]++;
+
+    ai_free(&ai[0]);
+    ai_free(&ai[1]);
+    game_free(&game);
+}
+
+// plays a chunk of games on a worker thread
+void playChunk(ThreadPool *pool, int worker, void *data)
+{
+    Chunk *c = (Chunk *)data;
+
+    for (int i = 0; i < c->count; i++)
+        playGame(c->match, c->first + i, c->wins, c->shots, solvers ? &solvers[worker] : NULL);
+}
+
+// plays all games of a match in parallel
+void playMatch(ThreadPool *pool, Match *m)
+{
+    int chunks = (games + chunkSize - 1) / chunkSize;
+    Chunk *chunk = new Chunk[chunks];
+
+    double start = getSeconds();
+
+    for (int i = 0; i < chunks; i++)
+    {
+        Chunk c = {m, i * chunkSize, chunkSize, {0, 0}, {0, 0}};
+        if (c.first + c.count > games)
+            c.count = games - c.first;
+
+        chunk[i] = c;
+        pool_submit(pool, playChunk, &chunk[i]);
+    }
+
+    pool_wait(pool);
+
+    m->seconds = getSeconds() - start;
+
+    for (int p = 0; p < 2; p++)
+    {
+        m->wins[p] = 0;
+        m->shots[p] = 0;
+
+        for (int i = 0; i < chunks; i++)
+        {
+            m->wins[p] += chunk[i].wins[p];
+            m->shots[p] += chunk[i].shots[p];
+        }
+    }
+
+    delete[] chunk;
+}
+
+// prints the result of a match
+void printMatch(const Match *m, bool first)
+{
+    long shots = m->shots[0] + m->shots[1];
+    double seconds = m->seconds > 0 ? m->seconds : 1E-9;
+
+    if (json)
+    {
+        printf("%s  {\"strategy_a\": \"%s\", \"strategy_b\": \"%s\", \"games\": %d, \"seed\": %u, "
+               "\"wins_a\": %d, \"wins_b\": %d, \"win_rate_a\": %.4f, "
+               "\"avg_game_length\": %.3f, \"avg_shots_a\": %.3f, \"avg_shots_b\": %.3f, "
+               "\"seconds\": %.6f, \"games_per_sec\": %.1f, \"shots_per_sec\": %.1f}",
+               first ? "" : ",\n",
+               strategyNames[m->mode[0]], strategyNames[m->mode[1]], games, seed,
+               m->wins[0], m->wins[1], (double)m->wins[0] / games,
+               (double)shots / games, (double)m->shots[0] / games, (double)m->shots[1] / games,
+               m->seconds, games / seconds, shots / seconds);
+    }
+    else
+    {
+        if (first)
+            printf("strategy_a,strategy_b,games,seed,wins_a,wins_b,win_rate_a,"
+                   "avg_game_length,avg_shots_a,avg_shots_b,seconds,games_per_sec,shots_per_sec\n");
+
+        printf("%s,%s,%d,%u,%d,%d,%.4f,%.3f,%.3f,%.3f,%.6f,%.1f,%.1f\n",
+               strategyNames[m->mode[0]], strategyNames[m->mode[1]], games, seed,
+               m->wins[0], m->wins[1], (double)m->wins[0] / games,
+               (double)shots / games, (double)m->shots[0] / games, (double)m->shots[1] / games,
+               m->seconds, games / seconds, shots / seconds);
+    }
+}
+
+// gets the opponent mode of a strategy name
+int getStrategy(const char *name)
+{
+    for (int i = 0; i < strategies; i++)
+        if (strcmp(name, strategyNames[i]) == 0)
+            return i;
+
+    return -1;
+}
+
+// main method
+int main(int argc, char *argv[])
+{
+    fleet_default(&fleet);
+
+    // parse launch parameters
+    for (int i = 1; get_opt(i, argc, argv) != NULL; i++)
+    {
+        double value;
+        const char *opt = get_opt(i, argc, argv, &value);
+
+        if (strpre("games", opt) == 0)
+            games = value;
+        else if (strpre("seed", opt) == 0)
+            seed = value;
+        else if (strpre("threads", opt) == 0)
+            threads = value;
+        else if (strpre("budget", opt) == 0)
+            budget = value;
+        else if (strpre("size", opt) == 0)
+            size = value;
+        else if (strpre("fleet", opt) == 0)
+        {
+            if (!strchr(opt, '=') || !fleet_parse(&fleet, strchr(opt, '=') + 1))
+            {
+                fprintf(stderr, "invalid fleet: %s\n", opt);
+                return 1;
+            }
+        }
+        else if (strpre("endgame", opt) == 0)
+            endgame = value;
+        else if (strpre("json", opt) == 0)
+            json = true;
+        else
+        {
+            fprintf(stderr, "unknown option: %s\n", opt);
+            return 1;
+        }
+    }
+
+    if (games < 1)
+        games = 1;
+    if (size < 1 || size > board_max_size)
+    {
+        fprintf(stderr, "the size must be between 1 and %d\n", board_max_size);
+        return 1;
+    }
+
+    // parse strategies
+    int modes[2];
+    int count = 0;
+    for (int i = 1; get_arg(i, argc, argv) != NULL; i++)
+    {
+        const char *arg = get_arg(i, argc, argv);
+
+        if (count == 2 || getStrategy(arg) < 0)
+        {
+            fprintf(stderr, "unknown strategy: %s\n", arg);
+            return 1;
+        }
+
+        modes[count++] = getStrategy(arg);
+    }
+
+    fleetgen_init(&generator, &fleet, size);
+
+    // check once that the fleet fits into the arena
+    Board board;
+    Random random;
+    board_init(&board, size);
+    rnd_seed(&random, seed);
+    bool fits = fleetgen_generate(&generator, &board, &random);
+    board_free(&board);
+
+    if (!fits)
+    {
+        fprintf(stderr, "the fleet does not fit into the arena\n");
+        return 1;
+    }
+
+    ThreadPool *pool = pool_create(threads);
+
+    if (endgame > 0)
+    {
+        solvers = new Solver[pool_threads(pool)];
+        for (int i = 0; i < pool_threads(pool); i++)
+            solver_init(&solvers[i], endgame);
+    }
+
+    if (json)
+        printf("[\n");
+
+    if (count > 0)
+    {
+        // play a single match
+        Match m = {{modes[0], count > 1 ? modes[1] : modes[0]}, {0, 0}, {0, 0}, 0};
+        playMatch(pool, &m);
+        printMatch(&m, true);
+    }
+    else
+    {
+        // play a round robin tournament
+        bool first = true;
+        for (int a = 0; a < strategies; a++)
+            for (int b = a; b < strategies; b++)
+            {
+                Match m = {{a, b}, {0, 0}, {0, 0}, 0};
+                playMatch(pool, &m);
+                printMatch(&m, first);
+                first = false;
+            }
+    }
+
+    if (json)
+        printf("\n]\n");
+
+    if (solvers)
+    {
+        for (int i = 0; i < pool_threads(pool); i++)
+            solver_free(&solvers[i]);
+        delete[] solvers;
+    }
+
+    pool_destroy(pool);
+    fleetgen_free(&generator);
+
+    return 0;
+}
@@ -0,0 +1,510 @@
+// Sink Ships server load test
+// * connects idle and active clients to a game server over a Unix domain socket
+// * the idle clients join a match and place their fleet, then they stay silent
+// * the active clients play against the computer opponent of the server
+//   and start a new match whenever a match is over
+// * each active client thinks for a random while before each shot, like a human player,
+//   the think time is drawn uniformly from half to one and a half of the mean think time
+// * reports the move throughput and the move latency percentiles as CSV or JSON,
+//   the latency of a move is the time from sending a shot to receiving its result
+//
+// usage: sinkships_loadtest [-socket=path] [-workers=n] [-idle=n] [-active=n] [-moves=n]
+//                           [-think=ms] [-threads=n] [-seed=n] [-json]
+// * without a socket path a server with n workers is started in-process on a temporary socket,
+//   so that the test runs on loopback without any external network
+
+#include "server.h"
+#include "protocol.h"
+#include "util.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <time.h>
+#include <unistd.h>
+
+// launch parameters
+const char *socketPath = NULL; // path of the server socket, NULL starts a server (option -socket=path)
+int workers = 4;               // number of workers of the started server (option -workers=n)
+int idle = 10000;              // number of idle clients (option -idle=n)
+int active = 1000;             // number of active clients (option -active=n)
+long moves = 100000;           // number of shots of all active clients (option -moves=n)
+float think = 100;             // mean time between the result of a shot and the next shot in milliseconds (option -think=ms)
+int threads = 2;               // number of client threads (option -threads=n)
+unsigned int seed = 1;         // seed of the shot order of the clients (option -seed=n)
+bool json = false;             // print JSON instead of CSV (option -json)
+
+// active client
+struct Player
+{
+    int fd;          // the client socket
+    Inbox in;        // the receive buffer
+    int size;        // the arena size of the match
+    int cells;       // the number of ship cells of the fleet
+    int *order;      // the shuffled cells of the opponent's arena
+    int shots;       // the number of shots in the current match
+    int hits;        // the number of hits in the current match
+    bool turn;       // the player shoots next
+    bool thinking;   // the player waits for its next shot
+    double due;      // the time of the next shot
+    double sent;     // the time the pending shot was sent, 0 if no shot is pending
+};
+
+// client thread
+struct Client
+{
+    int first;         // the first active client of the thread
+    int count;         // the number of active clients of the thread
+    long quota;        // the number of shots to make
+    long issued;       // the number of shots sent
+    long made;         // the number of shots with a received result
+    float *latency;    // the latency of each shot in micro seconds
+    long errors;       // the number of error messages
+    Player **ready;    // the min heap of thinking players, ordered by their due time
+    int thinking;      // the number of thinking players
+    Random random;     // the random number generator of the shot order
+    pthread_t thread;  // the client thread
+};
+
+// the active clients
+Player *player = NULL;
+
+// gets the wall-clock time in seconds
+double getSeconds()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1E-9;
+}
+
+// sends a message with up to five fields, exits if the server is gone
+void sendMessage(int fd, int type, int a = -1, int b = -1)
+{
+    Message m;
+    message_make(&m, type, a, b);
+
+    if (!protocol_send(fd, &m))
+    {
+        fprintf(stderr, "the server closed the connection\n");
+        exit(1);
+    }
+}
+
+// connects a client, joins a computer match and places a random fleet
+int joinMatch()
+{
+    int fd = protocol_connect(socketPath);
+
+    if (fd < 0)
+    {
+        fprintf(stderr, "cannot connect to socket: %s\n", socketPath);
+        exit(1);
+    }
+
+    sendMessage(fd, MSG_JOIN, MATCH_COMPUTER);
+    sendMessage(fd, MSG_RANDOM);
+
+    return fd;
+}
+
+// waits for the start of the match of an idle client
+void awaitStart(int fd)
+{
+    Inbox in;
+    Message m;
+
+    inbox_init(&in);
+
+    for (;;)
+    {
+        while (inbox_next(&in, &m) > 0)
+            if (m.type == MSG_START)
+                return;
+
+        if (!inbox_read(&in, fd))
+        {
+            fprintf(stderr, "the server closed the connection\n");
+            exit(1);
+        }
+    }
+}
+
+// makes the next shot of an active client
+void shoot(Client *c, Player *p)
+{
+    if (c->issued >= c->quota || p->shots >= p->size * p->size)
+        return;
+
+    int cell = p->order[p->shots++];
+
+    c->issued++;
+    p->turn = false;
+    p->sent = getSeconds();
+    sendMessage(p->fd, MSG_SHOOT, cell / p->size, cell % p->size);
+}
+
+// handles a message of the server to an active client
+void handleMessage(Client *c, Player *p, const Message *m)
+{
+    switch (m->type)
+    {
+    case MSG_WELCOME:
+        // a new match shoots at the cells in a new random order
+        if (m->field[0] != p->size)
+        {
+            delete[] p->order;
+            p->size = m->field[0];
+            p->order = new int[p->size * p->size];
+        }
+        for (int i = 0; i < p->size * p->size; i++)
+            p->order[i] = i;
+        for (int i = p->size * p->size - 1; i > 0; i--)
+            std::swap(p->order[i], p->order[rnd_int(&c->random, i + 1)]);
+
+        p->cells = 0;
+        for (int i = 0; i < m->field[1]; i++)
+            p->cells += m->field[2 + i];
+
+        p->shots = 0;
+        p->hits = 0;
+        p->turn = false;
+        break;
+    case MSG_START:
+        p->turn = m->field[0];
+        break;
+    case MSG_SHOT:
+        if (m->field[0] == 1)
+        {
+            if (p->sent > 0)
+                c->latency[c->made++] = (getSeconds() - p->sent) * 1E6;
+            p->sent = 0;
+
+            if (m->field[3] != SHOT_MISS)
+                p->hits++;
+        }
+        // the last hit is followed by the end of the match
+        p->turn = m->field[4] && p->hits < p->cells;
+        break;
+    case MSG_OVER:
+        p->turn = false;
+        sendMessage(p->fd, MSG_JOIN, MATCH_COMPUTER);
+        sendMessage(p->fd, MSG_RANDOM);
+        break;
+    case MSG_ERROR:
+        c->errors++;
+        break;
+    default:
+        break;
+    }
+}
+
+// adds a thinking player to the heap of a thread
+void pushReady(Client *c, Player *p)
+{
+    int i = c->thinking++;
+
+    for (; i > 0 && c->ready[(i - 1) / 2]->due > p->due; i = (i - 1) / 2)
+        c->ready[i] = c->ready[(i - 1) / 2];
+
+    c->ready[i] = p;
+}
+
+// removes the thinking player with the earliest due time from the heap of a thread
+Player *popReady(Client *c)
+{
+    Player *first = c->ready[0];
+    Player *last = c->ready[--c->thinking];
+    int i = 0;
+
+    for (int j = 1; j < c->thinking; i = j, j = 2 * j + 1)
+    {
+        if (j + 1 < c->thinking && c->ready[j + 1]->due < c->ready[j]->due)
+            j++;
+        if (last->due <= c->ready[j]->due)
+            break;
+
+        c->ready[i] = c->ready[j];
+    }
+
+    c->ready[i] = last;
+
+    return first;
+}
+
+// plays the matches of the active clients of a thread
+void *runClient(void *data)
+{
+    Client *c = (Client *)data;
+    int epoll = epoll_create1(0);
+
+    for (int i = c->first; i < c->first + c->count; i++)
+    {
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.ptr = &player[i];
+        epoll_ctl(epoll, EPOLL_CTL_ADD, player[i].fd, &ev);
+    }
+
+    struct epoll_event events[64];
+    int timeout = -1;
+
+    c->ready = new Player *[c->count];
+    c->thinking = 0;
+
+    while (c->made < c->quota)
+    {
+        int n = epoll_wait(epoll, events, 64, timeout);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+
+        for (int i = 0; i < n; i++)
+        {
+            Player *p = (Player *)events[i].data.ptr;
+            Message m;
+
+            if (!inbox_read(&p->in, p->fd))
+            {
+                fprintf(stderr, "the server closed the connection\n");
+                exit(1);
+            }
+
+            // the next shot is planned once all buffered results are known
+            while (inbox_next(&p->in, &m) > 0)
+                handleMessage(c, p, &m);
+
+            if (p->turn && p->sent == 0 && !p->thinking)
+            {
+                p->thinking = true;
+                p->due = getSeconds() + think * (0.5f + rnd(&c->random)) / 1000;
+                pushReady(c, p);
+            }
+        }
+
+        // make the due shots
+        double now = getSeconds();
+        timeout = -1;
+
+        while (c->thinking > 0)
+        {
+            Player *p = c->ready[0];
+
+            if (p->due > now)
+            {
+                timeout = (int)ceil((p->due - now) * 1000);
+                break;
+            }
+
+            popReady(c);
+            p->thinking = false;
+            shoot(c, p);
+        }
+    }
+
+    close(epoll);
+    delete[] c->ready;
+
+    return NULL;
+}
+
+// gets the latency percentile of sorted latencies
+float getPercentile(const float *latency, long count, double percentile)
+{
+    if (count == 0)
+        return 0;
+
+    long i = (long)(percentile / 100 * (count - 1) + 0.5);
+    return latency[i];
+}
+
+// main method
+int main(int argc, char *argv[])
+{
+    // parse launch parameters
+    for (int i = 1; get_opt(i, argc, argv) != NULL; i++)
+    {
+        double value;
+        const char *opt = get_opt(i, argc, argv, &value);
+
+        if (strpre("socket", opt) == 0 && strchr(opt, '='))
+            socketPath = strchr(opt, '=') + 1;
+        else if (strpre("workers", opt) == 0)
+            workers = value;
+        else if (strpre("idle", opt) == 0)
+            idle = value;
+        else if (strpre("active", opt) == 0)
+            active = value;
+        else if (strpre("moves", opt) == 0)
+            moves = value;
+        else if (strpre("think", opt) == 0)
+            think = value;
+        else if (strpre("threads", opt) == 0)
+            threads = value;
+        else if (strpre("seed", opt) == 0)
+            seed = value;
+        else if (strpre("json", opt) == 0)
+            json = true;
+        else
+        {
+            fprintf(stderr, "unknown option: %s\n", opt);
+            return 1;
+        }
+    }
+
+    if (idle < 0)
+        idle = 0;
+    if (active < 1)
+        active = 1;
+    if (threads < 1)
+        threads = 1;
+    if (threads > active)
+        threads = active;
+    if (moves < active)
+        moves = active;
+
+    // the client sockets and the sockets of an in-process server are open at the same time
+    int fds = (socketPath ? 1 : 2) * (idle + active) + 64;
+    if (!protocol_reserve_fds(fds))
+    {
+        fprintf(stderr, "cannot open %d file descriptors, raise the hard limit with ulimit -n\n", fds);
+        return 1;
+    }
+
+    // start a server on a temporary socket
+    Server server;
+    char path[64];
+
+    if (!socketPath)
+    {
+        Fleet fleet;
+        fleet_default(&fleet);
+
+        snprintf(path, sizeof(path), "/tmp/sinkships-loadtest-%d.sock", (int)getpid());
+        socketPath = path;
+
+        if (!server_start(&server, socketPath, workers, board_default_size, &fleet, seed))
+        {
+            fprintf(stderr, "cannot listen on socket: %s\n", socketPath);
+            return 1;
+        }
+    }
+
+    // connect the idle clients, all requests are sent before the first answer is awaited
+    int *idleFd = new int[idle];
+
+    double start = getSeconds();
+
+    for (int i = 0; i < idle; i++)
+        idleFd[i] = joinMatch();
+    for (int i = 0; i < idle; i++)
+        awaitStart(idleFd[i]);
+
+    double setup = getSeconds() - start;
+
+    // connect the active clients
+    player = new Player[active];
+
+    for (int i = 0; i < active; i++)
+    {
+        Player *p = &player[i];
+
+        p->fd = joinMatch();
+        inbox_init(&p->in);
+        p->size = 0;
+        p->order = NULL;
+        p->cells = 0;
+        p->shots = 0;
+        p->hits = 0;
+        p->turn = false;
+        p->thinking = false;
+        p->due = 0;
+        p->sent = 0;
+    }
+
+    // play on all client threads
+    Client *client = new Client[threads];
+
+    start = getSeconds();
+
+    for (int t = 0; t < threads; t++)
+    {
+        Client *c = &client[t];
+
+        c->first = t * active / threads;
+        c->count = (t + 1) * active / threads - c->first;
+        c->quota = (t + 1) * moves / threads - t * moves / threads;
+        c->issued = 0;
+        c->made = 0;
+        c->latency = new float[c->quota];
+        c->errors = 0;
+        rnd_seed(&c->random, seed, t);
+
+        pthread_create(&c->thread, NULL, runClient, c);
+    }
+
+    for (int t = 0; t < threads; t++)
+        pthread_join(client[t].thread, NULL);
+
+    double seconds = getSeconds() - start;
+    if (seconds <= 0)
+        seconds = 1E-9;
+
+    // merge the latencies of all threads
+    float *latency = new float[moves];
+    long count = 0;
+    long errors = 0;
+
+    for (int t = 0; t < threads; t++)
+    {
+        for (long i = 0; i < client[t].made; i++)
+            latency[count++] = client[t].latency[i];
+
+        errors += client[t].errors;
+        delete[] client[t].latency;
+    }
+
+    std::sort(latency, latency + count);
+
+    ServerStats stats = {0, 0, 0};
+    if (socketPath == path)
+        server_stats(&server, &stats);
+
+    if (json)
+        printf("{\"idle\": %d, \"active\": %d, \"threads\": %d, \"workers\": %d, \"think_ms\": %.1f, \"moves\": %ld, "
+               "\"setup_seconds\": %.3f, \"seconds\": %.3f, \"moves_per_sec\": %.1f, "
+               "\"p50_us\": %.1f, \"p99_us\": %.1f, \"max_us\": %.1f, \"errors\": %ld, \"matches\": %ld}\n",
+               idle, active, threads, socketPath == path ? workers : 0, think, count,
+               setup, seconds, count / seconds,
+               getPercentile(latency, count, 50), getPercentile(latency, count, 99),
+               count > 0 ? latency[count - 1] : 0, errors, stats.matches);
+    else
+        printf("idle,active,threads,workers,think_ms,moves,setup_seconds,seconds,moves_per_sec,"
+               "p50_us,p99_us,max_us,errors,matches\n"
+               "%d,%d,%d,%d,%.1f,%ld,%.3f,%.3f,%.1f,%.1f,%.1f,%.1f,%ld,%ld\n",
+               idle, active, threads, socketPath == path ? workers : 0, think, count,
+               setup, seconds, count / seconds,
+               getPercentile(latency, count, 50), getPercentile(latency, count, 99),
+               count > 0 ? latency[count - 1] : 0, errors, stats.matches);
+
+    // disconnect all clients
+    for (int i = 0; i < active; i++)
+    {
+        close(player[i].fd);
+        delete[] player[i].order;
+    }
+    for (int i = 0; i < idle; i++)
+        close(idleFd[i]);
+
+    if (socketPath == path)
+        server_stop(&server);
+
+    delete[] latency;
+    delete[] client;
+    delete[] player;
+    delete[] idleFd;
+
+    return errors > 0 ? 1 : 0;
+}
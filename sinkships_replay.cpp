@@ -0,0 +1,122 @@
+// Sink Ships replay simulator
+// * re-simulates recorded games without a terminal
+// * reports the outcome and the simulation throughput of each log as CSV
+//
+// usage: sinkships_replay log [log ...] [-repeat=n]
+// * each log is simulated n times to measure the throughput
+// * the exit code is 1 if a log cannot be read or contains an illegal move,
+//   so that archived games can be used as a regression suite
+
+#include "game.h"
+#include "replay.h"
+#include "util.h"
+
+#include <stdio.h>
+#include <time.h>
+
+// launch parameters
+int repeat = 1; // number of simulations per log (option -repeat=n)
+
+// gets the wall-clock time in seconds
+double getSeconds()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1E-9;
+}
+
+// simulates a log and prints its outcome, returns false if the log is invalid
+bool simulateLog(const char *path)
+{
+    Replay replay;
+    if (!replay_load(&replay, path))
+    {
+        fprintf(stderr, "cannot read replay log: %s\n", path);
+        return false;
+    }
+
+    long moves = 0;
+    int winner = -1;
+    int shots[2] = {0, 0};
+
+    double start = getSeconds();
+
+    for (int i = 0; i < repeat && moves >= 0; i++)
+    {
+        Game game;
+        replay_init_game(&replay, &game);
+
+        moves = replay_simulate(&replay, &game);
+
+        // the outcome of the last simulation is reported
+        if (i == repeat - 1)
+        {
+            winner = game_winner(&game);
+            for (int p = 0; p < 2; p++)
+            {
+                // the shots at an arena are made by the other player
+                const Board *b = &game.board[1 - p];
+                for (int y = 0; y < b->size; y++)
+                    for (int x = 0; x < b->size; x++)
+                        shots[p] += board_get_cell(b, y, x) & CELL_SHOT;
+            }
+        }
+
+        game_free(&game);
+    }
+
+    double seconds = getSeconds() - start;
+    if (seconds <= 0)
+        seconds = 1E-9;
+
+    replay_close(&replay);
+
+    if (moves < 0)
+    {
+        fprintf(stderr, "illegal move in replay log: %s\n", path);
+        return false;
+    }
+
+    printf("%s,%d,%ld,%d,%d,%d,%.6f,%.1f\n",
+           path, replay.size, moves, shots[0], shots[1], winner,
+           seconds, moves * (double)repeat / seconds);
+
+    return true;
+}
+
+// main method
+int main(int argc, char *argv[])
+{
+    // parse launch parameters
+    for (int i = 1; get_opt(i, argc, argv) != NULL; i++)
+    {
+        double value;
+        const char *opt = get_opt(i, argc, argv, &value);
+
+        if (strpre("repeat", opt) == 0)
+            repeat = value;
+        else
+        {
+            fprintf(stderr, "unknown option: %s\n", opt);
+            return 1;
+        }
+    }
+
+    if (repeat < 1)
+        repeat = 1;
+
+    if (get_arg(1, argc, argv) == NULL)
+    {
+        fprintf(stderr, "usage: sinkships_replay log [log ...] [-repeat=n]\n");
+        return 1;
+    }
+
+    printf("log,size,moves,shots_0,shots_1,winner,seconds,moves_per_sec\n");
+
+    bool valid = true;
+    for (int i = 1; get_arg(i, argc, argv) != NULL; i++)
+        if (!simulateLog(get_arg(i, argc, argv)))
+            valid = false;
+
+    return valid ? 0 : 1;
+}
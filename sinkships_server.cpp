@@ -0,0 +1,134 @@
+// Sink Ships game server
+// * hosts matches for thin terminal clients on a Unix domain socket, see server.h
+// * runs until it is interrupted, optionally reporting its statistics as CSV
+//
+// usage: sinkships_server [-socket=path] [-workers=n] [-size=n] [-fleet=list] [-seed=n]
+//                         [-clients=n] [-interval=s]
+// * clients connect with: main -connect=path
+// * "clients" is the number of clients the file descriptor limit is raised for
+
+#include "server.h"
+#include "protocol.h"
+#include "util.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// launch parameters
+const char *socketPath = protocol_default_socket; // path of the server socket (option -socket=path)
+int workers = 4;                                  // number of worker threads (option -workers=n)
+int size = board_default_size;                    // arena size of all matches (option -size=n)
+Fleet fleet;                                      // fleet of all matches (option -fleet=list)
+unsigned int seed = time(NULL);                   // seed of all matches (option -seed=n)
+int clients = 20000;                              // number of clients to reserve descriptors for (option -clients=n)
+float interval = 0;                               // seconds between statistics reports, 0 disables them (option -interval=s)
+
+// main method
+int main(int argc, char *argv[])
+{
+    fleet_default(&fleet);
+
+    // parse launch parameters
+    for (int i = 1; get_opt(i, argc, argv) != NULL; i++)
+    {
+        double value;
+        const char *opt = get_opt(i, argc, argv, &value);
+
+        if (strpre("socket", opt) == 0 && strchr(opt, '='))
+            socketPath = strchr(opt, '=') + 1;
+        else if (strpre("workers", opt) == 0)
+            workers = value;
+        else if (strpre("size", opt) == 0)
+            size = value;
+        else if (strpre("fleet", opt) == 0)
+        {
+            if (!strchr(opt, '=') || !fleet_parse(&fleet, strchr(opt, '=') + 1))
+            {
+                fprintf(stderr, "invalid fleet: %s\n", opt);
+                return 1;
+            }
+        }
+        else if (strpre("seed", opt) == 0)
+            seed = value;
+        else if (strpre("clients", opt) == 0)
+            clients = value;
+        else if (strpre("interval", opt) == 0)
+            interval = value;
+        else
+        {
+            fprintf(stderr, "unknown option: %s\n", opt);
+            return 1;
+        }
+    }
+
+    if (size < 1 || size > board_max_size)
+    {
+        fprintf(stderr, "the size must be between 1 and %d\n", board_max_size);
+        return 1;
+    }
+
+    // check once that the fleet fits into the arena
+    FleetGen generator;
+    Board board;
+    Random random;
+    fleetgen_init(&generator, &fleet, size);
+    board_init(&board, size);
+    rnd_seed(&random, seed);
+    bool fits = fleetgen_generate(&generator, &board, &random);
+    board_free(&board);
+    fleetgen_free(&generator);
+
+    if (!fits)
+    {
+        fprintf(stderr, "the fleet does not fit into the arena\n");
+        return 1;
+    }
+
+    if (!protocol_reserve_fds(clients + 64))
+        fprintf(stderr, "warning: fewer than %d clients can connect\n", clients);
+
+    // the signals are taken by the main thread, the workers inherit the blocked mask
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+    Server server;
+    if (!server_start(&server, socketPath, workers, size, &fleet, seed))
+    {
+        fprintf(stderr, "cannot listen on socket: %s\n", socketPath);
+        return 1;
+    }
+
+    if (interval > 0)
+        printf("seconds,clients,matches,moves\n");
+
+    // report the statistics until the server is interrupted
+    struct timespec timeout;
+    timeout.tv_sec = (time_t)interval;
+    timeout.tv_nsec = (long)((interval - timeout.tv_sec) * 1E9);
+
+    for (float seconds = interval;; seconds += interval)
+    {
+        int signal = interval > 0 ? sigtimedwait(&signals, NULL, &timeout) : sigwaitinfo(&signals, NULL);
+
+        if (signal == SIGINT || signal == SIGTERM)
+            break;
+
+        if (interval > 0)
+        {
+            ServerStats stats;
+            server_stats(&server, &stats);
+
+            printf("%.1f,%ld,%ld,%ld\n", seconds, stats.clients, stats.matches, stats.moves);
+            fflush(stdout);
+        }
+    }
+
+    server_stop(&server);
+
+    return 0;
+}
@@ -0,0 +1,206 @@
+// Sink Ships spectator viewer
+// * watches a running game that streams its frames to spectators, see spectate.h
+// * decodes the delta-compressed frames and draws the changed cells, 'q' quits
+//
+// usage: sinkships_watch [-socket=path] [-ansi] [-capture=file]
+// * the game is started with: main -spectate=path
+// * "ansi" draws the frames with the ANSI terminal encoder instead of NCurses,
+//   which writes each batch of frames with a single write()
+// * "capture" records the ANSI stream of the frames to a file, which is replayed with: cat file
+
+#include "gfx.h"
+#include "protocol.h"
+#include "spectate.h"
+#include "util.h"
+#include "ansiterm.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+// launch parameters
+const char *socketPath = spectate_default_socket; // path of the spectator socket (option -socket=path)
+bool ansiOutput = false; // draw with the ANSI terminal encoder (option -ansi)
+const char *capturePath = NULL; // path of the capture file (option -capture=file)
+
+// ANSI terminal encoders of the screen and the capture file
+AnsiTerm screenTerm;
+AnsiTerm captureTerm;
+int captureFd = -1;
+
+// receive buffer, holds the frames that are not complete yet
+unsigned char *buffer = NULL;
+int bufferBytes = 0;
+int bufferSize = 0;
+
+// draws a decoded span of cells
+void drawSpan(int y, int x, const int *cells, int n, void *data)
+{
+    if (ansiOutput)
+        ansi_add_run(&screenTerm, y, x, cells, n);
+    else
+    {
+        move(y, x);
+        for (int i = 0; i < n; i++)
+            addch(cells[i]);
+    }
+
+    if (captureFd >= 0)
+        ansi_add_run(&captureTerm, y, x, cells, n);
+}
+
+// reads the available bytes of the stream and draws all complete frames
+// * returns false if the stream has ended or is corrupt
+bool receiveFrames(int fd)
+{
+    if (bufferSize - bufferBytes < 4096)
+    {
+        bufferSize = 2 * bufferSize + 4096;
+        unsigned char *data = new unsigned char[bufferSize];
+        if (buffer)
+            memcpy(data, buffer, bufferBytes);
+        delete[] buffer;
+        buffer = data;
+    }
+
+    ssize_t bytes = read(fd, buffer + bufferBytes, bufferSize - bufferBytes);
+    if (bytes <= 0)
+        return false;
+
+    bufferBytes += bytes;
+
+    int pos = 0;
+    for (;;)
+    {
+        int frameBytes = delta_frame_bytes(buffer + pos, bufferBytes - pos);
+        if (frameBytes < 0)
+            return false;
+        if (frameBytes == 0)
+            break;
+
+        // a keyframe redraws the whole screen
+        if (buffer[pos + 4] & DELTA_KEYFRAME)
+        {
+            if (ansiOutput)
+                ansi_clear(&screenTerm);
+            else
+                erase();
+
+            if (captureFd >= 0)
+                ansi_clear(&captureTerm);
+        }
+
+        if (!delta_decode(buffer + pos, frameBytes, drawSpan))
+            return false;
+
+        pos += frameBytes;
+    }
+
+    memmove(buffer, buffer + pos, bufferBytes - pos);
+    bufferBytes -= pos;
+
+    if (ansiOutput)
+        ansi_flush(&screenTerm);
+    else
+        refresh();
+
+    if (captureFd >= 0)
+        if (ansi_flush(&captureTerm) < 0)
+            return false;
+
+    return true;
+}
+
+// main method
+int main(int argc, char *argv[])
+{
+    // parse launch parameters
+    for (int i = 1; get_opt(i, argc, argv) != NULL; i++)
+    {
+        const char *opt = get_opt(i, argc, argv);
+
+        if (strpre("socket", opt) == 0 && strchr(opt, '='))
+            socketPath = strchr(opt, '=') + 1;
+        else if (strpre("ansi", opt) == 0)
+            ansiOutput = true;
+        else if (strpre("capture", opt) == 0 && strchr(opt, '='))
+            capturePath = strchr(opt, '=') + 1;
+        else
+        {
+            fprintf(stderr, "unknown option: %s\n", opt);
+            return 1;
+        }
+    }
+
+    int fd = protocol_connect(socketPath);
+    if (fd < 0)
+    {
+        fprintf(stderr, "cannot watch the game on socket: %s\n", socketPath);
+        return 1;
+    }
+
+    if (capturePath)
+    {
+        captureFd = open(capturePath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (captureFd < 0)
+        {
+            fprintf(stderr, "cannot write capture file: %s\n", capturePath);
+            close(fd);
+            return 1;
+        }
+    }
+
+    init_gfx();
+    init_color();
+
+    // NCurses keeps reading the keys, while the encoders write the frames
+    ansi_init(&screenTerm, STDOUT_FILENO, LINES, COLS);
+    ansi_init(&captureTerm, captureFd, LINES, COLS);
+
+    draw_text(0, 0, "Waiting for the next frame of %s, press 'q' to quit.", socketPath);
+    refresh();
+
+    // the frames of the game wake up the viewer
+    watch_input(fd);
+
+    bool watching = true;
+    while (watching)
+    {
+        int key = wait_keycode();
+
+        if (tolower(key) == 'q')
+            break;
+
+        if (key == ERR)
+            watching = receiveFrames(fd);
+    }
+
+    watch_input(-1);
+
+    if (ansiOutput)
+    {
+        ansi_restore(&screenTerm);
+        ansi_flush(&screenTerm);
+    }
+
+    exit_gfx();
+
+    if (captureFd >= 0)
+    {
+        ansi_restore(&captureTerm);
+        ansi_flush(&captureTerm);
+        close(captureFd);
+    }
+
+    ansi_free(&screenTerm);
+    ansi_free(&captureTerm);
+
+    close(fd);
+    delete[] buffer;
+
+    if (!watching)
+        printf("the game has ended\n");
+
+    return 0;
+}
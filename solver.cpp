@@ -0,0 +1,755 @@
+// Sink Ships endgame solver
+
+#include "solver.h"
+
+#include <time.h>
+
+// bound that is larger than any expected number of misses
+static const float no_cutoff = 1E30f;
+
+// the number of searched states between two checks of the deadline
+static const int check_interval = 256;
+
+// helper for getting the wall-clock time in seconds
+static double get_seconds()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1E-9;
+}
+
+// helper for generating a 64-bit Zobrist key
+static uint64_t zobrist_key(Random *random)
+{
+    uint64_t key = rnd_next(random);
+    return (key << 32) | rnd_next(random);
+}
+
+// helper for mixing the bits of a key, so that keys of different fleets do not cancel out
+static uint64_t mix_key(uint64_t key)
+{
+    key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    key = (key ^ (key >> 27)) * 0x94D049BB133111EBULL;
+    return key ^ (key >> 31);
+}
+
+// helper for checking the deadline of the move
+static bool check_deadline(Solver *s)
+{
+    if (!s->timeout && ++s->stats.nodes % check_interval == 0)
+        if (get_seconds() > s->deadline)
+            s->timeout = true;
+
+    return s->timeout;
+}
+
+// helper for finding the sunk ships of an opponent
+// * ships do not touch, so each line of sunk cells is a ship
+static void find_sunk(Solver *s, const Ai *a)
+{
+    const FleetGen *g = a->gen;
+
+    s->sunk = 0;
+    s->sunk_key = 0;
+
+    Bits128 cells = a->sunk_bits;
+    while (!bits_empty(cells))
+    {
+        int c = bits_first(cells);
+        Bits128 line = bits_bit(c);
+
+        for (int k = 0; k < g->lists; k++)
+        {
+            const PlacementList *l = &g->placements[k];
+
+            for (int w = 0; w < placement_words; w++)
+                for (uint64_t bits = l->cover[c].w[w]; bits; bits &= bits - 1)
+                {
+                    const Placement *m = l->ref[(w << 6) + __builtin_ctzll(bits)].mask;
+
+                    if (bits_empty(bits_andnot(m->ship, a->sunk_bits)) &&
+                        bits_empty(bits_and(bits_andnot(m->halo, m->ship), a->sunk_bits)))
+                    {
+                        s->sunk_ship[s->sunk] = m;
+                        s->sunk_list[s->sunk] = k;
+                        s->sunk++;
+                        line = m->ship;
+                    }
+                }
+        }
+
+        cells = bits_andnot(cells, line);
+        while (!bits_empty(line))
+            s->sunk_key ^= s->zobrist_cell[bits_pop(&line)];
+    }
+
+    s->sunk_key = mix_key(s->sunk_key);
+}
+
+// helper for blocking the halo of a drawn ship
+// * masks out all placements that cover a newly blocked cell
+static void block_ship(const FleetGen *g, const Placement *m, PlacementSet *available, Bits128 *blocked)
+{
+    Bits128 cells = bits_andnot(m->halo, *blocked);
+    *blocked = bits_or(*blocked, m->halo);
+
+    while (!bits_empty(cells))
+    {
+        int c = bits_pop(&cells);
+        for (int j = 0; j < g->lists; j++)
+            pset_remove(&available[j], &g->placements[j].cover[c]);
+    }
+}
+
+// helper for getting the probability that the fleet generator draws the ships of a placement list
+// in any order, given the ships of the larger sizes, up to a common factor
+// * the number of placements left for the next draw only depends on the set of ships drawn before,
+//   so the sum over all orders is accumulated over the subsets of the ships
+static double draw_orders(const FleetGen *g, int k, const Placement **drawn, int n,
+                          const PlacementSet *available, Bits128 blocked)
+{
+    PlacementSet left[1 << solver_max_order];
+    Bits128 halo[1 << solver_max_order];
+    double p[1 << solver_max_order];
+    int placements[1 << solver_max_order];
+
+    left[0] = available[k];
+    halo[0] = blocked;
+    placements[0] = pset_count(&left[0]);
+    p[0] = 1;
+
+    for (int t = 1; t < 1 << n; t++)
+    {
+        // the subset without its lowest ship was handled before
+        int i = __builtin_ctz(t);
+        int u = t & (t - 1);
+
+        left[t] = left[u];
+        Bits128 cells = bits_andnot(drawn[i]->halo, halo[u]);
+        halo[t] = bits_or(halo[u], drawn[i]->halo);
+        while (!bits_empty(cells))
+            pset_remove(&left[t], &g->placements[k].cover[bits_pop(&cells)]);
+        placements[t] = pset_count(&left[t]);
+
+        // each ship of the subset may be the last one drawn
+        p[t] = 0;
+        for (int j = 0; j < n; j++)
+            if (t >> j & 1)
+                p[t] += p[t & ~(1 << j)] / placements[t & ~(1 << j)];
+    }
+
+    return p[(1 << n) - 1];
+}
+
+// helper for getting the probability that the fleet generator draws a fleet, up to a common factor
+// * the ships are drawn in the order of the generator, each uniformly from the remaining legal placements
+// * the ships of the same size may be drawn in any order, whose probabilities are summed up,
+//   beyond solver_max_order ships of a size the sunk ships are taken to be drawn first
+static double prior(const Solver *s, const FleetGen *g, const Placement **ships, const int *list)
+{
+    const Placement *drawn[bitboard_size][fleet_max_ships];
+    int count[bitboard_size];
+    for (int k = 0; k < g->lists; k++)
+        count[k] = 0;
+
+    for (int i = 0; i < s->sunk; i++)
+        drawn[s->sunk_list[i]][count[s->sunk_list[i]]++] = s->sunk_ship[i];
+    for (int i = 0; i < s->ships; i++)
+        drawn[list[i]][count[list[i]]++] = ships[i];
+
+    PlacementSet available[bitboard_size];
+    for (int k = 0; k < g->lists; k++)
+        available[k] = g->placements[k].all;
+
+    Bits128 blocked = bits128();
+    double p = 1;
+
+    // the placement lists are drawn one after another, by descending ship size
+    for (int k = 0; k < g->lists; k++)
+    {
+        if (count[k] <= solver_max_order)
+            p *= draw_orders(g, k, drawn[k], count[k], available, blocked);
+
+        for (int i = 0; i < count[k]; i++)
+        {
+            if (count[k] > solver_max_order)
+                p /= pset_count(&available[k]);
+
+            block_ship(g, drawn[k][i], available, &blocked);
+        }
+    }
+
+    return p;
+}
+
+// helper for enumerating the fleets of the remaining ships that are consistent with the observations
+// * the ships of a placement list are placed in ascending placement order, so each fleet is found once
+// * returns false if there are too many fleets or the deadline has passed
+static bool enumerate(Solver *s, const Ai *a, int *left, int k, int from, const PlacementSet *available,
+                      Bits128 cells, const Placement **ships, int *list, int placed)
+{
+    const FleetGen *g = a->gen;
+
+    while (k < g->lists && left[k] == 0)
+    {
+        k++;
+        from = 0;
+    }
+
+    if (k == g->lists)
+    {
+        // all damaged cells are covered
+        if (!bits_empty(bits_andnot(a->hit_bits, cells)))
+            return true;
+
+        if (s->fleets == s->max_fleets)
+            return false;
+
+        // ships do not touch, so the ship cells identify the fleet
+        uint64_t key = 0;
+        for (Bits128 c = cells; !bits_empty(c);)
+            key ^= s->zobrist_cell[bits_pop(&c)];
+
+        s->fleet_cells[s->fleets] = cells;
+        s->fleet_key[s->fleets] = mix_key(key ^ s->sunk_key);
+        s->fleet_weight[s->fleets] = prior(s, g, ships, list);
+        for (int i = 0; i < placed; i++)
+            s->fleet_ship[s->fleets * s->ships + i] = ships[i];
+        s->fleets++;
+
+        return true;
+    }
+
+    if (check_deadline(s))
+        return false;
+
+    // the uncovered damaged cells need to be covered by the ships left to place
+    Bits128 uncovered = bits_andnot(a->hit_bits, cells);
+
+    int capacity = 0;
+    for (int j = k; j < g->lists; j++)
+        capacity += left[j] * g->length[j];
+    if (bits_count(uncovered) > capacity)
+        return true;
+
+    while (!bits_empty(uncovered))
+    {
+        int c = bits_pop(&uncovered);
+
+        bool coverable = false;
+        for (int j = k; j < g->lists && !coverable; j++)
+            if (left[j] > 0)
+                for (int w = 0; w < placement_words && !coverable; w++)
+                    coverable = (available[j].w[w] & g->placements[j].cover[c].w[w]) != 0;
+
+        if (!coverable)
+            return true;
+    }
+
+    const PlacementList *l = &g->placements[k];
+
+    for (int w = from >> 6; w < placement_words; w++)
+        for (uint64_t bits = available[k].w[w]; bits; bits &= bits - 1)
+        {
+            int p = (w << 6) + __builtin_ctzll(bits);
+            if (p < from)
+                continue;
+
+            const Placement *m = l->ref[p].mask;
+
+            // mask out all placements that overlap or touch the ship
+            PlacementSet next[bitboard_size];
+            for (int j = k; j < g->lists; j++)
+                next[j] = available[j];
+
+            Bits128 halo = m->halo;
+            while (!bits_empty(halo))
+            {
+                int c = bits_pop(&halo);
+                for (int j = k; j < g->lists; j++)
+                    pset_remove(&next[j], &g->placements[j].cover[c]);
+            }
+
+            ships[placed] = m;
+            list[placed] = k;
+            left[k]--;
+            bool ok = enumerate(s, a, left, k, p + 1, next, bits_or(cells, m->ship), ships, list, placed + 1);
+            left[k]++;
+
+            if (!ok)
+                return false;
+        }
+
+    return true;
+}
+
+// candidate shots of a state
+struct SolverShots
+{
+    Bits128 any;                                       // the unshot cells that are ship cells in some fleet
+    Bits128 all;                                       // the unshot cells that are ship cells in all fleets
+    double cover[bitboard_size * bitboard_size];       // the weight of the fleets covering each unshot cell
+    uint64_t signature[bitboard_size * bitboard_size]; // the hash of the shot results of all fleets
+};
+
+// helper for weighing the fleets covering the unshot cells of a state
+// * "shot" are the ship cells that are shot already
+// * cells with the same signature split the fleets alike, so only one of them needs to be searched
+// * returns false if all fleets agree on the unshot ship cells, which are then sunk without misses
+static bool count_shots(const Solver *s, Bits128 shot, const int *fleets, int n, SolverShots *shots)
+{
+    shots->any = bits128();
+    shots->all = s->fleet_cells[fleets[0]];
+    for (int i = 0; i < n; i++)
+    {
+        shots->any = bits_or(shots->any, s->fleet_cells[fleets[i]]);
+        shots->all = bits_and(shots->all, s->fleet_cells[fleets[i]]);
+    }
+
+    shots->any = bits_andnot(shots->any, shot);
+    shots->all = bits_andnot(shots->all, shot);
+
+    if (bits_empty(bits_andnot(shots->any, shots->all)))
+        return false;
+
+    for (int c = 0; c < bitboard_size * bitboard_size; c++)
+    {
+        shots->cover[c] = 0;
+        shots->signature[c] = 0;
+    }
+
+    // a shot sinks a ship if it is the last unshot cell of the ship
+    for (int i = 0; i < n; i++)
+    {
+        int f = fleets[i];
+        uint64_t key = s->fleet_key[f];
+
+        for (int k = 0; k < s->ships; k++)
+        {
+            Bits128 cells = bits_andnot(s->fleet_ship[f * s->ships + k]->ship, shot);
+            uint64_t result = bits_count(cells) == 1 ? mix_key(key) : key;
+
+            while (!bits_empty(cells))
+            {
+                int c = bits_pop(&cells);
+                shots->cover[c] += s->fleet_weight[f];
+                shots->signature[c] ^= result;
+            }
+        }
+    }
+
+    return true;
+}
+
+// helper for splitting the fleets by the result of a shot at cell c
+// * the fleets are sorted into consecutive groups of sunk ships, hits and misses,
+//   the group sizes are returned in "counts", their weights in "weights" and their keys in "keys"
+static void split(const Solver *s, Bits128 shot, const int *fleets, int n, int c, int *group,
+                  int counts[3], double weights[3], uint64_t keys[3])
+{
+    int hits = 0;
+    for (int j = 0; j < n; j++)
+        hits += bits_test(s->fleet_cells[fleets[j]], c);
+
+    // the sunk and hit fleets fill the first slots from both ends
+    int front = 0, back = hits, misses = 0;
+    weights[0] = weights[1] = weights[2] = 0;
+    keys[0] = keys[1] = keys[2] = 0;
+
+    shot = bits_or(shot, bits_bit(c));
+
+    for (int j = 0; j < n; j++)
+    {
+        int f = fleets[j];
+        int r = 2;
+
+        if (!bits_test(s->fleet_cells[f], c))
+            group[hits + misses++] = f;
+        else
+        {
+            const Placement *ship = NULL;
+            for (int k = 0; k < s->ships && !ship; k++)
+                if (bits_test(s->fleet_ship[f * s->ships + k]->ship, c))
+                    ship = s->fleet_ship[f * s->ships + k];
+
+            r = bits_empty(bits_andnot(ship->ship, shot)) ? 0 : 1;
+            group[r == 0 ? front++ : --back] = f;
+        }
+
+        weights[r] += s->fleet_weight[f];
+        keys[r] ^= s->fleet_key[f];
+    }
+
+    counts[0] = front;
+    counts[1] = hits - front;
+    counts[2] = misses;
+}
+
+// helper for getting the expected number of misses of the greedy policy,
+// which always shoots at the cell that is most likely a ship cell
+// * the value of a real policy bounds the optimum from above
+static double greedy(const Solver *s, Bits128 shot, const int *fleets, int n, double weight, int *top, int *cell)
+{
+    SolverShots shots;
+    if (!count_shots(s, shot, fleets, n, &shots))
+    {
+        *cell = bits_empty(shots.all) ? -1 : bits_first(shots.all);
+        return 0;
+    }
+
+    int c = -1;
+    if (!bits_empty(shots.all))
+        c = bits_first(shots.all);
+    else
+        for (Bits128 cells = shots.any; !bits_empty(cells);)
+        {
+            int d = bits_pop(&cells);
+            if (c < 0 || shots.cover[d] > shots.cover[c])
+                c = d;
+        }
+
+    *cell = c;
+
+    int counts[3];
+    double weights[3];
+    uint64_t keys[3];
+    split(s, shot, fleets, n, c, top, counts, weights, keys);
+
+    double value = weights[2] / weight;
+    const int *group = top;
+
+    for (int r = 0; r < 3; r++)
+    {
+        if (counts[r] > 0)
+        {
+            int unused;
+            Bits128 after = r < 2 ? bits_or(shot, bits_bit(c)) : shot;
+            value += weights[r] / weight * greedy(s, after, group, counts[r], weights[r], top + n, &unused);
+        }
+
+        group += counts[r];
+    }
+
+    return value;
+}
+
+// helper for searching the expected number of misses of a state
+// * "fleets" lists the n fleets that are consistent with the state, "weight" is their total weight,
+//   "key" is the Zobrist hash of the fleets and "top" is the free stack space
+// * the fleets determine the value of the state, the shot cells are either covered by all fleets or by none
+// * returns the exact value if it is below "cutoff", otherwise a lower bound of at least "cutoff"
+// * "cell" receives the best shot of an exact value
+static float search(Solver *s, Bits128 shot, const int *fleets, int n, double weight, uint64_t key, int *top,
+                    float cutoff, int *cell)
+{
+    *cell = -1;
+
+    // the remaining ship cells are known
+    SolverShots shots;
+    if (!count_shots(s, shot, fleets, n, &shots))
+    {
+        if (!bits_empty(shots.all))
+            *cell = bits_first(shots.all);
+        return 0;
+    }
+
+    if (check_deadline(s))
+        return cutoff;
+
+    // probe the transposition table, a key collision could suggest a cell that is shot already
+    SolverEntry *e = &s->table[key & (s->entries - 1)];
+    if (e->key == key && (e->exact || e->value >= cutoff) && (e->cell < 0 || bits_test(shots.any, e->cell)))
+    {
+        s->stats.hits++;
+        *cell = e->cell;
+        return e->value;
+    }
+
+    // a cell that is a ship cell in all fleets is shot first,
+    // otherwise the candidates are ordered by ascending miss probability
+    int candidates = 0;
+    int candidate[bitboard_size * bitboard_size];
+
+    if (!bits_empty(shots.all))
+        candidate[candidates++] = bits_first(shots.all);
+    else
+        for (Bits128 cells = shots.any; !bits_empty(cells);)
+        {
+            int c = bits_pop(&cells);
+
+            int i = candidates;
+            while (i > 0 && shots.cover[candidate[i - 1]] < shots.cover[c])
+                i--;
+
+            // a cell that splits the fleets like a candidate with the same cover is skipped
+            bool same = false;
+            for (int j = i - 1; j >= 0 && shots.cover[candidate[j]] == shots.cover[c] && !same; j--)
+                same = shots.signature[candidate[j]] == shots.signature[c];
+            if (same)
+                continue;
+
+            for (int j = candidates++; j > i; j--)
+                candidate[j] = candidate[j - 1];
+            candidate[i] = c;
+        }
+
+    // each shot finds at most the fleets covering it, so the fleets that are found by the k-th shot
+    // of a series of misses bound the expected misses from below
+    double bound = 0;
+    double found = 0;
+    for (int i = 0; i < candidates && found < weight; i++)
+    {
+        double m = shots.cover[candidate[i]] < weight - found ? shots.cover[candidate[i]] : weight - found;
+        bound += i * m / weight;
+        found += m;
+    }
+
+    if (bound >= cutoff)
+        return (float)bound;
+
+    // the greedy policy gives a first bound, a shot needs to beat it
+    float best = cutoff;
+    if (candidates > 1)
+    {
+        int c;
+        float value = (float)greedy(s, shot, fleets, n, weight, top, &c);
+        if (value < best)
+        {
+            best = value;
+            *cell = c;
+        }
+    }
+
+    int *group = top;
+    int *next = top + n;
+
+    for (int i = 0; i < candidates && best > bound; i++)
+    {
+        int c = candidate[i];
+
+        // the miss probability bounds the expected misses of the shot from below
+        double acc = 1 - shots.cover[c] / weight;
+        if (acc >= best)
+            break;
+
+        int counts[3];
+        double weights[3];
+        uint64_t keys[3];
+        split(s, shot, fleets, n, c, group, counts, weights, keys);
+
+        const int *list = group;
+        bool abandoned = false;
+
+        for (int r = 0; r < 3 && !abandoned; r++)
+        {
+            if (counts[r] > 0)
+            {
+                double p = weights[r] / weight;
+
+                // a value at the cutoff is only a lower bound
+                int unused;
+                float limit = (float)((best - acc) / p);
+                Bits128 after = r < 2 ? bits_or(shot, bits_bit(c)) : shot;
+                float v = search(s, after, list, counts[r], weights[r], keys[r], next, limit, &unused);
+
+                acc += p * v;
+                if (v >= limit || acc >= best || s->timeout)
+                    abandoned = true;
+            }
+
+            list += counts[r];
+        }
+
+        if (s->timeout)
+            return cutoff;
+
+        if (!abandoned)
+        {
+            best = (float)acc;
+            *cell = c;
+        }
+    }
+
+    // store the state in the transposition table
+    e->key = key;
+    e->value = best;
+    e->cell = *cell;
+    e->exact = *cell >= 0;
+
+    return best;
+}
+
+// initialize a solver
+void solver_init(Solver *s, float budget, int memory, int max_fleets)
+{
+    s->gen = NULL;
+    s->budget = budget;
+    s->max_fleets = max_fleets;
+
+    s->entries = 1;
+    while (2 * s->entries * (long)sizeof(SolverEntry) <= (long)memory * 1024 * 1024)
+        s->entries *= 2;
+
+    s->table = new SolverEntry[s->entries];
+    solver_clear(s);
+
+    Random random;
+    rnd_seed(&random, 0x5A0B12157ULL);
+
+    for (int c = 0; c < bitboard_size * bitboard_size; c++)
+        s->zobrist_cell[c] = zobrist_key(&random);
+
+    s->stats.solved = 0;
+    s->stats.aborted = 0;
+    s->stats.approximated = 0;
+    s->stats.nodes = 0;
+    s->stats.hits = 0;
+    s->stats.expected = 0;
+}
+
+// release the transposition table of a solver
+void solver_free(Solver *s)
+{
+    delete[] s->table;
+    s->table = NULL;
+}
+
+// clear the transposition table
+void solver_clear(Solver *s)
+{
+    for (int i = 0; i < s->entries; i++)
+    {
+        s->table[i].key = 0;
+        s->table[i].value = 0;
+        s->table[i].cell = -1;
+        s->table[i].exact = false;
+    }
+}
+
+// choose the optimal next shot of an opponent
+bool solver_choose(Solver *s, const Ai *a, int *y, int *x)
+{
+    const FleetGen *g = a->gen;
+
+    // large boards are not indexed
+    if (!g->placements)
+        return false;
+
+    // the table is only valid for the fleet generator it was filled for
+    if (s->gen != g)
+    {
+        solver_clear(s);
+        s->gen = g;
+    }
+
+    int ships = 0;
+    int shipCells = 0;
+    for (int k = 0; k < g->lists; k++)
+    {
+        ships += a->remaining[k];
+        shipCells += a->remaining[k] * g->length[k];
+    }
+
+    if (ships == 0 || ships > solver_max_ships)
+        return false;
+
+    s->deadline = get_seconds() + s->budget / 1000;
+    s->timeout = false;
+
+    // the sunk ships change the prior of the remaining ships
+    find_sunk(s, a);
+
+    // enumerate the consistent fleets
+    s->ships = ships;
+    s->fleets = 0;
+    s->fleet_cells = new Bits128[s->max_fleets];
+    s->fleet_ship = new const Placement *[s->max_fleets * ships];
+    s->fleet_key = new uint64_t[s->max_fleets];
+    s->fleet_weight = new double[s->max_fleets];
+
+    int left[bitboard_size];
+    const Placement *placed[solver_max_ships];
+    int list[solver_max_ships];
+    for (int k = 0; k < g->lists; k++)
+        left[k] = a->remaining[k];
+
+    // a ship that consists of damaged cells only would have been reported sunk
+    PlacementSet available[bitboard_size];
+    for (int k = 0; k < g->lists; k++)
+    {
+        const PlacementList *l = &g->placements[k];
+
+        available[k] = a->valid[k];
+
+        Bits128 cells = a->hit_bits;
+        while (!bits_empty(cells))
+        {
+            int c = bits_pop(&cells);
+
+            for (int w = 0; w < placement_words; w++)
+                for (uint64_t bits = available[k].w[w] & l->cover[c].w[w]; bits; bits &= bits - 1)
+                {
+                    int p = (w << 6) + __builtin_ctzll(bits);
+                    if (bits_empty(bits_andnot(l->ref[p].mask->ship, a->hit_bits)))
+                        available[k].w[w] &= ~((uint64_t)1 << (p & 63));
+                }
+        }
+    }
+
+    bool enumerated = enumerate(s, a, left, 0, 0, available, bits128(), placed, list, 0);
+
+    int cell = -1;
+    float misses = 0;
+
+    if (enumerated && s->fleets > 0)
+    {
+        // each searched state needs n stack slots, a hit adds a shot cell and a miss drops a fleet,
+        // so the stack holds at most n slots per cell and n + (n - 1) + ... + 1 slots of misses
+        int n = s->fleets;
+        s->stack_size = n * (bitboard_size * bitboard_size + 1) + n * (n + 1) / 2;
+        s->stack = new int[s->stack_size];
+
+        uint64_t key = 0;
+        double weight = 0;
+        for (int i = 0; i < n; i++)
+        {
+            s->stack[i] = i;
+            key ^= s->fleet_key[i];
+            weight += s->fleet_weight[i];
+        }
+
+        misses = search(s, a->hit_bits, s->stack, n, weight, key, s->stack + n, no_cutoff, &cell);
+
+        delete[] s->stack;
+        s->stack = NULL;
+    }
+
+    delete[] s->fleet_cells;
+    delete[] s->fleet_ship;
+    delete[] s->fleet_key;
+    delete[] s->fleet_weight;
+    s->fleet_cells = NULL;
+    s->fleet_ship = NULL;
+    s->fleet_key = NULL;
+    s->fleet_weight = NULL;
+
+    if (cell < 0)
+    {
+        s->stats.aborted++;
+        return false;
+    }
+
+    // a search that exceeded the budget takes the best shot found so far
+    if (s->timeout)
+        s->stats.approximated++;
+    else
+    {
+        s->stats.solved++;
+        s->stats.expected = shipCells - bits_count(a->hit_bits) + misses;
+    }
+
+    *y = cell / bitboard_size;
+    *x = cell % bitboard_size;
+
+    return true;
+}
@@ -0,0 +1,103 @@
+// Sink Ships endgame solver
+// * plays the end of a game optimally once few ships remain, that is it minimizes
+//   the expected number of shots until all remaining ships are sunk
+// * all fleets of the remaining ships that are consistent with the observations of the
+//   opponent are enumerated, each of them is weighted by the probability that the
+//   fleet generator draws it together with the sunk ships, summed over the orders in which
+//   the generator may draw ships of the same size, up to solver_max_order ships of a size
+// * the shots are searched depth-first, a shot splits the fleets into the ones that
+//   report a miss, a hit or a sunk ship, each of which is an observation state of its own
+// * the number of shots on ships is fixed, so only the expected number of misses is minimized:
+//  * a cell that is a ship cell in all fleets is shot first, it cannot miss
+//  * the greedy policy, which shoots at the cell that is most likely a ship cell, gives a first upper bound
+//  * the shots are ordered by their miss probability, which bounds the expected misses
+//    of a shot from below, and a shot is abandoned once its bound exceeds the best shot
+//  * a series of misses that each find as many fleets as possible bounds a state from below
+//  * shots that split the fleets alike are searched once
+// * a move that exceeds the budget takes the best shot found so far, that is the greedy shot
+//   or a better one
+// * the fleets that are consistent with a state and the sunk ships determine its value, so the states
+//   are memoized in a transposition table that is keyed by the Zobrist hash of the set of fleets,
+//   states that are reached by different shot orders are solved once,
+//   and the table is kept between moves and games on the same arena
+// * only arenas within the bitboard size are solved
+
+#pragma once
+
+#include "ai.h"
+
+//! maximum number of remaining ships the solver enumerates fleets for
+const int solver_max_ships = 8;
+
+//! maximum number of ships of the same size whose draw orders are summed up by the prior of a fleet
+//! * the prior accumulates over the subsets of these ships, so it takes 2^n steps
+const int solver_max_order = 8;
+
+//! entry of the transposition table
+struct SolverEntry
+{
+    uint64_t key;      // the Zobrist hash of the fleets of the state, 0 for an empty entry
+    float value;       // the expected number of misses until all ships are sunk
+    signed char cell;  // the bit index of the best shot, -1 if unknown
+    bool exact;        // decides if the value is exact or a lower bound
+};
+
+//! solver statistics
+struct SolverStats
+{
+    long solved;       // the number of solved moves
+    long aborted;      // the number of moves that exceeded the fleet limit or the budget without a shot
+    long approximated; // the number of moves that exceeded the budget and took the best shot found so far
+    long nodes;        // the number of searched states
+    long hits;         // the number of states taken from the table
+    double expected;   // the expected number of remaining shots of the last solved move
+};
+
+//! endgame solver
+struct Solver
+{
+    const FleetGen *gen;  // the fleet generator the table was filled for
+    float budget;         // the wall-clock budget per move in milli seconds
+    int max_fleets;       // the maximum number of enumerated fleets
+    SolverEntry *table;   // the transposition table
+    int entries;          // the number of table entries, a power of two
+    SolverStats stats;    // the statistics
+
+    // Zobrist keys of the ship cells of a fleet
+    uint64_t zobrist_cell[bitboard_size * bitboard_size];
+
+    // search state of a move
+    int ships;                    // the number of remaining ships per fleet
+    int fleets;                   // the number of enumerated fleets
+    Bits128 *fleet_cells;         // the ship cells of each fleet
+    const Placement **fleet_ship; // the ships of each fleet
+    uint64_t *fleet_key;          // the Zobrist hash of each fleet
+    double *fleet_weight;         // the prior probability of each fleet, up to a common factor
+    int sunk;                     // the number of sunk ships
+    const Placement *sunk_ship[fleet_max_ships]; // the sunk ships
+    int sunk_list[fleet_max_ships];              // the placement list of each sunk ship
+    uint64_t sunk_key;                           // the Zobrist hash of the sunk ships
+    int *stack;                   // the fleet lists of the searched states
+    int stack_size;               // the capacity of the stack
+    double deadline;              // the wall-clock deadline of the move
+    bool timeout;                 // decides if the deadline has passed
+};
+
+//! initialize a solver
+//! * "budget" is the wall-clock budget per move in milli seconds
+//! * "memory" is the size of the transposition table in megabytes
+//! * "max_fleets" limits the number of enumerated fleets, more fleets are not solved
+void solver_init(Solver *s, float budget = 20, int memory = 16, int max_fleets = 1024);
+
+//! release the transposition table of a solver
+void solver_free(Solver *s);
+
+//! clear the transposition table
+void solver_clear(Solver *s);
+
+//! choose the optimal next shot of an opponent
+//! * returns the position (y, x) of the shot that minimizes the expected number of shots
+//! * returns false if the endgame is not reached yet, that is there are too many fleets,
+//!   if the board is too large to be indexed or if the budget is exceeded before a shot is found,
+//!   then the opponent chooses by itself
+bool solver_choose(Solver *s, const Ai *a, int *y, int *x);
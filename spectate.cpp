@@ -0,0 +1,249 @@
+// Sink Ships spectator streaming
+
+#include "spectate.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// helper for moving the cursor of a spectator to a frame
+// * a spectator that is not synced skips ahead to the next keyframe
+static void move_cursor(Spectator *s, SpectatorFrame *f)
+{
+    if (s->frame)
+        s->frame->refs--;
+
+    if (!s->synced)
+        while (f && !f->keyframe)
+            f = f->next;
+
+    if (f)
+    {
+        f->refs++;
+        s->synced = true;
+    }
+
+    s->frame = f;
+    s->offset = 0;
+}
+
+// helper for disconnecting a spectator
+static void close_spectator(SpectatorHub *hub, Spectator *s)
+{
+    if (s->frame)
+        s->frame->refs--;
+
+    Spectator **p = &hub->first;
+    while (*p != s)
+        p = &(*p)->next;
+    *p = s->next;
+
+    close(s->fd);
+    delete s;
+
+    hub->spectators--;
+}
+
+// helper for releasing the frames that are sent to all spectators
+static void release_frames(SpectatorHub *hub)
+{
+    while (hub->head && hub->head->refs == 0)
+    {
+        SpectatorFrame *f = hub->head;
+        hub->head = f->next;
+
+        delete[] f->data;
+        delete f;
+    }
+
+    if (!hub->head)
+        hub->tail = NULL;
+}
+
+// helper for accepting the pending spectators of the listening socket
+static void accept_spectators(SpectatorHub *hub)
+{
+    for (;;)
+    {
+        int fd = accept4(hub->listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+            break;
+
+        Spectator *s = new Spectator;
+        s->fd = fd;
+        s->frame = NULL;
+        s->offset = 0;
+        s->synced = false;
+        s->next = hub->first;
+
+        hub->first = s;
+        hub->spectators++;
+
+        // the new spectator starts with the next keyframe
+        hub->keyframe = true;
+    }
+}
+
+// helper for sending the pending frames of a spectator
+// * returns false if the connection is broken
+static bool send_frames(SpectatorHub *hub, Spectator *s)
+{
+    while (s->frame)
+    {
+        SpectatorFrame *f = s->frame;
+
+        ssize_t sent = send(s->fd, f->data + s->offset, f->bytes - s->offset, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent < 0)
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+        hub->stats.sent += sent;
+        s->offset += sent;
+
+        if (s->offset == f->bytes)
+            move_cursor(s, f->next);
+    }
+
+    return true;
+}
+
+// start a spectator hub listening on a Unix domain socket
+bool spectate_start(SpectatorHub *hub, const char *path)
+{
+    struct sockaddr_un addr;
+
+    if (strlen(path) >= sizeof(addr.sun_path) || strlen(path) >= sizeof(hub->path))
+        return false;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    strcpy(hub->path, path);
+
+    hub->listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (hub->listener < 0)
+        return false;
+
+    unlink(path);
+
+    if (bind(hub->listener, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(hub->listener, SOMAXCONN) < 0)
+    {
+        close(hub->listener);
+        return false;
+    }
+
+    hub->first = NULL;
+    hub->spectators = 0;
+    hub->head = hub->tail = NULL;
+    hub->keyframe = true;
+    delta_init(&hub->delta);
+    hub->stats.frames = 0;
+    hub->stats.encoded = 0;
+    hub->stats.sent = 0;
+
+    return true;
+}
+
+// begin a frame
+bool spectate_begin_frame(SpectatorHub *hub, int lines, int cols)
+{
+    spectate_flush(hub);
+
+    if (hub->spectators == 0)
+        return false;
+
+    delta_begin(&hub->delta, lines, cols, hub->keyframe);
+
+    return true;
+}
+
+// end a watched frame and send it to all spectators
+void spectate_end_frame(SpectatorHub *hub)
+{
+    FrameDelta *d = &hub->delta;
+
+    int bytes = delta_end(d);
+    bool keyframe = d->data[d->start + 4] & DELTA_KEYFRAME;
+
+    // frames without changes are not sent
+    if (d->runs == 0 && !keyframe)
+    {
+        delta_clear(d);
+        return;
+    }
+
+    // the encoded frame is copied once and shared by all spectators
+    SpectatorFrame *f = new SpectatorFrame;
+    f->data = new unsigned char[bytes];
+    memcpy(f->data, d->data + d->start, bytes);
+    f->bytes = bytes;
+    f->sequence = hub->stats.frames++;
+    f->keyframe = keyframe;
+    f->refs = 0;
+    f->next = NULL;
+
+    delta_clear(d);
+
+    if (hub->tail)
+        hub->tail->next = f;
+    else
+        hub->head = f;
+    hub->tail = f;
+
+    hub->stats.encoded += bytes;
+
+    if (keyframe)
+        hub->keyframe = false;
+
+    for (Spectator *s = hub->first; s; s = s->next)
+    {
+        if (!s->frame)
+            move_cursor(s, f);
+        else if (f->sequence - s->frame->sequence > spectate_max_lag)
+        {
+            // a spectator that has fallen behind skips ahead to the next keyframe,
+            // a partially sent frame is completed first to keep the stream intact
+            s->synced = false;
+            if (s->offset == 0)
+                move_cursor(s, s->frame);
+
+            hub->keyframe = true;
+        }
+    }
+
+    spectate_flush(hub);
+}
+
+// send pending frames without blocking
+void spectate_flush(SpectatorHub *hub)
+{
+    accept_spectators(hub);
+
+    Spectator *s = hub->first;
+    while (s)
+    {
+        Spectator *next = s->next;
+
+        if (!send_frames(hub, s))
+            close_spectator(hub, s);
+
+        s = next;
+    }
+
+    release_frames(hub);
+}
+
+// stop a spectator hub and disconnect all spectators
+void spectate_stop(SpectatorHub *hub)
+{
+    while (hub->first)
+        close_spectator(hub, hub->first);
+
+    release_frames(hub);
+    delta_free(&hub->delta);
+
+    close(hub->listener);
+    unlink(hub->path);
+}
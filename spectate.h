@@ -0,0 +1,82 @@
+// Sink Ships spectator streaming
+// * streams the drawn frames of a running game to any number of spectators
+//   that are connected to a Unix domain socket
+// * the changed cells of each frame are encoded once as frame delta (see framedelta.h)
+//   and the encoded frame is shared by all spectators, so the encoding cost does not
+//   depend on the number of spectators
+// * a spectator starts with the next keyframe, which contains all visible cells,
+//   a spectator that falls behind by too many frames skips ahead to the next keyframe
+// * the sockets are written without blocking, so a slow spectator never stalls the game
+
+#pragma once
+
+#include "framedelta.h"
+
+//! path of the default spectator socket
+const char *const spectate_default_socket = "sinkships.watch";
+
+//! maximum number of frames a spectator may fall behind before it skips to the next keyframe
+const int spectate_max_lag = 64;
+
+//! encoded frame shared by all spectators
+struct SpectatorFrame
+{
+    unsigned char *data;  // the encoded frame
+    int bytes;            // the number of bytes of the frame
+    long sequence;        // the number of the frame
+    bool keyframe;        // decides if the frame contains all visible cells
+    int refs;             // the number of spectators that send the frame
+    SpectatorFrame *next; // the next frame
+};
+
+//! connected spectator
+struct Spectator
+{
+    int fd;                // the socket of the spectator
+    SpectatorFrame *frame; // the frame that is sent, NULL if all frames are sent
+    int offset;            // the number of bytes of the frame that are sent
+    bool synced;           // decides if the spectator has received a keyframe since it fell behind
+    Spectator *next;       // the next spectator
+};
+
+//! spectator statistics
+struct SpectatorStats
+{
+    long frames;  // the number of published frames
+    long encoded; // the number of encoded bytes
+    long sent;    // the number of bytes sent to all spectators
+};
+
+//! spectator hub of a game
+struct SpectatorHub
+{
+    int listener;          // the listening socket
+    char path[108];        // the path of the listening socket
+    Spectator *first;      // the connected spectators
+    int spectators;        // the number of connected spectators
+    SpectatorFrame *head;  // the oldest frame that is still sent
+    SpectatorFrame *tail;  // the newest frame
+    bool keyframe;         // decides if the frame that is drawn next must be a keyframe
+    FrameDelta delta;      // the encoder of the frame that is drawn
+    SpectatorStats stats;  // the statistics
+};
+
+//! start a spectator hub listening on a Unix domain socket
+//! * returns false if the socket cannot be created
+bool spectate_start(SpectatorHub *hub, const char *path);
+
+//! begin a frame
+//! * accepts new spectators and sends pending frames
+//! * returns true if the frame is watched, then the changed cells are recorded into the frame delta
+//!   of the hub and all visible cells need to be recorded if "keyframe" is set
+//! * "lines" and "cols" is the size of the screen the cells are recorded from
+bool spectate_begin_frame(SpectatorHub *hub, int lines, int cols);
+
+//! end a watched frame and send it to all spectators
+void spectate_end_frame(SpectatorHub *hub);
+
+//! send pending frames without blocking
+void spectate_flush(SpectatorHub *hub);
+
+//! stop a spectator hub and disconnect all spectators
+void spectate_stop(SpectatorHub *hub);
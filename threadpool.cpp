@@ -0,0 +1,249 @@
+// Sink Ships thread pool
+
+#include "threadpool.h"
+
+#include <stddef.h>
+#include <unistd.h>
+
+// initial size of a task queue
+static const int queue_capacity = 64;
+
+// helper for pushing a task to the bottom of a queue
+static void push(TaskQueue *q, Task t)
+{
+    pthread_mutex_lock(&q->mutex);
+
+    // grow the ring buffer
+    if (q->bottom - q->top == q->capacity)
+    {
+        Task *task = new Task[2 * q->capacity];
+        for (int i = q->top; i < q->bottom; i++)
+            task[i & (2 * q->capacity - 1)] = q->task[i & (q->capacity - 1)];
+
+        delete[] q->task;
+        q->task = task;
+        q->capacity *= 2;
+    }
+
+    q->task[q->bottom++ & (q->capacity - 1)] = t;
+
+    pthread_mutex_unlock(&q->mutex);
+}
+
+// helper for popping the newest task from the bottom of a queue
+static bool pop(TaskQueue *q, Task *t)
+{
+    bool found = false;
+
+    pthread_mutex_lock(&q->mutex);
+
+    if (q->bottom > q->top)
+    {
+        *t = q->task[--q->bottom & (q->capacity - 1)];
+        found = true;
+    }
+
+    pthread_mutex_unlock(&q->mutex);
+
+    return found;
+}
+
+// helper for stealing the oldest task from the top of a queue
+static bool steal(TaskQueue *q, Task *t)
+{
+    bool found = false;
+
+    // do not contend for a lock that is held by the owner or another thief
+    if (pthread_mutex_trylock(&q->mutex) != 0)
+        return false;
+
+    if (q->bottom > q->top)
+    {
+        *t = q->task[q->top++ & (q->capacity - 1)];
+        found = true;
+    }
+
+    pthread_mutex_unlock(&q->mutex);
+
+    return found;
+}
+
+// helper for queueing a task at a specific worker
+static void enqueue(ThreadPool *pool, int worker, TaskFunc func, void *data)
+{
+    Task t = {func, data};
+
+    // the counter is incremented before the push, as a worker may take the task and decrement
+    // the counter right away, so it never falls below the number of queued tasks
+    __sync_add_and_fetch(&pool->pending, 1);
+    __sync_add_and_fetch(&pool->queued, 1);
+    push(&pool->queue[worker], t);
+
+    // the workers decrement the counter without the lock,
+    // the lock only keeps a sleeping worker from missing the signal
+    pthread_mutex_lock(&pool->mutex);
+    pthread_cond_signal(&pool->work);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+// helper for finding a task, first in the own queue, then in the other queues
+static bool find_task(ThreadPool *pool, int worker, Task *t)
+{
+    if (pop(&pool->queue[worker], t))
+        return true;
+
+    for (int i = 1; i < pool->threads; i++)
+        if (steal(&pool->queue[(worker + i) % pool->threads], t))
+            return true;
+
+    return false;
+}
+
+// worker thread argument
+struct WorkerArg
+{
+    ThreadPool *pool;
+    int worker;
+};
+
+// worker thread main loop
+static void *worker_main(void *arg)
+{
+    ThreadPool *pool = ((WorkerArg *)arg)->pool;
+    int worker = ((WorkerArg *)arg)->worker;
+    delete (WorkerArg *)arg;
+
+    while (true)
+    {
+        Task t;
+
+        if (find_task(pool, worker, &t))
+        {
+            __sync_sub_and_fetch(&pool->queued, 1);
+
+            t.func(pool, worker, t.data);
+
+            if (__sync_sub_and_fetch(&pool->pending, 1) == 0)
+            {
+                pthread_mutex_lock(&pool->mutex);
+                pthread_cond_broadcast(&pool->done);
+                pthread_mutex_unlock(&pool->mutex);
+            }
+        }
+        else
+        {
+            // sleep until tasks are queued
+            pthread_mutex_lock(&pool->mutex);
+            while (pool->queued == 0 && !pool->quit)
+                pthread_cond_wait(&pool->work, &pool->mutex);
+            bool quit = pool->quit && pool->queued == 0;
+            pthread_mutex_unlock(&pool->mutex);
+
+            if (quit)
+                break;
+        }
+    }
+
+    return NULL;
+}
+
+// create a thread pool
+ThreadPool *pool_create(int threads)
+{
+    if (threads < 1)
+        threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1)
+        threads = 1;
+
+    ThreadPool *pool = new ThreadPool;
+
+    pool->threads = threads;
+    pool->thread = new pthread_t[threads];
+    pool->queue = new TaskQueue[threads];
+
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    pool->queued = 0;
+    pool->pending = 0;
+    pool->next = 0;
+    pool->quit = false;
+
+    for (int i = 0; i < threads; i++)
+    {
+        TaskQueue *q = &pool->queue[i];
+        pthread_mutex_init(&q->mutex, NULL);
+        q->task = new Task[queue_capacity];
+        q->capacity = queue_capacity;
+        q->top = q->bottom = 0;
+    }
+
+    for (int i = 0; i < threads; i++)
+    {
+        WorkerArg *arg = new WorkerArg;
+        arg->pool = pool;
+        arg->worker = i;
+        pthread_create(&pool->thread[i], NULL, worker_main, arg);
+    }
+
+    return pool;
+}
+
+// get the number of worker threads
+int pool_threads(const ThreadPool *pool)
+{
+    return pool->threads;
+}
+
+// submit a task from outside of the pool
+void pool_submit(ThreadPool *pool, TaskFunc func, void *data)
+{
+    // several threads may submit tasks concurrently
+    int worker = (unsigned int)__sync_fetch_and_add(&pool->next, 1) % pool->threads;
+
+    enqueue(pool, worker, func, data);
+}
+
+// spawn a task from inside of a task
+void pool_spawn(ThreadPool *pool, int worker, TaskFunc func, void *data)
+{
+    enqueue(pool, worker, func, data);
+}
+
+// wait until all submitted and spawned tasks are done
+void pool_wait(ThreadPool *pool)
+{
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->pending > 0)
+        pthread_cond_wait(&pool->done, &pool->mutex);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+// destroy a thread pool
+void pool_destroy(ThreadPool *pool)
+{
+    pool_wait(pool);
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (int i = 0; i < pool->threads; i++)
+        pthread_join(pool->thread[i], NULL);
+
+    for (int i = 0; i < pool->threads; i++)
+    {
+        pthread_mutex_destroy(&pool->queue[i].mutex);
+        delete[] pool->queue[i].task;
+    }
+
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->work);
+    pthread_mutex_destroy(&pool->mutex);
+
+    delete[] pool->queue;
+    delete[] pool->thread;
+    delete pool;
+}
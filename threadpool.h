@@ -0,0 +1,70 @@
+// Sink Ships thread pool
+// * work-stealing thread pool based on POSIX threads
+// * each worker owns a task queue, it executes its own tasks in LIFO order
+//   and steals tasks from the other workers in FIFO order when it runs dry
+
+#pragma once
+
+#include <pthread.h>
+
+struct ThreadPool;
+
+//! task function
+//! * "worker" is the index of the executing worker thread
+//! * "data" is the user data of the task
+typedef void (*TaskFunc)(ThreadPool *pool, int worker, void *data);
+
+//! task type
+struct Task
+{
+    TaskFunc func;
+    void *data;
+};
+
+//! task queue of a worker
+struct TaskQueue
+{
+    pthread_mutex_t mutex; // the queue lock
+    Task *task;            // the ring buffer of tasks
+    int capacity;          // the size of the ring buffer (a power of two)
+    int top;               // the oldest task (stolen by other workers)
+    int bottom;            // one after the newest task (popped by the owner)
+};
+
+//! thread pool type
+struct ThreadPool
+{
+    int threads;           // the number of worker threads
+    pthread_t *thread;     // the worker threads
+    TaskQueue *queue;      // the task queues of the workers
+    pthread_mutex_t mutex; // the lock for sleeping and waiting
+    pthread_cond_t work;   // signaled when tasks are queued
+    pthread_cond_t done;   // signaled when all tasks are done
+    int queued;            // the number of queued tasks, briefly more while a task is pushed
+    int pending;           // the number of queued or running tasks
+    int next;              // the number of submitted tasks, selects the next queue
+    bool quit;             // the workers are asked to exit
+};
+
+//! create a thread pool
+//! * by default one worker is created per available processor core
+ThreadPool *pool_create(int threads = 0);
+
+//! get the number of worker threads
+int pool_threads(const ThreadPool *pool);
+
+//! submit a task from outside of the pool
+//! * tasks are distributed round-robin over the workers
+//! * may be called by several threads concurrently
+void pool_submit(ThreadPool *pool, TaskFunc func, void *data);
+
+//! spawn a task from inside of a task
+//! * the task is queued at the executing worker, idle workers may steal it
+void pool_spawn(ThreadPool *pool, int worker, TaskFunc func, void *data);
+
+//! wait until all submitted and spawned tasks are done
+void pool_wait(ThreadPool *pool);
+
+//! destroy a thread pool
+//! * waits for all tasks to be done
+void pool_destroy(ThreadPool *pool);
@@ -0,0 +1,84 @@
+// Sink Ships timeline
+
+#include "timeline.h"
+
+#include <time.h>
+
+// helper for getting the wall-clock time in seconds
+static double get_seconds()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1E-9;
+}
+
+// initialize an empty timeline
+void timeline_init(Timeline *t, float scale)
+{
+    t->scale = scale;
+    t->events = 0;
+}
+
+// schedule an event after a delay in milli seconds
+bool timeline_schedule(Timeline *t, float delay, TimelineFunc func, void *data)
+{
+    if (t->events == timeline_max_events)
+        return false;
+
+    TimelineEvent e = {get_seconds() + delay * t->scale / 1000, func, data};
+
+    // insert behind all events that are due earlier or at the same time
+    int i = t->events++;
+    while (i > 0 && t->event[i - 1].time > e.time)
+    {
+        t->event[i] = t->event[i - 1];
+        i--;
+    }
+
+    t->event[i] = e;
+
+    return true;
+}
+
+// check if events are pending
+bool timeline_pending(const Timeline *t)
+{
+    return t->events > 0;
+}
+
+// get the time until the next event is due in milli seconds
+float timeline_timeout(const Timeline *t)
+{
+    if (t->events == 0)
+        return -1;
+
+    double timeout = (t->event[0].time - get_seconds()) * 1000;
+
+    return timeout > 0 ? timeout : 0;
+}
+
+// run all events that are due
+int timeline_run(Timeline *t)
+{
+    int count = 0;
+
+    while (t->events > 0 && t->event[0].time <= get_seconds())
+    {
+        TimelineEvent e = t->event[0];
+
+        t->events--;
+        for (int i = 0; i < t->events; i++)
+            t->event[i] = t->event[i + 1];
+
+        e.func(e.data);
+        count++;
+    }
+
+    return count;
+}
+
+// remove all pending events
+void timeline_clear(Timeline *t)
+{
+    t->events = 0;
+}
@@ -0,0 +1,56 @@
+// Sink Ships timeline
+// * sequences delayed effects like sounds and redraws as timed events
+// * the main loop waits for input until the next event is due and then runs it,
+//   so that input stays responsive while an effect is playing
+// * a time scale of zero runs all events without delay (fast mode)
+
+#pragma once
+
+#include <stddef.h>
+
+//! maximum number of pending events
+const int timeline_max_events = 64;
+
+//! timed event function
+//! * "data" is the user data of the event
+typedef void (*TimelineFunc)(void *data);
+
+//! timed event
+struct TimelineEvent
+{
+    double time;       // the due wall-clock time in seconds
+    TimelineFunc func; // the event function
+    void *data;        // the user data passed to the event function
+};
+
+//! timeline state
+struct Timeline
+{
+    float scale;                              // the time scale of all delays
+    int events;                               // the number of pending events
+    TimelineEvent event[timeline_max_events]; // the pending events ordered by due time
+};
+
+//! initialize an empty timeline
+//! * "scale" multiplies all delays, zero runs all events without delay
+void timeline_init(Timeline *t, float scale = 1);
+
+//! schedule an event after a delay in milli seconds
+//! * events with the same due time run in the order they were scheduled
+//! * returns false if too many events are pending
+bool timeline_schedule(Timeline *t, float delay, TimelineFunc func, void *data = NULL);
+
+//! check if events are pending
+bool timeline_pending(const Timeline *t);
+
+//! get the time until the next event is due in milli seconds
+//! * returns -1 if no events are pending, so that it can be passed to wait_keycode()
+float timeline_timeout(const Timeline *t);
+
+//! run all events that are due
+//! * events that are scheduled by a running event run as well if they are due
+//! * returns the number of events that have been run
+int timeline_run(Timeline *t);
+
+//! remove all pending events
+void timeline_clear(Timeline *t);